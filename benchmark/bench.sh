@@ -0,0 +1,216 @@
+#!/bin/sh
+#
+# Benchmark suite for the hashset extension.
+#
+# Generates the data locally (bench/setup.sql), runs each case with pgbench
+# and writes the results as JSON - throughput, latency percentiles and peak
+# memory of the backend. With a baseline (a JSON file from an earlier run),
+# the results are compared and the script fails if any case got slower by
+# more than the threshold.
+#
+# The connection is set with the usual PGHOST, PGPORT, PGDATABASE, ...
+# variables. The peak memory and the binary input cases read files on the
+# server (/proc/self/status, the COPY input), so they need a local server
+# and a superuser, otherwise they are reported as null / failed.
+#
+# Usage: bench.sh [options]
+#
+#   --quick             smaller sizes and graph, shorter runs
+#   --duration SECS     duration of each case (default 5, 2 with --quick)
+#   --clients N         number of pgbench clients (default 1)
+#   --filter REGEX      run only the cases with matching names
+#   --skip-setup        reuse the data from the previous run
+#   --output FILE       results (default results/<timestamp>.json)
+#   --baseline FILE     compare with this run (default results/baseline.json)
+#   --threshold PCT     allowed drop of ops/s (default 10)
+#   --save-baseline     store the results as results/baseline.json
+
+set -e
+
+cd "$(dirname "$0")"
+
+SIZES="1000 100000 1000000"
+GRAPH_NODES=1000000
+DURATION=
+CLIENTS=1
+FILTER=
+SETUP=1
+OUTPUT=
+BASELINE=
+THRESHOLD=10
+SAVE_BASELINE=0
+QUICK=false
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --quick) QUICK=true; SIZES="1000 100000"; GRAPH_NODES=100000 ;;
+        --duration) DURATION="$2"; shift ;;
+        --clients) CLIENTS="$2"; shift ;;
+        --filter) FILTER="$2"; shift ;;
+        --skip-setup) SETUP=0 ;;
+        --output) OUTPUT="$2"; shift ;;
+        --baseline) BASELINE="$2"; shift ;;
+        --threshold) THRESHOLD="$2"; shift ;;
+        --save-baseline) SAVE_BASELINE=1 ;;
+        *) echo "unknown option: $1" >&2; exit 2 ;;
+    esac
+    shift
+done
+
+if [ -z "$DURATION" ]; then
+    if [ "$QUICK" = true ]; then DURATION=2; else DURATION=5; fi
+fi
+
+mkdir -p results
+STARTED=$(date -u +%Y-%m-%dT%H:%M:%SZ)
+[ -n "$OUTPUT" ] || OUTPUT="results/$(date -u +%Y%m%d-%H%M%S).json"
+[ -n "$BASELINE" ] || [ ! -f results/baseline.json ] || BASELINE=results/baseline.json
+
+# the server reads the binary COPY input from here
+TMPDIR=$(mktemp -d)
+chmod 755 "$TMPDIR"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+PSQL="psql -X -q -v ON_ERROR_STOP=1"
+
+if [ $SETUP = 1 ]; then
+    echo "generating data (sizes: $SIZES, graph: $GRAPH_NODES nodes)"
+    $PSQL -v sizes="{$(echo $SIZES | tr ' ' ',')}" -v graph_nodes=$GRAPH_NODES \
+        -f bench/setup.sql > /dev/null
+fi
+
+# selected NAME - is the case selected by --filter?
+selected() {
+    [ -z "$FILTER" ] || echo "$1" | grep -Eq "$FILTER"
+}
+
+# run_case NAME OPS_PER_TXN SCRIPT [@VAR@=VALUE ...]
+#
+# Runs the script with pgbench, and once more in a new session to get the
+# peak memory (VmHWM) of the backend. Appends the result to results.json.
+run_case() {
+    name=$1
+    ops=$2
+    template=$3
+    shift 3
+
+    selected "$name" || return 0
+
+    script="$TMPDIR/case.sql"
+    cp "bench/ops/$template.sql" "$script"
+    for var in "$@"; do
+        sed -i.bak "s|${var%%=*}|${var#*=}|g" "$script"
+    done
+
+    rm -f "$TMPDIR"/log.*
+    if pgbench -n -T "$DURATION" -c "$CLIENTS" -j "$CLIENTS" -f "$script" \
+            -l --log-prefix="$TMPDIR/log" > "$TMPDIR/pgbench.out" 2>&1; then
+        tps=$(sed -n 's/^tps = \([0-9.]*\).*/\1/p' "$TMPDIR/pgbench.out" | tail -n 1)
+    else
+        tps=
+    fi
+
+    if [ -z "$tps" ]; then
+        echo "$name: failed"
+        sed 's/^/    /' "$TMPDIR/pgbench.out"
+        printf '    {"name": "%s", "failed": true}' "$name" >> "$TMPDIR/results"
+        printf ',\n' >> "$TMPDIR/results"
+        return
+    fi
+
+    # latency in microseconds is the third field of the transaction log
+    latency=$(cat "$TMPDIR"/log.* | awk '{ print $3 }' | sort -n | awk '
+        { v[NR] = $1; sum += $1 }
+        END {
+            if (NR == 0) { print "null null null null null"; exit }
+            p50 = int(NR * 0.50 + 0.999); p95 = int(NR * 0.95 + 0.999); p99 = int(NR * 0.99 + 0.999)
+            printf "%.3f %.3f %.3f %.3f %.3f\n", sum / NR / 1000, v[p50] / 1000, v[p95] / 1000, v[p99] / 1000, v[NR] / 1000
+        }')
+    set -- $latency
+
+    rss=$($PSQL -At -f "$script" \
+            -c "SELECT 'peak_rss_kb=' || (regexp_match(pg_read_file('/proc/self/status'), 'VmHWM:\s+(\d+)'))[1]" \
+            2> /dev/null | sed -n 's/^peak_rss_kb=//p')
+    [ -n "$rss" ] || rss=null
+
+    opsps=$(echo "$tps $ops" | awk '{ printf "%.1f", $1 * $2 }')
+
+    printf '%-50s %14s ops/s  p50 %10s ms  p99 %10s ms  rss %s kB\n' "$name" "$opsps" "$2" "$4" "$rss"
+
+    printf '    {"name": "%s", "tps": %s, "ops_per_txn": %s, "ops_per_sec": %s, "latency_ms": {"avg": %s, "p50": %s, "p95": %s, "p99": %s, "max": %s}, "peak_rss_kb": %s}' \
+        "$name" "$tps" "$ops" "$opsps" "$1" "$2" "$3" "$4" "$5" "$rss" >> "$TMPDIR/results"
+    printf ',\n' >> "$TMPDIR/results"
+}
+
+: > "$TMPDIR/results"
+
+# The operations sensitive to the hash table layout run with each hash
+# function and load factor, the rest with the default parameters only.
+$PSQL -At -F ' ' -c "SELECT id, dist, size, hashfn_id, load_factor FROM hashset_bench.sets ORDER BY id" \
+    > "$TMPDIR/sets"
+
+while read -r id dist size hashfn lf; do
+    values="hashset_bench.values_${dist}_${size}"
+    probes=$size
+    [ "$probes" -le 10000 ] || probes=10000
+    case_name="$dist/$size/hashfn$hashfn/lf$lf"
+    vars="@ID@=$id @VALUES@=$values @HASHFN_ID@=$hashfn @LOAD_FACTOR@=$lf"
+
+    run_case "add/$case_name" $size add $vars
+    run_case "contains/$case_name" $probes contains $vars
+    run_case "agg_serial/$case_name" $size agg_serial $vars
+
+    if [ "$hashfn" != 1 ] || [ "$lf" != 0.75 ]; then
+        continue
+    fi
+
+    run_case "agg_parallel/$case_name" $size agg_parallel $vars
+    run_case "union/$case_name" $((2 * size)) union $vars
+    run_case "intersection/$case_name" $((2 * size)) intersection $vars
+    run_case "text_out/$case_name" $size text_out $vars
+    run_case "text_in/$case_name" $size text_in $vars
+    run_case "binary_out/$case_name" $size binary_out $vars
+
+    file="$TMPDIR/set_$id.bin"
+    if selected "binary_in/$case_name"; then
+        $PSQL -c "\\copy (SELECT s FROM hashset_bench.sets WHERE id = $id) TO '$file' (FORMAT binary)" &&
+            chmod 644 "$file" || true
+    fi
+    run_case "binary_in/$case_name" $size binary_in $vars "@FILE@=$file"
+done < "$TMPDIR/sets"
+
+run_case "graph_agg/$GRAPH_NODES" 1 graph_agg
+run_case "graph_frontier/$GRAPH_NODES" 1 graph_frontier
+
+{
+    printf '{\n'
+    printf '  "started_at": "%s",\n' "$STARTED"
+    printf '  "server_version": "%s",\n' "$($PSQL -At -c 'SHOW server_version')"
+    printf '  "hashset_version": "%s",\n' "$($PSQL -At -c "SELECT extversion FROM pg_extension WHERE extname = 'hashset'")"
+    printf '  "git_commit": "%s",\n' "$(git rev-parse --short HEAD 2> /dev/null || true)"
+    printf '  "quick": %s,\n' "$QUICK"
+    printf '  "duration": %s,\n' "$DURATION"
+    printf '  "clients": %s,\n' "$CLIENTS"
+    printf '  "results": [\n'
+    sed '$ s/,$//' "$TMPDIR/results"
+    printf '  ]\n'
+    printf '}\n'
+} > "$OUTPUT"
+
+echo "results written to $OUTPUT"
+
+if [ $SAVE_BASELINE = 1 ]; then
+    cp "$OUTPUT" results/baseline.json
+    echo "results saved as the baseline"
+fi
+
+if [ -n "$BASELINE" ] && [ "$BASELINE" != "$OUTPUT" ] && [ $SAVE_BASELINE = 0 ]; then
+    echo "comparing with $BASELINE"
+    $PSQL -v baseline="$(cat "$BASELINE")" -v current="$(cat "$OUTPUT")" \
+        -v threshold="$THRESHOLD" -f bench/compare.sql | tee "$TMPDIR/compare.out"
+
+    if grep -q REGRESSION "$TMPDIR/compare.out"; then
+        echo "regressions found (threshold $THRESHOLD%)"
+        exit 1
+    fi
+fi
@@ -0,0 +1,49 @@
+-- Compare the results of two benchmark runs (see bench.sh).
+--
+--   psql -v baseline="$(cat baseline.json)" -v current="$(cat current.json)" \
+--        -v threshold=10 -f compare.sql
+--
+-- A case is a regression when its throughput dropped by more than threshold
+-- percent, or when it failed in the current run.
+
+\pset footer off
+
+WITH baseline AS (
+    SELECT r->>'name' AS name,
+           (r->>'ops_per_sec')::float8 AS ops,
+           (r->'latency_ms'->>'p95')::float8 AS p95,
+           (r->>'peak_rss_kb')::bigint AS rss
+      FROM jsonb_array_elements(:'baseline'::jsonb->'results') r
+),
+current AS (
+    SELECT r->>'name' AS name,
+           (r->>'ops_per_sec')::float8 AS ops,
+           (r->'latency_ms'->>'p95')::float8 AS p95,
+           (r->>'peak_rss_kb')::bigint AS rss,
+           coalesce((r->>'failed')::bool, false) AS failed
+      FROM jsonb_array_elements(:'current'::jsonb->'results') r
+),
+changes AS (
+    SELECT coalesce(c.name, b.name) AS name,
+           b.ops AS baseline_ops,
+           c.ops AS current_ops,
+           round((100 * (c.ops - b.ops) / nullif(b.ops, 0))::numeric, 1) AS ops_change,
+           round((100 * (c.p95 - b.p95) / nullif(b.p95, 0))::numeric, 1) AS p95_change,
+           c.rss - b.rss AS rss_change_kb,
+           c.failed
+      FROM baseline b FULL JOIN current c ON b.name = c.name
+)
+SELECT name,
+       round(baseline_ops::numeric, 1) AS "baseline ops/s",
+       round(current_ops::numeric, 1) AS "current ops/s",
+       ops_change AS "ops/s %",
+       p95_change AS "p95 latency %",
+       rss_change_kb AS "peak rss kB",
+       CASE WHEN failed THEN 'REGRESSION (failed)'
+            WHEN current_ops IS NULL THEN 'missing'
+            WHEN baseline_ops IS NULL THEN 'new'
+            WHEN ops_change < - :threshold THEN 'REGRESSION'
+            WHEN ops_change > :threshold THEN 'faster'
+            ELSE 'ok' END AS status
+  FROM changes
+ ORDER BY name;
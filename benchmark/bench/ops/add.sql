@@ -0,0 +1 @@
+SELECT hashset_bench.add_all('@VALUES@', @LOAD_FACTOR@, @HASHFN_ID@);
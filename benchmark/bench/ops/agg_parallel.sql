@@ -0,0 +1,5 @@
+SET max_parallel_workers_per_gather = 4;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SELECT hashset_cardinality(hashset_agg(v, NULL, @LOAD_FACTOR@, @HASHFN_ID@)) FROM @VALUES@;
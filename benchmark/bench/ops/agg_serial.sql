@@ -0,0 +1,2 @@
+SET max_parallel_workers_per_gather = 0;
+SELECT hashset_cardinality(hashset_agg(v, NULL, @LOAD_FACTOR@, @HASHFN_ID@)) FROM @VALUES@;
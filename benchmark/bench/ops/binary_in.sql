@@ -0,0 +1,3 @@
+BEGIN;
+COPY hashset_bench.sink FROM '@FILE@' (FORMAT binary);
+ROLLBACK;
@@ -0,0 +1 @@
+SELECT length(int4hashset_send(s)) FROM hashset_bench.sets WHERE id = @ID@;
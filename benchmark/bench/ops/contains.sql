@@ -0,0 +1 @@
+SELECT cardinality(hashset_filter(probes, s)) FROM hashset_bench.sets WHERE id = @ID@;
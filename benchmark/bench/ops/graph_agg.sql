@@ -0,0 +1,30 @@
+-- friends of friends of friends, aggregating whole levels
+WITH RECURSIVE friends_of_friends AS
+(
+    SELECT
+        '{1}'::int4hashset AS current,
+        0 AS depth
+    UNION ALL
+    SELECT
+        new_current,
+        friends_of_friends.depth + 1
+    FROM
+        friends_of_friends
+    CROSS JOIN LATERAL
+    (
+        SELECT
+            hashset_agg(edges.to_node) AS new_current
+        FROM
+            hashset_elements(friends_of_friends.current) AS f(node)
+        JOIN
+            hashset_bench.edges AS edges ON edges.from_node = f.node
+    ) q
+    WHERE
+        friends_of_friends.depth < 3
+)
+SELECT
+    hashset_cardinality(current)
+FROM
+    friends_of_friends
+WHERE
+    depth = 3;
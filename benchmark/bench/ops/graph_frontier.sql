@@ -0,0 +1,32 @@
+-- nodes first reached at depth 3, skipping the visited ones while aggregating
+WITH RECURSIVE friends_of_friends AS
+(
+    SELECT
+        '{1}'::int4hashset AS current,
+        '{1}'::int4hashset AS visited,
+        0 AS depth
+    UNION ALL
+    SELECT
+        (q.f).frontier,
+        (q.f).visited,
+        friends_of_friends.depth + 1
+    FROM
+        friends_of_friends
+    CROSS JOIN LATERAL
+    (
+        SELECT
+            hashset_agg_frontier(edges.to_node, friends_of_friends.visited) AS f
+        FROM
+            hashset_elements(friends_of_friends.current) AS f(node)
+        JOIN
+            hashset_bench.edges AS edges ON edges.from_node = f.node
+    ) q
+    WHERE
+        friends_of_friends.depth < 3
+)
+SELECT
+    hashset_cardinality(current)
+FROM
+    friends_of_friends
+WHERE
+    depth = 3;
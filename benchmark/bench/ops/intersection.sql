@@ -0,0 +1 @@
+SELECT hashset_cardinality(hashset_intersection(s, s2)) FROM hashset_bench.sets WHERE id = @ID@;
@@ -0,0 +1 @@
+SELECT hashset_cardinality(t::int4hashset) FROM hashset_bench.sets WHERE id = @ID@;
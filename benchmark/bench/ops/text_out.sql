@@ -0,0 +1 @@
+SELECT length(s::text) FROM hashset_bench.sets WHERE id = @ID@;
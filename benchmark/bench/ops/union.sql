@@ -0,0 +1 @@
+SELECT hashset_cardinality(hashset_union(s, s2)) FROM hashset_bench.sets WHERE id = @ID@;
@@ -0,0 +1,144 @@
+-- Data for the benchmark suite (see bench.sh).
+--
+-- Everything lives in the hashset_bench schema and is generated locally with
+-- a fixed seed, so that runs on different builds use exactly the same data.
+-- The suite passes the sizes and graph size as psql variables:
+--
+--   psql -v sizes='{1000,100000}' -v graph_nodes=100000 -f setup.sql
+
+\set ON_ERROR_STOP on
+
+CREATE EXTENSION IF NOT EXISTS hashset;
+
+DROP SCHEMA IF EXISTS hashset_bench CASCADE;
+CREATE SCHEMA hashset_bench;
+
+-- Values of a data set, with the distribution:
+--
+--   uniform      random values over the whole int4 range
+--   sequential   1, 2, 3, ... (a single run in the container encoding)
+--   clustered    runs of 100 consecutive values, 100000 apart
+--   adversarial  multiples of 128 - all elements get the same 7-bit tag with
+--                the naive hash function, so every probe checks whole groups
+CREATE FUNCTION hashset_bench.generate_values(dist text, n int)
+RETURNS TABLE (i int, v int)
+LANGUAGE plpgsql AS $$
+BEGIN
+    PERFORM setseed(0.12345);
+
+    IF dist = 'uniform' THEN
+        RETURN QUERY
+        SELECT s, (floor(4294967296 * random()) - 2147483648)::int
+          FROM generate_series(1, n) s;
+    ELSIF dist = 'sequential' THEN
+        RETURN QUERY
+        SELECT s, s FROM generate_series(1, n) s;
+    ELSIF dist = 'clustered' THEN
+        RETURN QUERY
+        SELECT s, ((s - 1) / 100) * 100000 + (s - 1) % 100
+          FROM generate_series(1, n) s;
+    ELSIF dist = 'adversarial' THEN
+        RETURN QUERY
+        SELECT s, s * 128 FROM generate_series(1, n) s;
+    ELSE
+        RAISE EXCEPTION 'unknown distribution "%"', dist;
+    END IF;
+END;
+$$;
+
+-- The "add" operation - one hashset_add call per element, updating the
+-- expanded set in place.
+CREATE FUNCTION hashset_bench.add_all(tbl regclass, load_factor float4, hashfn_id int)
+RETURNS bigint
+LANGUAGE plpgsql AS $$
+DECLARE
+    s   int4hashset := int4hashset(0, load_factor, 2.0, hashfn_id);
+    val int;
+BEGIN
+    FOR val IN EXECUTE format('SELECT v FROM %s', tbl) LOOP
+        s := hashset_add(s, val);
+    END LOOP;
+
+    RETURN hashset_cardinality(s);
+END;
+$$;
+
+-- One row per data set and set parameters. The second set "s2" shares half
+-- of the elements with "s" (for union/intersection), "probes" are half hits
+-- and half misses.
+CREATE TABLE hashset_bench.sets (
+    id          serial PRIMARY KEY,
+    dist        text NOT NULL,
+    size        int NOT NULL,
+    hashfn_id   int NOT NULL,
+    load_factor float4 NOT NULL,
+    s           int4hashset NOT NULL,
+    s2          int4hashset NOT NULL,
+    t           text NOT NULL,
+    probes      int[] NOT NULL
+);
+
+-- Target of the binary input benchmark (COPY ... FORMAT binary), the sets
+-- are not compressed so that only the receive function gets measured.
+CREATE UNLOGGED TABLE hashset_bench.sink (s int4hashset);
+ALTER TABLE hashset_bench.sink ALTER COLUMN s SET STORAGE EXTERNAL;
+
+-- psql variables are not expanded in the DO block
+SELECT set_config('hashset_bench.sizes', :'sizes', false);
+
+DO $$
+DECLARE
+    dist    text;
+    n       int;
+    tbl     text;
+    params  record;
+BEGIN
+    FOREACH dist IN ARRAY ARRAY['uniform', 'sequential', 'clustered', 'adversarial'] LOOP
+        FOREACH n IN ARRAY current_setting('hashset_bench.sizes')::int[] LOOP
+            tbl := format('hashset_bench.values_%s_%s', dist, n);
+
+            EXECUTE format('CREATE TABLE %s AS SELECT * FROM hashset_bench.generate_values(%L, %s)',
+                           tbl, dist, n);
+            EXECUTE format('ANALYZE %s', tbl);
+
+            -- the default parameters with each hash function, and other load
+            -- factors with the default hash function
+            FOR params IN
+                SELECT * FROM (VALUES (1, 0.75), (2, 0.75), (3, 0.75), (1, 0.5), (1, 0.9))
+                    AS p(hashfn_id, load_factor)
+            LOOP
+                EXECUTE format(
+                    'INSERT INTO hashset_bench.sets (dist, size, hashfn_id, load_factor, s, s2, t, probes)
+                     SELECT %L, %s, %s, %s, a.s, a.s2, a.s::text, p.probes
+                       FROM (SELECT hashset_agg(v, %s, %s, %s) AS s,
+                                    hashset_agg(CASE WHEN i %% 2 = 0 THEN v ELSE ~v END, %s, %s, %s) AS s2
+                               FROM %s) a,
+                            (SELECT array_agg(CASE WHEN i %% 2 = 0 THEN v ELSE ~v END) AS probes
+                               FROM (SELECT i, v FROM %s ORDER BY hashint4(i) LIMIT 10000) x) p',
+                    dist, n, params.hashfn_id, params.load_factor,
+                    n, params.load_factor, params.hashfn_id,
+                    n, params.load_factor, params.hashfn_id,
+                    tbl, tbl);
+            END LOOP;
+        END LOOP;
+    END LOOP;
+END;
+$$;
+
+ANALYZE hashset_bench.sets;
+
+-- The graph for the friends-of-friends benchmark, replacing the soc-pokec
+-- download. Each node gets 1-20 edges, with targets skewed towards the low
+-- node numbers (a few "popular" nodes, like in a social network).
+SELECT setseed(0.12345);
+
+CREATE TABLE hashset_bench.edges AS
+SELECT DISTINCT from_node, to_node
+  FROM (SELECT n AS from_node,
+               (1 + floor(:graph_nodes * power(random(), 3)))::int AS to_node
+          FROM generate_series(1, :graph_nodes) n,
+               generate_series(1, 1 + (n % 20)) k) e
+ WHERE from_node <> to_node;
+
+ALTER TABLE hashset_bench.edges ADD PRIMARY KEY (from_node, to_node);
+ANALYZE hashset_bench.edges;
@@ -48,9 +48,44 @@ WITH RECURSIVE friends_of_friends AS
         SELECT
             hashset_agg(edges.to_node) AS new_current
         FROM
-            edges
-        WHERE
-            from_node = ANY(hashset_to_array(friends_of_friends.current))
+            hashset_elements(friends_of_friends.current) AS f(node)
+        JOIN
+            edges ON edges.from_node = f.node
+    ) q
+    WHERE
+        friends_of_friends.depth < 3
+)
+SELECT
+    depth,
+    hashset_cardinality(current)
+FROM
+    friends_of_friends
+WHERE
+    depth = 3;
+
+-- nodes first reached at depth 3, skipping the visited ones while aggregating
+CREATE OR REPLACE VIEW vfriends_of_friends_hashset_agg_frontier AS
+WITH RECURSIVE friends_of_friends AS
+(
+    SELECT
+        '{5867}'::int4hashset AS current,
+        '{5867}'::int4hashset AS visited,
+        0 AS depth
+    UNION ALL
+    SELECT
+        (q.f).frontier,
+        (q.f).visited,
+        friends_of_friends.depth + 1
+    FROM
+        friends_of_friends
+    CROSS JOIN LATERAL
+    (
+        SELECT
+            hashset_agg_frontier(edges.to_node, friends_of_friends.visited) AS f
+        FROM
+            hashset_elements(friends_of_friends.current) AS f(node)
+        JOIN
+            edges ON edges.from_node = f.node
     ) q
     WHERE
         friends_of_friends.depth < 3
@@ -70,3 +105,7 @@ SELECT * FROM vfriends_of_friends_array_agg_distinct;
 SELECT * FROM vfriends_of_friends_hashset_agg;
 SELECT * FROM vfriends_of_friends_hashset_agg;
 SELECT * FROM vfriends_of_friends_hashset_agg;
+
+SELECT * FROM vfriends_of_friends_hashset_agg_frontier;
+SELECT * FROM vfriends_of_friends_hashset_agg_frontier;
+SELECT * FROM vfriends_of_friends_hashset_agg_frontier;
@@ -0,0 +1,1810 @@
+/*
+ * Upgrade from 0.0.1 to 0.0.2
+ *
+ * Version 0.0.2 changed the on-disk layout of int4hashset (see the format
+ * version in hashset.h).  Values stored by 0.0.1 are converted when they
+ * are read, so existing tables keep working, but they are only rewritten
+ * in the new layout when they are next updated.
+ */
+
+/*
+ * Hashset Type Definition
+ */
+
+CREATE OR REPLACE FUNCTION int4hashset_typanalyze(internal)
+RETURNS boolean
+AS 'hashset', 'int4hashset_typanalyze'
+LANGUAGE C STRICT;
+
+/*
+ * Hashset Functions
+ */
+
+CREATE OR REPLACE FUNCTION int4hashset_support(internal)
+RETURNS internal
+AS 'hashset', 'int4hashset_support'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_remove(int4hashset, int)
+RETURNS int4hashset
+AS 'hashset', 'int4hashset_remove'
+LANGUAGE C IMMUTABLE
+SUPPORT int4hashset_support;
+
+CREATE OR REPLACE FUNCTION hashset_remove(int4hashset, int[])
+RETURNS int4hashset
+AS 'hashset', 'int4hashset_remove_array'
+LANGUAGE C IMMUTABLE STRICT
+SUPPORT int4hashset_support;
+
+CREATE OR REPLACE FUNCTION hashset_compact(int4hashset)
+RETURNS int4hashset
+AS 'hashset', 'int4hashset_shrink_to_fit'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int4hashset_contains_support(internal)
+RETURNS internal
+AS 'hashset', 'int4hashset_contains_support'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_contains_any(int4hashset, int[])
+RETURNS boolean
+AS 'hashset', 'int4hashset_contains_any'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_contains_all(int4hashset, int[])
+RETURNS boolean
+AS 'hashset', 'int4hashset_contains_all'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_contains_each(int4hashset, int[])
+RETURNS boolean[]
+AS 'hashset', 'int4hashset_contains_each'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_filter(int[], int4hashset)
+RETURNS int[]
+AS 'hashset', 'int4hashset_filter_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int4hashset_elements_support(internal)
+RETURNS internal
+AS 'hashset', 'int4hashset_elements_support'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_elements(int4hashset)
+RETURNS SETOF int
+AS 'hashset', 'int4hashset_elements'
+LANGUAGE C IMMUTABLE STRICT
+ROWS 100
+SUPPORT int4hashset_elements_support;
+
+CREATE OR REPLACE FUNCTION hashset_from_array(int[])
+RETURNS int4hashset
+AS 'hashset', 'int4hashset_from_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (int[] AS int4hashset)
+WITH FUNCTION hashset_from_array(int[]);
+
+/*
+ * Aggregation Functions
+ */
+
+CREATE OR REPLACE FUNCTION int4hashset_agg_add(p_pointer internal, p_value int, p_expected_count int)
+RETURNS internal
+AS 'hashset', 'int4hashset_agg_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int4hashset_agg_add(p_pointer internal, p_value int, p_expected_count int, p_load_factor float4, p_hashfn_id int)
+RETURNS internal
+AS 'hashset', 'int4hashset_agg_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int4hashset_agg_serial(p_pointer internal)
+RETURNS bytea
+AS 'hashset', 'int4hashset_agg_serial'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int4hashset_agg_deserial(p_value bytea, p_pointer internal)
+RETURNS internal
+AS 'hashset', 'int4hashset_agg_deserial'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE AGGREGATE hashset_agg(value int, expected_count int) (
+    SFUNC = int4hashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = int4hashset_agg_final,
+    COMBINEFUNC = int4hashset_agg_combine,
+    SERIALFUNC = int4hashset_agg_serial,
+    DESERIALFUNC = int4hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_agg(value int, expected_count int, load_factor float4, hashfn_id int) (
+    SFUNC = int4hashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = int4hashset_agg_final,
+    COMBINEFUNC = int4hashset_agg_combine,
+    SERIALFUNC = int4hashset_agg_serial,
+    DESERIALFUNC = int4hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE FUNCTION int4hashset_agg_add_array(p_pointer internal, p_value int[])
+RETURNS internal
+AS 'hashset', 'int4hashset_agg_add_array'
+LANGUAGE C IMMUTABLE;
+
+CREATE AGGREGATE hashset_agg(int[]) (
+    SFUNC = int4hashset_agg_add_array,
+    STYPE = internal,
+    FINALFUNC = int4hashset_agg_final,
+    COMBINEFUNC = int4hashset_agg_combine,
+    SERIALFUNC = int4hashset_agg_serial,
+    DESERIALFUNC = int4hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE FUNCTION int4hashset_agg_excluding_add(p_pointer internal, p_value int, p_visited int4hashset)
+RETURNS internal
+AS 'hashset', 'int4hashset_agg_excluding_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int4hashset_agg_excluding_final(p_pointer internal)
+RETURNS int4hashset
+AS 'hashset', 'int4hashset_agg_excluding_final'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE AGGREGATE hashset_agg_excluding(value int, visited int4hashset) (
+    SFUNC = int4hashset_agg_excluding_add,
+    STYPE = internal,
+    FINALFUNC = int4hashset_agg_excluding_final,
+    PARALLEL = SAFE
+);
+
+CREATE TYPE hashset_frontier AS (
+    frontier int4hashset,
+    visited int4hashset
+);
+
+CREATE OR REPLACE FUNCTION int4hashset_agg_frontier_add(p_pointer internal, p_value int, p_visited int4hashset)
+RETURNS internal
+AS 'hashset', 'int4hashset_agg_frontier_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int4hashset_agg_frontier_final(p_pointer internal)
+RETURNS hashset_frontier
+AS 'hashset', 'int4hashset_agg_frontier_final'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE AGGREGATE hashset_agg_frontier(value int, visited int4hashset) (
+    SFUNC = int4hashset_agg_frontier_add,
+    STYPE = internal,
+    FINALFUNC = int4hashset_agg_frontier_final,
+    PARALLEL = SAFE
+);
+
+/*
+ * Operator Definitions
+ */
+
+CREATE OPERATOR - (
+    leftarg = int4hashset,
+    rightarg = int4,
+    function = hashset_remove
+);
+
+CREATE OPERATOR - (
+    leftarg = int4hashset,
+    rightarg = int4[],
+    function = hashset_remove
+);
+
+/*
+ * Hashset Hash Operators
+ */
+
+CREATE OR REPLACE FUNCTION hashset_hash_extended(int4hashset, bigint)
+RETURNS bigint
+AS 'hashset', 'int4hashset_hash_extended'
+LANGUAGE C IMMUTABLE STRICT;
+
+/*
+ * Hashset Btree Operators
+ */
+
+CREATE OR REPLACE FUNCTION hashset_sortsupport(internal)
+RETURNS void
+AS 'hashset', 'int4hashset_sortsupport'
+LANGUAGE C IMMUTABLE STRICT;
+
+/*
+ * Hashset Containment Operators
+ */
+
+CREATE OR REPLACE FUNCTION hashset_sel(internal, oid, internal, integer)
+RETURNS float8
+AS 'hashset', 'int4hashset_sel'
+LANGUAGE C STABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_joinsel(internal, oid, internal, int2, internal)
+RETURNS float8
+AS 'hashset', 'int4hashset_joinsel'
+LANGUAGE C STABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_is_superset(int4hashset, int4hashset)
+RETURNS boolean
+AS 'hashset', 'int4hashset_is_superset'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_is_subset(int4hashset, int4hashset)
+RETURNS boolean
+AS 'hashset', 'int4hashset_is_subset'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_overlaps(int4hashset, int4hashset)
+RETURNS boolean
+AS 'hashset', 'int4hashset_overlaps'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR @> (
+    PROCEDURE = hashset_is_superset,
+    LEFTARG = int4hashset,
+    RIGHTARG = int4hashset,
+    COMMUTATOR = '<@',
+    RESTRICT = hashset_sel,
+    JOIN = hashset_joinsel
+);
+
+CREATE OPERATOR <@ (
+    PROCEDURE = hashset_is_subset,
+    LEFTARG = int4hashset,
+    RIGHTARG = int4hashset,
+    COMMUTATOR = '@>',
+    RESTRICT = hashset_sel,
+    JOIN = hashset_joinsel
+);
+
+CREATE OPERATOR && (
+    PROCEDURE = hashset_overlaps,
+    LEFTARG = int4hashset,
+    RIGHTARG = int4hashset,
+    COMMUTATOR = &&,
+    RESTRICT = hashset_sel,
+    JOIN = hashset_joinsel
+);
+
+CREATE OPERATOR @> (
+    PROCEDURE = hashset_contains,
+    LEFTARG = int4hashset,
+    RIGHTARG = int,
+    RESTRICT = hashset_sel,
+    JOIN = hashset_joinsel
+);
+
+/*
+ * Hashset GIN Operators
+ */
+
+CREATE OR REPLACE FUNCTION hashset_gin_extract_value(int4hashset, internal, internal)
+RETURNS internal
+AS 'hashset', 'int4hashset_gin_extract_value'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_gin_extract_query(int4hashset, internal, int2, internal, internal, internal, internal)
+RETURNS internal
+AS 'hashset', 'int4hashset_gin_extract_query'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_gin_consistent(internal, int2, int4hashset, int4, internal, internal, internal, internal)
+RETURNS boolean
+AS 'hashset', 'int4hashset_gin_consistent'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR CLASS int4hashset_gin_ops
+DEFAULT FOR TYPE int4hashset USING gin AS
+OPERATOR 1 && (int4hashset, int4hashset),
+OPERATOR 2 @> (int4hashset, int4hashset),
+OPERATOR 3 <@ (int4hashset, int4hashset),
+OPERATOR 4 = (int4hashset, int4hashset),
+OPERATOR 5 @> (int4hashset, int),
+FUNCTION 1 btint4cmp(int4, int4),
+FUNCTION 2 hashset_gin_extract_value(int4hashset, internal, internal),
+FUNCTION 3 hashset_gin_extract_query(int4hashset, internal, int2, internal, internal, internal, internal),
+FUNCTION 4 hashset_gin_consistent(internal, int2, int4hashset, int4, internal, internal, internal, internal),
+STORAGE int4;
+
+/*
+ * int8hashset Type Definition (bigint elements)
+ */
+
+CREATE TYPE int8hashset;
+
+CREATE OR REPLACE FUNCTION int8hashset_in(cstring)
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int8hashset_out(int8hashset)
+RETURNS cstring
+AS 'hashset', 'int8hashset_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int8hashset_send(int8hashset)
+RETURNS bytea
+AS 'hashset', 'int8hashset_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int8hashset_recv(internal)
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int8hashset_typanalyze(internal)
+RETURNS boolean
+AS 'hashset', 'int8hashset_typanalyze'
+LANGUAGE C STRICT;
+
+CREATE TYPE int8hashset (
+    INPUT = int8hashset_in,
+    OUTPUT = int8hashset_out,
+    RECEIVE = int8hashset_recv,
+    SEND = int8hashset_send,
+    ANALYZE = int8hashset_typanalyze,
+    INTERNALLENGTH = variable,
+    ALIGNMENT = double,
+    STORAGE = extended
+);
+
+/*
+ * int8hashset Functions
+ */
+
+CREATE OR REPLACE FUNCTION int8hashset(
+    capacity int DEFAULT 0,
+    load_factor float4 DEFAULT 0.75,
+    growth_factor float4 DEFAULT 2.0,
+    hashfn_id int DEFAULT 1
+)
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_init'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION hashset_add(int8hashset, bigint)
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_add'
+LANGUAGE C IMMUTABLE
+SUPPORT int4hashset_support;
+
+CREATE OR REPLACE FUNCTION hashset_remove(int8hashset, bigint)
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_remove'
+LANGUAGE C IMMUTABLE
+SUPPORT int4hashset_support;
+
+CREATE OR REPLACE FUNCTION hashset_remove(int8hashset, bigint[])
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_remove_array'
+LANGUAGE C IMMUTABLE STRICT
+SUPPORT int4hashset_support;
+
+CREATE OR REPLACE FUNCTION hashset_compact(int8hashset)
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_shrink_to_fit'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_contains(int8hashset, bigint)
+RETURNS boolean
+AS 'hashset', 'int8hashset_contains'
+LANGUAGE C IMMUTABLE
+SUPPORT int4hashset_contains_support;
+
+CREATE OR REPLACE FUNCTION hashset_contains_any(int8hashset, bigint[])
+RETURNS boolean
+AS 'hashset', 'int8hashset_contains_any'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_contains_all(int8hashset, bigint[])
+RETURNS boolean
+AS 'hashset', 'int8hashset_contains_all'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_contains_each(int8hashset, bigint[])
+RETURNS boolean[]
+AS 'hashset', 'int8hashset_contains_each'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_filter(bigint[], int8hashset)
+RETURNS bigint[]
+AS 'hashset', 'int8hashset_filter_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_union(int8hashset, int8hashset)
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_union'
+LANGUAGE C IMMUTABLE STRICT
+SUPPORT int4hashset_support;
+
+CREATE OR REPLACE FUNCTION hashset_intersection(int8hashset, int8hashset)
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_intersection'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_difference(int8hashset, int8hashset)
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_difference'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_symmetric_difference(int8hashset, int8hashset)
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_symmetric_difference'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_to_array(int8hashset)
+RETURNS bigint[]
+AS 'hashset', 'int8hashset_to_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_to_sorted_array(int8hashset)
+RETURNS bigint[]
+AS 'hashset', 'int8hashset_to_sorted_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_elements(int8hashset)
+RETURNS SETOF bigint
+AS 'hashset', 'int8hashset_elements'
+LANGUAGE C IMMUTABLE STRICT
+ROWS 100
+SUPPORT int4hashset_elements_support;
+
+CREATE OR REPLACE FUNCTION hashset_cardinality(int8hashset)
+RETURNS bigint
+AS 'hashset', 'int8hashset_cardinality'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_capacity(int8hashset)
+RETURNS bigint
+AS 'hashset', 'int8hashset_capacity'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_collisions(int8hashset)
+RETURNS bigint
+AS 'hashset', 'int8hashset_collisions'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_max_collisions(int8hashset)
+RETURNS bigint
+AS 'hashset', 'int8hashset_max_collisions'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int8hashset_from_array(bigint[])
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_from_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (bigint[] AS int8hashset)
+WITH FUNCTION int8hashset_from_array(bigint[]);
+
+CREATE OR REPLACE FUNCTION int8_add_int8hashset(bigint, int8hashset)
+RETURNS int8hashset
+AS $$SELECT $2 || $1$$
+LANGUAGE SQL
+IMMUTABLE PARALLEL SAFE STRICT COST 1;
+
+/*
+ * int8hashset Aggregates
+ */
+
+CREATE OR REPLACE FUNCTION int8hashset_agg_add(p_pointer internal, p_value bigint)
+RETURNS internal
+AS 'hashset', 'int8hashset_agg_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int8hashset_agg_add(p_pointer internal, p_value bigint, p_expected_count int)
+RETURNS internal
+AS 'hashset', 'int8hashset_agg_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int8hashset_agg_add(p_pointer internal, p_value bigint, p_expected_count int, p_load_factor float4, p_hashfn_id int)
+RETURNS internal
+AS 'hashset', 'int8hashset_agg_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int8hashset_agg_add_set(p_pointer internal, p_value int8hashset)
+RETURNS internal
+AS 'hashset', 'int8hashset_agg_add_set'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int8hashset_agg_add_array(p_pointer internal, p_value bigint[])
+RETURNS internal
+AS 'hashset', 'int8hashset_agg_add_array'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int8hashset_agg_final(p_pointer internal)
+RETURNS int8hashset
+AS 'hashset', 'int8hashset_agg_final'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int8hashset_agg_combine(p_pointer internal, p_pointer2 internal)
+RETURNS internal
+AS 'hashset', 'int8hashset_agg_combine'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int8hashset_agg_serial(p_pointer internal)
+RETURNS bytea
+AS 'hashset', 'int8hashset_agg_serial'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int8hashset_agg_deserial(p_value bytea, p_pointer internal)
+RETURNS internal
+AS 'hashset', 'int8hashset_agg_deserial'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE AGGREGATE hashset_agg(bigint) (
+    SFUNC = int8hashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = int8hashset_agg_final,
+    COMBINEFUNC = int8hashset_agg_combine,
+    SERIALFUNC = int8hashset_agg_serial,
+    DESERIALFUNC = int8hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_agg(value bigint, expected_count int) (
+    SFUNC = int8hashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = int8hashset_agg_final,
+    COMBINEFUNC = int8hashset_agg_combine,
+    SERIALFUNC = int8hashset_agg_serial,
+    DESERIALFUNC = int8hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_agg(value bigint, expected_count int, load_factor float4, hashfn_id int) (
+    SFUNC = int8hashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = int8hashset_agg_final,
+    COMBINEFUNC = int8hashset_agg_combine,
+    SERIALFUNC = int8hashset_agg_serial,
+    DESERIALFUNC = int8hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_agg(int8hashset) (
+    SFUNC = int8hashset_agg_add_set,
+    STYPE = internal,
+    FINALFUNC = int8hashset_agg_final,
+    COMBINEFUNC = int8hashset_agg_combine,
+    SERIALFUNC = int8hashset_agg_serial,
+    DESERIALFUNC = int8hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_agg(bigint[]) (
+    SFUNC = int8hashset_agg_add_array,
+    STYPE = internal,
+    FINALFUNC = int8hashset_agg_final,
+    COMBINEFUNC = int8hashset_agg_combine,
+    SERIALFUNC = int8hashset_agg_serial,
+    DESERIALFUNC = int8hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+/*
+ * int8hashset Operators
+ */
+
+CREATE OR REPLACE FUNCTION hashset_eq(int8hashset, int8hashset)
+RETURNS boolean
+AS 'hashset', 'int8hashset_eq'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR = (
+    LEFTARG = int8hashset,
+    RIGHTARG = int8hashset,
+    PROCEDURE = hashset_eq,
+    COMMUTATOR = =,
+    HASHES
+);
+
+CREATE OR REPLACE FUNCTION hashset_ne(int8hashset, int8hashset)
+RETURNS boolean
+AS 'hashset', 'int8hashset_ne'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR <> (
+    LEFTARG = int8hashset,
+    RIGHTARG = int8hashset,
+    PROCEDURE = hashset_ne,
+    COMMUTATOR = '<>',
+    NEGATOR = '=',
+    RESTRICT = neqsel,
+    JOIN = neqjoinsel,
+    HASHES
+);
+
+CREATE OPERATOR || (
+    leftarg = int8hashset,
+    rightarg = bigint,
+    function = hashset_add,
+    commutator = ||
+);
+
+CREATE OPERATOR || (
+    leftarg = bigint,
+    rightarg = int8hashset,
+    function = int8_add_int8hashset,
+    commutator = ||
+);
+
+CREATE OPERATOR - (
+    leftarg = int8hashset,
+    rightarg = bigint,
+    function = hashset_remove
+);
+
+CREATE OPERATOR - (
+    leftarg = int8hashset,
+    rightarg = bigint[],
+    function = hashset_remove
+);
+
+CREATE OR REPLACE FUNCTION hashset_hash(int8hashset)
+RETURNS integer
+AS 'hashset', 'int8hashset_hash'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_hash_extended(int8hashset, bigint)
+RETURNS bigint
+AS 'hashset', 'int8hashset_hash_extended'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR CLASS int8hashset_hash_ops
+DEFAULT FOR TYPE int8hashset USING hash AS
+OPERATOR 1 = (int8hashset, int8hashset),
+FUNCTION 1 hashset_hash(int8hashset),
+FUNCTION 2 hashset_hash_extended(int8hashset, bigint);
+
+CREATE OR REPLACE FUNCTION hashset_lt(int8hashset, int8hashset)
+RETURNS boolean
+AS 'hashset', 'int8hashset_lt'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_le(int8hashset, int8hashset)
+RETURNS boolean
+AS 'hashset', 'int8hashset_le'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_gt(int8hashset, int8hashset)
+RETURNS boolean
+AS 'hashset', 'int8hashset_gt'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_ge(int8hashset, int8hashset)
+RETURNS boolean
+AS 'hashset', 'int8hashset_ge'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_cmp(int8hashset, int8hashset)
+RETURNS integer
+AS 'hashset', 'int8hashset_cmp'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int8hashset_sortsupport(internal)
+RETURNS void
+AS 'hashset', 'int8hashset_sortsupport'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR < (
+    PROCEDURE = hashset_lt,
+    LEFTARG = int8hashset,
+    RIGHTARG = int8hashset,
+    COMMUTATOR = >,
+    NEGATOR = >=,
+    RESTRICT = scalarltsel,
+    JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR <= (
+    PROCEDURE = hashset_le,
+    LEFTARG = int8hashset,
+    RIGHTARG = int8hashset,
+    COMMUTATOR = '>=',
+    NEGATOR = '>',
+    RESTRICT = scalarltsel,
+    JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR > (
+    PROCEDURE = hashset_gt,
+    LEFTARG = int8hashset,
+    RIGHTARG = int8hashset,
+    COMMUTATOR = '<',
+    NEGATOR = '<=',
+    RESTRICT = scalargtsel,
+    JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR >= (
+    PROCEDURE = hashset_ge,
+    LEFTARG = int8hashset,
+    RIGHTARG = int8hashset,
+    COMMUTATOR = '<=',
+    NEGATOR = '<',
+    RESTRICT = scalargtsel,
+    JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR CLASS int8hashset_btree_ops
+DEFAULT FOR TYPE int8hashset USING btree AS
+OPERATOR 1 < (int8hashset, int8hashset),
+OPERATOR 2 <= (int8hashset, int8hashset),
+OPERATOR 3 = (int8hashset, int8hashset),
+OPERATOR 4 >= (int8hashset, int8hashset),
+OPERATOR 5 > (int8hashset, int8hashset),
+FUNCTION 1 hashset_cmp(int8hashset, int8hashset),
+FUNCTION 2 int8hashset_sortsupport(internal);
+
+CREATE OR REPLACE FUNCTION int8hashset_sel(internal, oid, internal, integer)
+RETURNS float8
+AS 'hashset', 'int8hashset_sel'
+LANGUAGE C STABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int8hashset_joinsel(internal, oid, internal, int2, internal)
+RETURNS float8
+AS 'hashset', 'int8hashset_joinsel'
+LANGUAGE C STABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_is_superset(int8hashset, int8hashset)
+RETURNS boolean
+AS 'hashset', 'int8hashset_is_superset'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_is_subset(int8hashset, int8hashset)
+RETURNS boolean
+AS 'hashset', 'int8hashset_is_subset'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_overlaps(int8hashset, int8hashset)
+RETURNS boolean
+AS 'hashset', 'int8hashset_overlaps'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR @> (
+    PROCEDURE = hashset_is_superset,
+    LEFTARG = int8hashset,
+    RIGHTARG = int8hashset,
+    COMMUTATOR = '<@',
+    RESTRICT = int8hashset_sel,
+    JOIN = int8hashset_joinsel
+);
+
+CREATE OPERATOR <@ (
+    PROCEDURE = hashset_is_subset,
+    LEFTARG = int8hashset,
+    RIGHTARG = int8hashset,
+    COMMUTATOR = '@>',
+    RESTRICT = int8hashset_sel,
+    JOIN = int8hashset_joinsel
+);
+
+CREATE OPERATOR && (
+    PROCEDURE = hashset_overlaps,
+    LEFTARG = int8hashset,
+    RIGHTARG = int8hashset,
+    COMMUTATOR = &&,
+    RESTRICT = int8hashset_sel,
+    JOIN = int8hashset_joinsel
+);
+
+CREATE OPERATOR @> (
+    PROCEDURE = hashset_contains,
+    LEFTARG = int8hashset,
+    RIGHTARG = bigint,
+    RESTRICT = int8hashset_sel,
+    JOIN = int8hashset_joinsel
+);
+
+CREATE OR REPLACE FUNCTION hashset_gin_extract_value(int8hashset, internal, internal)
+RETURNS internal
+AS 'hashset', 'int8hashset_gin_extract_value'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_gin_extract_query(int8hashset, internal, int2, internal, internal, internal, internal)
+RETURNS internal
+AS 'hashset', 'int8hashset_gin_extract_query'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_gin_consistent(internal, int2, int8hashset, int4, internal, internal, internal, internal)
+RETURNS boolean
+AS 'hashset', 'int4hashset_gin_consistent'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR CLASS int8hashset_gin_ops
+DEFAULT FOR TYPE int8hashset USING gin AS
+OPERATOR 1 && (int8hashset, int8hashset),
+OPERATOR 2 @> (int8hashset, int8hashset),
+OPERATOR 3 <@ (int8hashset, int8hashset),
+OPERATOR 4 = (int8hashset, int8hashset),
+OPERATOR 5 @> (int8hashset, bigint),
+FUNCTION 1 btint8cmp(int8, int8),
+FUNCTION 2 hashset_gin_extract_value(int8hashset, internal, internal),
+FUNCTION 3 hashset_gin_extract_query(int8hashset, internal, int2, internal, internal, internal, internal),
+FUNCTION 4 hashset_gin_consistent(internal, int2, int8hashset, int4, internal, internal, internal, internal),
+STORAGE int8;
+
+/*
+ * int2hashset Type Definition (smallint elements)
+ */
+
+CREATE TYPE int2hashset;
+
+CREATE OR REPLACE FUNCTION int2hashset_in(cstring)
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int2hashset_out(int2hashset)
+RETURNS cstring
+AS 'hashset', 'int2hashset_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int2hashset_send(int2hashset)
+RETURNS bytea
+AS 'hashset', 'int2hashset_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int2hashset_recv(internal)
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int2hashset_typanalyze(internal)
+RETURNS boolean
+AS 'hashset', 'int2hashset_typanalyze'
+LANGUAGE C STRICT;
+
+CREATE TYPE int2hashset (
+    INPUT = int2hashset_in,
+    OUTPUT = int2hashset_out,
+    RECEIVE = int2hashset_recv,
+    SEND = int2hashset_send,
+    ANALYZE = int2hashset_typanalyze,
+    INTERNALLENGTH = variable,
+    ALIGNMENT = int4,
+    STORAGE = extended
+);
+
+/*
+ * int2hashset Functions
+ */
+
+CREATE OR REPLACE FUNCTION int2hashset(
+    capacity int DEFAULT 0,
+    load_factor float4 DEFAULT 0.75,
+    growth_factor float4 DEFAULT 2.0,
+    hashfn_id int DEFAULT 1
+)
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_init'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION hashset_add(int2hashset, smallint)
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_add'
+LANGUAGE C IMMUTABLE
+SUPPORT int4hashset_support;
+
+CREATE OR REPLACE FUNCTION hashset_remove(int2hashset, smallint)
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_remove'
+LANGUAGE C IMMUTABLE
+SUPPORT int4hashset_support;
+
+CREATE OR REPLACE FUNCTION hashset_remove(int2hashset, smallint[])
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_remove_array'
+LANGUAGE C IMMUTABLE STRICT
+SUPPORT int4hashset_support;
+
+CREATE OR REPLACE FUNCTION hashset_compact(int2hashset)
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_shrink_to_fit'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_contains(int2hashset, smallint)
+RETURNS boolean
+AS 'hashset', 'int2hashset_contains'
+LANGUAGE C IMMUTABLE
+SUPPORT int4hashset_contains_support;
+
+CREATE OR REPLACE FUNCTION hashset_contains_any(int2hashset, smallint[])
+RETURNS boolean
+AS 'hashset', 'int2hashset_contains_any'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_contains_all(int2hashset, smallint[])
+RETURNS boolean
+AS 'hashset', 'int2hashset_contains_all'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_contains_each(int2hashset, smallint[])
+RETURNS boolean[]
+AS 'hashset', 'int2hashset_contains_each'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_filter(smallint[], int2hashset)
+RETURNS smallint[]
+AS 'hashset', 'int2hashset_filter_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_union(int2hashset, int2hashset)
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_union'
+LANGUAGE C IMMUTABLE STRICT
+SUPPORT int4hashset_support;
+
+CREATE OR REPLACE FUNCTION hashset_intersection(int2hashset, int2hashset)
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_intersection'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_difference(int2hashset, int2hashset)
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_difference'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_symmetric_difference(int2hashset, int2hashset)
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_symmetric_difference'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_to_array(int2hashset)
+RETURNS smallint[]
+AS 'hashset', 'int2hashset_to_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_to_sorted_array(int2hashset)
+RETURNS smallint[]
+AS 'hashset', 'int2hashset_to_sorted_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_elements(int2hashset)
+RETURNS SETOF smallint
+AS 'hashset', 'int2hashset_elements'
+LANGUAGE C IMMUTABLE STRICT
+ROWS 100
+SUPPORT int4hashset_elements_support;
+
+CREATE OR REPLACE FUNCTION hashset_cardinality(int2hashset)
+RETURNS bigint
+AS 'hashset', 'int2hashset_cardinality'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_capacity(int2hashset)
+RETURNS bigint
+AS 'hashset', 'int2hashset_capacity'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_collisions(int2hashset)
+RETURNS bigint
+AS 'hashset', 'int2hashset_collisions'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_max_collisions(int2hashset)
+RETURNS bigint
+AS 'hashset', 'int2hashset_max_collisions'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int2hashset_from_array(smallint[])
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_from_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (smallint[] AS int2hashset)
+WITH FUNCTION int2hashset_from_array(smallint[]);
+
+CREATE OR REPLACE FUNCTION int2_add_int2hashset(smallint, int2hashset)
+RETURNS int2hashset
+AS $$SELECT $2 || $1$$
+LANGUAGE SQL
+IMMUTABLE PARALLEL SAFE STRICT COST 1;
+
+/*
+ * int2hashset Aggregates
+ */
+
+CREATE OR REPLACE FUNCTION int2hashset_agg_add(p_pointer internal, p_value smallint)
+RETURNS internal
+AS 'hashset', 'int2hashset_agg_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int2hashset_agg_add(p_pointer internal, p_value smallint, p_expected_count int)
+RETURNS internal
+AS 'hashset', 'int2hashset_agg_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int2hashset_agg_add(p_pointer internal, p_value smallint, p_expected_count int, p_load_factor float4, p_hashfn_id int)
+RETURNS internal
+AS 'hashset', 'int2hashset_agg_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int2hashset_agg_add_set(p_pointer internal, p_value int2hashset)
+RETURNS internal
+AS 'hashset', 'int2hashset_agg_add_set'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int2hashset_agg_add_array(p_pointer internal, p_value smallint[])
+RETURNS internal
+AS 'hashset', 'int2hashset_agg_add_array'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int2hashset_agg_final(p_pointer internal)
+RETURNS int2hashset
+AS 'hashset', 'int2hashset_agg_final'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int2hashset_agg_combine(p_pointer internal, p_pointer2 internal)
+RETURNS internal
+AS 'hashset', 'int2hashset_agg_combine'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION int2hashset_agg_serial(p_pointer internal)
+RETURNS bytea
+AS 'hashset', 'int2hashset_agg_serial'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int2hashset_agg_deserial(p_value bytea, p_pointer internal)
+RETURNS internal
+AS 'hashset', 'int2hashset_agg_deserial'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE AGGREGATE hashset_agg(smallint) (
+    SFUNC = int2hashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = int2hashset_agg_final,
+    COMBINEFUNC = int2hashset_agg_combine,
+    SERIALFUNC = int2hashset_agg_serial,
+    DESERIALFUNC = int2hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_agg(value smallint, expected_count int) (
+    SFUNC = int2hashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = int2hashset_agg_final,
+    COMBINEFUNC = int2hashset_agg_combine,
+    SERIALFUNC = int2hashset_agg_serial,
+    DESERIALFUNC = int2hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_agg(value smallint, expected_count int, load_factor float4, hashfn_id int) (
+    SFUNC = int2hashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = int2hashset_agg_final,
+    COMBINEFUNC = int2hashset_agg_combine,
+    SERIALFUNC = int2hashset_agg_serial,
+    DESERIALFUNC = int2hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_agg(int2hashset) (
+    SFUNC = int2hashset_agg_add_set,
+    STYPE = internal,
+    FINALFUNC = int2hashset_agg_final,
+    COMBINEFUNC = int2hashset_agg_combine,
+    SERIALFUNC = int2hashset_agg_serial,
+    DESERIALFUNC = int2hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_agg(smallint[]) (
+    SFUNC = int2hashset_agg_add_array,
+    STYPE = internal,
+    FINALFUNC = int2hashset_agg_final,
+    COMBINEFUNC = int2hashset_agg_combine,
+    SERIALFUNC = int2hashset_agg_serial,
+    DESERIALFUNC = int2hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+/*
+ * int2hashset Operators
+ */
+
+CREATE OR REPLACE FUNCTION hashset_eq(int2hashset, int2hashset)
+RETURNS boolean
+AS 'hashset', 'int2hashset_eq'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR = (
+    LEFTARG = int2hashset,
+    RIGHTARG = int2hashset,
+    PROCEDURE = hashset_eq,
+    COMMUTATOR = =,
+    HASHES
+);
+
+CREATE OR REPLACE FUNCTION hashset_ne(int2hashset, int2hashset)
+RETURNS boolean
+AS 'hashset', 'int2hashset_ne'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR <> (
+    LEFTARG = int2hashset,
+    RIGHTARG = int2hashset,
+    PROCEDURE = hashset_ne,
+    COMMUTATOR = '<>',
+    NEGATOR = '=',
+    RESTRICT = neqsel,
+    JOIN = neqjoinsel,
+    HASHES
+);
+
+CREATE OPERATOR || (
+    leftarg = int2hashset,
+    rightarg = smallint,
+    function = hashset_add,
+    commutator = ||
+);
+
+CREATE OPERATOR || (
+    leftarg = smallint,
+    rightarg = int2hashset,
+    function = int2_add_int2hashset,
+    commutator = ||
+);
+
+CREATE OPERATOR - (
+    leftarg = int2hashset,
+    rightarg = smallint,
+    function = hashset_remove
+);
+
+CREATE OPERATOR - (
+    leftarg = int2hashset,
+    rightarg = smallint[],
+    function = hashset_remove
+);
+
+CREATE OR REPLACE FUNCTION hashset_hash(int2hashset)
+RETURNS integer
+AS 'hashset', 'int2hashset_hash'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_hash_extended(int2hashset, bigint)
+RETURNS bigint
+AS 'hashset', 'int2hashset_hash_extended'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR CLASS int2hashset_hash_ops
+DEFAULT FOR TYPE int2hashset USING hash AS
+OPERATOR 1 = (int2hashset, int2hashset),
+FUNCTION 1 hashset_hash(int2hashset),
+FUNCTION 2 hashset_hash_extended(int2hashset, bigint);
+
+CREATE OR REPLACE FUNCTION hashset_lt(int2hashset, int2hashset)
+RETURNS boolean
+AS 'hashset', 'int2hashset_lt'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_le(int2hashset, int2hashset)
+RETURNS boolean
+AS 'hashset', 'int2hashset_le'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_gt(int2hashset, int2hashset)
+RETURNS boolean
+AS 'hashset', 'int2hashset_gt'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_ge(int2hashset, int2hashset)
+RETURNS boolean
+AS 'hashset', 'int2hashset_ge'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_cmp(int2hashset, int2hashset)
+RETURNS integer
+AS 'hashset', 'int2hashset_cmp'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int2hashset_sortsupport(internal)
+RETURNS void
+AS 'hashset', 'int2hashset_sortsupport'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR < (
+    PROCEDURE = hashset_lt,
+    LEFTARG = int2hashset,
+    RIGHTARG = int2hashset,
+    COMMUTATOR = >,
+    NEGATOR = >=,
+    RESTRICT = scalarltsel,
+    JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR <= (
+    PROCEDURE = hashset_le,
+    LEFTARG = int2hashset,
+    RIGHTARG = int2hashset,
+    COMMUTATOR = '>=',
+    NEGATOR = '>',
+    RESTRICT = scalarltsel,
+    JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR > (
+    PROCEDURE = hashset_gt,
+    LEFTARG = int2hashset,
+    RIGHTARG = int2hashset,
+    COMMUTATOR = '<',
+    NEGATOR = '<=',
+    RESTRICT = scalargtsel,
+    JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR >= (
+    PROCEDURE = hashset_ge,
+    LEFTARG = int2hashset,
+    RIGHTARG = int2hashset,
+    COMMUTATOR = '<=',
+    NEGATOR = '<',
+    RESTRICT = scalargtsel,
+    JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR CLASS int2hashset_btree_ops
+DEFAULT FOR TYPE int2hashset USING btree AS
+OPERATOR 1 < (int2hashset, int2hashset),
+OPERATOR 2 <= (int2hashset, int2hashset),
+OPERATOR 3 = (int2hashset, int2hashset),
+OPERATOR 4 >= (int2hashset, int2hashset),
+OPERATOR 5 > (int2hashset, int2hashset),
+FUNCTION 1 hashset_cmp(int2hashset, int2hashset),
+FUNCTION 2 int2hashset_sortsupport(internal);
+
+CREATE OR REPLACE FUNCTION int2hashset_sel(internal, oid, internal, integer)
+RETURNS float8
+AS 'hashset', 'int2hashset_sel'
+LANGUAGE C STABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int2hashset_joinsel(internal, oid, internal, int2, internal)
+RETURNS float8
+AS 'hashset', 'int2hashset_joinsel'
+LANGUAGE C STABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_is_superset(int2hashset, int2hashset)
+RETURNS boolean
+AS 'hashset', 'int2hashset_is_superset'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_is_subset(int2hashset, int2hashset)
+RETURNS boolean
+AS 'hashset', 'int2hashset_is_subset'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_overlaps(int2hashset, int2hashset)
+RETURNS boolean
+AS 'hashset', 'int2hashset_overlaps'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR @> (
+    PROCEDURE = hashset_is_superset,
+    LEFTARG = int2hashset,
+    RIGHTARG = int2hashset,
+    COMMUTATOR = '<@',
+    RESTRICT = int2hashset_sel,
+    JOIN = int2hashset_joinsel
+);
+
+CREATE OPERATOR <@ (
+    PROCEDURE = hashset_is_subset,
+    LEFTARG = int2hashset,
+    RIGHTARG = int2hashset,
+    COMMUTATOR = '@>',
+    RESTRICT = int2hashset_sel,
+    JOIN = int2hashset_joinsel
+);
+
+CREATE OPERATOR && (
+    PROCEDURE = hashset_overlaps,
+    LEFTARG = int2hashset,
+    RIGHTARG = int2hashset,
+    COMMUTATOR = &&,
+    RESTRICT = int2hashset_sel,
+    JOIN = int2hashset_joinsel
+);
+
+CREATE OPERATOR @> (
+    PROCEDURE = hashset_contains,
+    LEFTARG = int2hashset,
+    RIGHTARG = smallint,
+    RESTRICT = int2hashset_sel,
+    JOIN = int2hashset_joinsel
+);
+
+CREATE OR REPLACE FUNCTION hashset_gin_extract_value(int2hashset, internal, internal)
+RETURNS internal
+AS 'hashset', 'int2hashset_gin_extract_value'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_gin_extract_query(int2hashset, internal, int2, internal, internal, internal, internal)
+RETURNS internal
+AS 'hashset', 'int2hashset_gin_extract_query'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_gin_consistent(internal, int2, int2hashset, int4, internal, internal, internal, internal)
+RETURNS boolean
+AS 'hashset', 'int4hashset_gin_consistent'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR CLASS int2hashset_gin_ops
+DEFAULT FOR TYPE int2hashset USING gin AS
+OPERATOR 1 && (int2hashset, int2hashset),
+OPERATOR 2 @> (int2hashset, int2hashset),
+OPERATOR 3 <@ (int2hashset, int2hashset),
+OPERATOR 4 = (int2hashset, int2hashset),
+OPERATOR 5 @> (int2hashset, smallint),
+FUNCTION 1 btint2cmp(int2, int2),
+FUNCTION 2 hashset_gin_extract_value(int2hashset, internal, internal),
+FUNCTION 3 hashset_gin_extract_query(int2hashset, internal, int2, internal, internal, internal, internal),
+FUNCTION 4 hashset_gin_consistent(internal, int2, int2hashset, int4, internal, internal, internal, internal),
+STORAGE int2;
+
+/*
+ * texthashset Type Definition (text elements)
+ */
+
+CREATE TYPE texthashset;
+
+CREATE OR REPLACE FUNCTION texthashset_in(cstring)
+RETURNS texthashset
+AS 'hashset', 'texthashset_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION texthashset_out(texthashset)
+RETURNS cstring
+AS 'hashset', 'texthashset_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION texthashset_send(texthashset)
+RETURNS bytea
+AS 'hashset', 'texthashset_send'
+LANGUAGE C STABLE STRICT;
+
+CREATE OR REPLACE FUNCTION texthashset_recv(internal)
+RETURNS texthashset
+AS 'hashset', 'texthashset_recv'
+LANGUAGE C STABLE STRICT;
+
+CREATE TYPE texthashset (
+    INPUT = texthashset_in,
+    OUTPUT = texthashset_out,
+    RECEIVE = texthashset_recv,
+    SEND = texthashset_send,
+    INTERNALLENGTH = variable,
+    STORAGE = extended
+);
+
+/*
+ * texthashset Functions
+ */
+
+CREATE OR REPLACE FUNCTION texthashset(
+    capacity int DEFAULT 0,
+    load_factor float4 DEFAULT 0.75,
+    growth_factor float4 DEFAULT 2.0
+)
+RETURNS texthashset
+AS 'hashset', 'texthashset_init'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION hashset_add(texthashset, text)
+RETURNS texthashset
+AS 'hashset', 'texthashset_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION hashset_contains(texthashset, text)
+RETURNS boolean
+AS 'hashset', 'texthashset_contains'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION hashset_union(texthashset, texthashset)
+RETURNS texthashset
+AS 'hashset', 'texthashset_union'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_to_array(texthashset)
+RETURNS text[]
+AS 'hashset', 'texthashset_to_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_to_sorted_array(texthashset)
+RETURNS text[]
+AS 'hashset', 'texthashset_to_sorted_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_elements(texthashset)
+RETURNS SETOF text
+AS 'hashset', 'texthashset_elements'
+LANGUAGE C IMMUTABLE STRICT
+ROWS 100;
+
+CREATE OR REPLACE FUNCTION hashset_cardinality(texthashset)
+RETURNS bigint
+AS 'hashset', 'texthashset_cardinality'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_capacity(texthashset)
+RETURNS bigint
+AS 'hashset', 'texthashset_capacity'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION texthashset_from_array(text[])
+RETURNS texthashset
+AS 'hashset', 'texthashset_from_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (text[] AS texthashset)
+WITH FUNCTION texthashset_from_array(text[]);
+
+/*
+ * texthashset Aggregates
+ */
+
+CREATE OR REPLACE FUNCTION texthashset_agg_add(p_pointer internal, p_value text)
+RETURNS internal
+AS 'hashset', 'texthashset_agg_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION texthashset_agg_add_set(p_pointer internal, p_value texthashset)
+RETURNS internal
+AS 'hashset', 'texthashset_agg_add_set'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION texthashset_agg_final(p_pointer internal)
+RETURNS texthashset
+AS 'hashset', 'texthashset_agg_final'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION texthashset_agg_combine(p_pointer internal, p_pointer2 internal)
+RETURNS internal
+AS 'hashset', 'texthashset_agg_combine'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION texthashset_agg_serial(p_pointer internal)
+RETURNS bytea
+AS 'hashset', 'texthashset_agg_serial'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION texthashset_agg_deserial(p_value bytea, p_pointer internal)
+RETURNS internal
+AS 'hashset', 'texthashset_agg_deserial'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE AGGREGATE hashset_agg(text) (
+    SFUNC = texthashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = texthashset_agg_final,
+    COMBINEFUNC = texthashset_agg_combine,
+    SERIALFUNC = texthashset_agg_serial,
+    DESERIALFUNC = texthashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_agg(texthashset) (
+    SFUNC = texthashset_agg_add_set,
+    STYPE = internal,
+    FINALFUNC = texthashset_agg_final,
+    COMBINEFUNC = texthashset_agg_combine,
+    SERIALFUNC = texthashset_agg_serial,
+    DESERIALFUNC = texthashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+/*
+ * texthashset Operators
+ */
+
+CREATE OR REPLACE FUNCTION hashset_eq(texthashset, texthashset)
+RETURNS boolean
+AS 'hashset', 'texthashset_eq'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR = (
+    LEFTARG = texthashset,
+    RIGHTARG = texthashset,
+    PROCEDURE = hashset_eq,
+    COMMUTATOR = =,
+    HASHES
+);
+
+CREATE OR REPLACE FUNCTION hashset_ne(texthashset, texthashset)
+RETURNS boolean
+AS 'hashset', 'texthashset_ne'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR <> (
+    LEFTARG = texthashset,
+    RIGHTARG = texthashset,
+    PROCEDURE = hashset_ne,
+    COMMUTATOR = '<>',
+    NEGATOR = '=',
+    RESTRICT = neqsel,
+    JOIN = neqjoinsel,
+    HASHES
+);
+
+CREATE OPERATOR || (
+    leftarg = texthashset,
+    rightarg = text,
+    function = hashset_add
+);
+
+CREATE OPERATOR @> (
+    PROCEDURE = hashset_contains,
+    LEFTARG = texthashset,
+    RIGHTARG = text,
+    RESTRICT = contsel,
+    JOIN = contjoinsel
+);
+
+CREATE OR REPLACE FUNCTION hashset_hash(texthashset)
+RETURNS integer
+AS 'hashset', 'texthashset_hash'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_hash_extended(texthashset, bigint)
+RETURNS bigint
+AS 'hashset', 'texthashset_hash_extended'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR CLASS texthashset_hash_ops
+DEFAULT FOR TYPE texthashset USING hash AS
+OPERATOR 1 = (texthashset, texthashset),
+FUNCTION 1 hashset_hash(texthashset),
+FUNCTION 2 hashset_hash_extended(texthashset, bigint);
+
+/*
+ * approxhashset Type Definition (approximate distinct counting)
+ */
+
+CREATE TYPE approxhashset;
+
+CREATE OR REPLACE FUNCTION approxhashset_in(cstring)
+RETURNS approxhashset
+AS 'hashset', 'approxhashset_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION approxhashset_out(approxhashset)
+RETURNS cstring
+AS 'hashset', 'approxhashset_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION approxhashset_send(approxhashset)
+RETURNS bytea
+AS 'hashset', 'approxhashset_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION approxhashset_recv(internal)
+RETURNS approxhashset
+AS 'hashset', 'approxhashset_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE approxhashset (
+    INPUT = approxhashset_in,
+    OUTPUT = approxhashset_out,
+    RECEIVE = approxhashset_recv,
+    SEND = approxhashset_send,
+    INTERNALLENGTH = variable,
+    ALIGNMENT = double,
+    STORAGE = extended
+);
+
+/*
+ * approxhashset Functions
+ */
+
+CREATE OR REPLACE FUNCTION hashset_cardinality(approxhashset)
+RETURNS bigint
+AS 'hashset', 'approxhashset_cardinality'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_is_approximate(approxhashset)
+RETURNS boolean
+AS 'hashset', 'approxhashset_is_approximate'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_union(approxhashset, approxhashset)
+RETURNS approxhashset
+AS 'hashset', 'approxhashset_union'
+LANGUAGE C IMMUTABLE STRICT;
+
+/*
+ * approxhashset Aggregation Functions
+ */
+
+CREATE OR REPLACE FUNCTION approxhashset_agg_add(p_pointer internal, p_value anyelement)
+RETURNS internal
+AS 'hashset', 'approxhashset_agg_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION approxhashset_agg_add(p_pointer internal, p_value anyelement, p_threshold int)
+RETURNS internal
+AS 'hashset', 'approxhashset_agg_add'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION approxhashset_agg_add_set(p_pointer internal, p_value approxhashset)
+RETURNS internal
+AS 'hashset', 'approxhashset_agg_add_set'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION approxhashset_agg_final(p_pointer internal)
+RETURNS approxhashset
+AS 'hashset', 'approxhashset_agg_final'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION approxhashset_agg_combine(p_pointer internal, p_pointer2 internal)
+RETURNS internal
+AS 'hashset', 'approxhashset_agg_combine'
+LANGUAGE C IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION approxhashset_agg_serial(p_pointer internal)
+RETURNS bytea
+AS 'hashset', 'approxhashset_agg_serial'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION approxhashset_agg_deserial(p_value bytea, p_pointer internal)
+RETURNS internal
+AS 'hashset', 'approxhashset_agg_deserial'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE AGGREGATE hashset_approx_agg(anyelement) (
+    SFUNC = approxhashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = approxhashset_agg_final,
+    COMBINEFUNC = approxhashset_agg_combine,
+    SERIALFUNC = approxhashset_agg_serial,
+    DESERIALFUNC = approxhashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_approx_agg(value anyelement, threshold int) (
+    SFUNC = approxhashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = approxhashset_agg_final,
+    COMBINEFUNC = approxhashset_agg_combine,
+    SERIALFUNC = approxhashset_agg_serial,
+    DESERIALFUNC = approxhashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE hashset_approx_agg(approxhashset) (
+    SFUNC = approxhashset_agg_add_set,
+    STYPE = internal,
+    FINALFUNC = approxhashset_agg_final,
+    COMBINEFUNC = approxhashset_agg_combine,
+    SERIALFUNC = approxhashset_agg_serial,
+    DESERIALFUNC = approxhashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+/*
+ * int4bloom Type Definition (bloom filter built from an int4hashset)
+ */
+
+CREATE TYPE int4bloom;
+
+CREATE OR REPLACE FUNCTION int4bloom_in(cstring)
+RETURNS int4bloom
+AS 'hashset', 'int4bloom_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int4bloom_out(int4bloom)
+RETURNS cstring
+AS 'hashset', 'int4bloom_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int4bloom_send(int4bloom)
+RETURNS bytea
+AS 'hashset', 'int4bloom_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION int4bloom_recv(internal)
+RETURNS int4bloom
+AS 'hashset', 'int4bloom_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE int4bloom (
+    INPUT = int4bloom_in,
+    OUTPUT = int4bloom_out,
+    RECEIVE = int4bloom_recv,
+    SEND = int4bloom_send,
+    INTERNALLENGTH = variable,
+    ALIGNMENT = double,
+    STORAGE = extended
+);
+
+/*
+ * int4bloom Functions
+ */
+
+CREATE OR REPLACE FUNCTION hashset_to_bloom(int4hashset, fpr float8 DEFAULT 0.01)
+RETURNS int4bloom
+AS 'hashset', 'int4hashset_to_bloom'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_to_bloom(int4hashset, fpr float8, expected_count int)
+RETURNS int4bloom
+AS 'hashset', 'int4hashset_to_bloom'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION bloom_contains(int4bloom, int4)
+RETURNS boolean
+AS 'hashset', 'int4bloom_contains'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION bloom_contains_any(int4bloom, int4[])
+RETURNS boolean
+AS 'hashset', 'int4bloom_contains_any'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION bloom_union(int4bloom, int4bloom)
+RETURNS int4bloom
+AS 'hashset', 'int4bloom_union'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OPERATOR @> (
+    PROCEDURE = bloom_contains,
+    LEFTARG = int4bloom,
+    RIGHTARG = int4,
+    RESTRICT = contsel,
+    JOIN = contjoinsel
+);
+
+/*
+ * Changes to the 0.0.1 objects
+ */
+
+/*
+ * Only columns created from now on use the new storage (compressed), see
+ * ALTER TABLE ... SET STORAGE for the existing ones.
+ */
+ALTER TYPE int4hashset SET (
+    ANALYZE = int4hashset_typanalyze,
+    STORAGE = extended
+);
+
+ALTER FUNCTION hashset_add(int4hashset, int) SUPPORT int4hashset_support;
+
+ALTER FUNCTION hashset_union(int4hashset, int4hashset) SUPPORT int4hashset_support;
+
+ALTER FUNCTION hashset_contains(int4hashset, int) SUPPORT int4hashset_contains_support;
+
+CREATE OR REPLACE AGGREGATE hashset_agg(int) (
+    SFUNC = int4hashset_agg_add,
+    STYPE = internal,
+    FINALFUNC = int4hashset_agg_final,
+    COMBINEFUNC = int4hashset_agg_combine,
+    SERIALFUNC = int4hashset_agg_serial,
+    DESERIALFUNC = int4hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hashset_agg(int4hashset) (
+    SFUNC = int4hashset_agg_add_set,
+    STYPE = internal,
+    FINALFUNC = int4hashset_agg_final,
+    COMBINEFUNC = int4hashset_agg_combine,
+    SERIALFUNC = int4hashset_agg_serial,
+    DESERIALFUNC = int4hashset_agg_deserial,
+    PARALLEL = SAFE
+);
+
+ALTER OPERATOR FAMILY int4hashset_hash_ops USING hash ADD
+FUNCTION 2 hashset_hash_extended(int4hashset, bigint);
+
+ALTER OPERATOR FAMILY int4hashset_btree_ops USING btree ADD
+FUNCTION 2 (int4hashset, int4hashset) hashset_sortsupport(internal);
@@ -0,0 +1,813 @@
+/*
+ * hashset-approx.c
+ *
+ * approxhashset, a bounded-memory set used for (approximate) counting of
+ * distinct values.
+ *
+ * It does not keep the values themselves, only their 64-bit hashes. While
+ * there are at most "threshold" distinct hashes, they are kept in a simple
+ * hash table and the cardinality is exact (up to hash collisions, which
+ * are negligible for 64-bit hashes). Once there are more of them, the set
+ * switches to a HyperLogLog sketch with HASHSET_APPROX_REGISTERS one-byte
+ * registers, and the cardinality becomes an estimate (with a standard error
+ * of about 1.6%). So a group never needs more than a few kB of memory, no
+ * matter how many distinct values it has.
+ *
+ * Sketches are merged by taking the maximum of each register, so unions of
+ * sets (and the parallel combine step) don't lose any accuracy.
+ *
+ * The values are hashed using the extended hash function of their type (the
+ * one in the default hash opclass), so hashes of different types can't be
+ * compared. The sets remember the type of the values, and merging sets of
+ * different types is an error.
+ *
+ * The flat format is the header followed by either the sorted hashes, or
+ * the registers of the sketch.
+ */
+
+#include "hashset.h"
+
+#include <math.h>
+
+#include "utils/typcache.h"
+
+PG_FUNCTION_INFO_V1(approxhashset_in);
+PG_FUNCTION_INFO_V1(approxhashset_out);
+PG_FUNCTION_INFO_V1(approxhashset_send);
+PG_FUNCTION_INFO_V1(approxhashset_recv);
+PG_FUNCTION_INFO_V1(approxhashset_cardinality);
+PG_FUNCTION_INFO_V1(approxhashset_is_approximate);
+PG_FUNCTION_INFO_V1(approxhashset_union);
+PG_FUNCTION_INFO_V1(approxhashset_agg_add);
+PG_FUNCTION_INFO_V1(approxhashset_agg_add_set);
+PG_FUNCTION_INFO_V1(approxhashset_agg_final);
+PG_FUNCTION_INFO_V1(approxhashset_agg_combine);
+PG_FUNCTION_INFO_V1(approxhashset_agg_serial);
+PG_FUNCTION_INFO_V1(approxhashset_agg_deserial);
+
+Datum approxhashset_in(PG_FUNCTION_ARGS);
+Datum approxhashset_out(PG_FUNCTION_ARGS);
+Datum approxhashset_send(PG_FUNCTION_ARGS);
+Datum approxhashset_recv(PG_FUNCTION_ARGS);
+Datum approxhashset_cardinality(PG_FUNCTION_ARGS);
+Datum approxhashset_is_approximate(PG_FUNCTION_ARGS);
+Datum approxhashset_union(PG_FUNCTION_ARGS);
+Datum approxhashset_agg_add(PG_FUNCTION_ARGS);
+Datum approxhashset_agg_add_set(PG_FUNCTION_ARGS);
+Datum approxhashset_agg_final(PG_FUNCTION_ARGS);
+Datum approxhashset_agg_combine(PG_FUNCTION_ARGS);
+Datum approxhashset_agg_serial(PG_FUNCTION_ARGS);
+Datum approxhashset_agg_deserial(PG_FUNCTION_ARGS);
+
+/*
+ * The sketch uses 2^HASHSET_APPROX_PRECISION registers, selected by the
+ * high bits of the hash.
+ */
+#define HASHSET_APPROX_PRECISION	12
+#define HASHSET_APPROX_REGISTERS	(1 << HASHSET_APPROX_PRECISION)
+
+/*
+ * By default we switch to the sketch once the exact hashes would take more
+ * space than the registers. The threshold can be set higher, but the memory
+ * per group has to stay bounded - at the maximum, the flat set has 512kB of
+ * hashes, and the (at most half full) hash table of the state 1-2MB.
+ */
+#define HASHSET_APPROX_DEFAULT_THRESHOLD	(HASHSET_APPROX_REGISTERS / sizeof(uint64))
+#define HASHSET_APPROX_MAX_THRESHOLD		(1 << 16)
+
+/* Flags stored in approxhashset_t.flags */
+#define HASHSET_APPROX_FLAG_SKETCH 0x01
+#define HASHSET_APPROX_IS_SKETCH(set) (((set)->flags & HASHSET_APPROX_FLAG_SKETCH) != 0)
+
+typedef struct approxhashset_t {
+	int32		vl_len_;		/* Varlena header (do not touch directly!) */
+	int32		flags;			/* HASHSET_APPROX_FLAG_SKETCH */
+	int32		threshold;		/* Max number of exact hashes */
+	int32		nelements;		/* Number of exact hashes (0 for a sketch) */
+	Oid			elemtype;		/* Type of the values (InvalidOid if unknown) */
+	int32		unused;			/* Keeps the hashes aligned */
+	char		data[FLEXIBLE_ARRAY_MEMBER];	/* Sorted uint64 hashes, or
+												 * the uint8 registers */
+} approxhashset_t;
+
+#define APPROXHASHSET_HASHES(set)		((uint64 *) (set)->data)
+#define APPROXHASHSET_REGISTERS(set)	((uint8 *) (set)->data)
+
+#define PG_GETARG_APPROXHASHSET(x)	(approxhashset_t *) PG_DETOAST_DATUM(PG_GETARG_DATUM(x))
+
+/*
+ * In-memory representation, used while aggregating and merging sets.
+ *
+ * The exact hashes are kept in an open-addressing table with linear
+ * probing, where zero marks an empty slot (the zero hash itself is tracked
+ * separately). Once the set becomes a sketch, the table is freed.
+ */
+typedef struct approxhashset_state_t {
+	int32		threshold;		/* Max number of exact hashes */
+	Oid			elemtype;		/* Type of the values (InvalidOid if unknown) */
+	int32		nelements;		/* Number of exact hashes */
+	int32		capacity;		/* Number of slots (power of two) */
+	bool		has_zero;		/* Is the zero hash in the set? */
+	uint64	   *hashes;			/* Hash table (NULL for a sketch) */
+	uint8	   *registers;		/* Sketch registers (NULL while exact) */
+	MemoryContext mcxt;			/* Context holding the arrays */
+} approxhashset_state_t;
+
+/* Initial number of slots of the hash table */
+#define HASHSET_APPROX_INITIAL_CAPACITY 16
+
+/* The hash function of the aggregated type, cached in fn_extra */
+typedef struct approxhashset_hashfn_t {
+	Oid			typid;
+	FmgrInfo	proc;
+} approxhashset_hashfn_t;
+
+static void
+approxhashset_check_threshold(int32 threshold)
+{
+	if (threshold < 0 || threshold > HASHSET_APPROX_MAX_THRESHOLD)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("threshold must be between 0 and %d",
+						HASHSET_APPROX_MAX_THRESHOLD)));
+}
+
+static approxhashset_state_t *
+approxhashset_state_create(int32 threshold, Oid elemtype, MemoryContext mcxt)
+{
+	approxhashset_state_t *state;
+
+	state = MemoryContextAllocZero(mcxt, sizeof(approxhashset_state_t));
+	state->threshold = threshold;
+	state->elemtype = elemtype;
+	state->mcxt = mcxt;
+
+	if (threshold == 0)
+		state->registers = MemoryContextAllocZero(mcxt, HASHSET_APPROX_REGISTERS);
+
+	return state;
+}
+
+/*
+ * Check that values of elemtype can be merged into the state. A state of
+ * unknown type (sets received in the version 1 format) adopts the type.
+ */
+static void
+approxhashset_state_check_type(approxhashset_state_t *state, Oid elemtype)
+{
+	if (!OidIsValid(elemtype) || state->elemtype == elemtype)
+		return;
+
+	if (!OidIsValid(state->elemtype))
+	{
+		state->elemtype = elemtype;
+		return;
+	}
+
+	ereport(ERROR,
+			(errcode(ERRCODE_DATATYPE_MISMATCH),
+			 errmsg("cannot merge incompatible approxhashsets"),
+			 errdetail("Sets of values of types %s and %s are not compatible.",
+					   format_type_be(state->elemtype),
+					   format_type_be(elemtype))));
+}
+
+/*
+ * Update the sketch register for the hash. The high bits of the hash pick
+ * the register, the register keeps the max position of the leftmost one bit
+ * in the remaining bits.
+ */
+static inline void
+approxhashset_registers_add(uint8 *registers, uint64 hash)
+{
+	int		index = (int) (hash >> (64 - HASHSET_APPROX_PRECISION));
+	uint64	rest = hash << HASHSET_APPROX_PRECISION;
+	uint8	rank;
+
+	if (rest == 0)
+		rank = 64 - HASHSET_APPROX_PRECISION + 1;
+	else
+		rank = 63 - pg_leftmost_one_pos64(rest) + 1;
+
+	if (registers[index] < rank)
+		registers[index] = rank;
+}
+
+/* Switch the set to a sketch, adding the exact hashes to it */
+static void
+approxhashset_state_to_sketch(approxhashset_state_t *state)
+{
+	if (state->registers != NULL)
+		return;
+
+	state->registers = MemoryContextAllocZero(state->mcxt,
+											  HASHSET_APPROX_REGISTERS);
+
+	if (state->has_zero)
+		approxhashset_registers_add(state->registers, 0);
+
+	for (int32 i = 0; i < state->capacity; i++)
+	{
+		if (state->hashes[i] != 0)
+			approxhashset_registers_add(state->registers, state->hashes[i]);
+	}
+
+	if (state->hashes != NULL)
+		pfree(state->hashes);
+
+	state->hashes = NULL;
+	state->capacity = 0;
+	state->nelements = 0;
+	state->has_zero = false;
+}
+
+/* Insert a nonzero hash into the table, which must have a free slot */
+static inline bool
+approxhashset_table_insert(uint64 *hashes, int32 capacity, uint64 hash)
+{
+	uint32	mask = capacity - 1;
+	uint32	position = (uint32) hash & mask;
+
+	while (hashes[position] != 0)
+	{
+		if (hashes[position] == hash)
+			return false;
+
+		position = (position + 1) & mask;
+	}
+
+	hashes[position] = hash;
+
+	return true;
+}
+
+static void
+approxhashset_state_grow(approxhashset_state_t *state)
+{
+	int32	capacity = (state->capacity == 0) ? HASHSET_APPROX_INITIAL_CAPACITY :
+						state->capacity * 2;
+	uint64 *hashes = MemoryContextAllocZero(state->mcxt,
+											capacity * sizeof(uint64));
+
+	for (int32 i = 0; i < state->capacity; i++)
+	{
+		if (state->hashes[i] != 0)
+			approxhashset_table_insert(hashes, capacity, state->hashes[i]);
+	}
+
+	if (state->hashes != NULL)
+		pfree(state->hashes);
+
+	state->hashes = hashes;
+	state->capacity = capacity;
+}
+
+static void
+approxhashset_state_add(approxhashset_state_t *state, uint64 hash)
+{
+	if (state->registers != NULL)
+	{
+		approxhashset_registers_add(state->registers, hash);
+		return;
+	}
+
+	if (hash == 0)
+	{
+		if (state->has_zero)
+			return;
+
+		state->has_zero = true;
+	}
+	else
+	{
+		/* keep the table at most half full */
+		if (2 * (state->nelements + 1) > state->capacity)
+			approxhashset_state_grow(state);
+
+		if (!approxhashset_table_insert(state->hashes, state->capacity, hash))
+			return;
+	}
+
+	state->nelements++;
+
+	if (state->nelements > state->threshold)
+		approxhashset_state_to_sketch(state);
+}
+
+/* Add the elements of a flat set (or merge its sketch) into the state */
+static void
+approxhashset_state_add_set(approxhashset_state_t *state, approxhashset_t *set)
+{
+	approxhashset_state_check_type(state, set->elemtype);
+
+	if (HASHSET_APPROX_IS_SKETCH(set))
+	{
+		uint8  *registers = APPROXHASHSET_REGISTERS(set);
+
+		approxhashset_state_to_sketch(state);
+
+		for (int i = 0; i < HASHSET_APPROX_REGISTERS; i++)
+			state->registers[i] = Max(state->registers[i], registers[i]);
+	}
+	else
+	{
+		uint64 *hashes = APPROXHASHSET_HASHES(set);
+
+		for (int32 i = 0; i < set->nelements; i++)
+			approxhashset_state_add(state, hashes[i]);
+	}
+}
+
+static void
+approxhashset_state_merge(approxhashset_state_t *dst, approxhashset_state_t *src)
+{
+	approxhashset_state_check_type(dst, src->elemtype);
+
+	if (src->registers != NULL)
+	{
+		approxhashset_state_to_sketch(dst);
+
+		for (int i = 0; i < HASHSET_APPROX_REGISTERS; i++)
+			dst->registers[i] = Max(dst->registers[i], src->registers[i]);
+
+		return;
+	}
+
+	if (src->has_zero)
+		approxhashset_state_add(dst, 0);
+
+	for (int32 i = 0; i < src->capacity; i++)
+	{
+		if (src->hashes[i] != 0)
+			approxhashset_state_add(dst, src->hashes[i]);
+	}
+}
+
+/* qsort comparator for uint64 hashes */
+static int
+approxhashset_hash_cmp(const void *a, const void *b)
+{
+	uint64	ha = *(const uint64 *) a;
+	uint64	hb = *(const uint64 *) b;
+
+	return (ha > hb) - (ha < hb);
+}
+
+static approxhashset_t *
+approxhashset_state_flatten(approxhashset_state_t *state)
+{
+	approxhashset_t *set;
+	Size		size;
+
+	if (state->registers != NULL)
+	{
+		size = offsetof(approxhashset_t, data) + HASHSET_APPROX_REGISTERS;
+		set = palloc0(size);
+		set->flags = HASHSET_APPROX_FLAG_SKETCH;
+		memcpy(APPROXHASHSET_REGISTERS(set), state->registers,
+			   HASHSET_APPROX_REGISTERS);
+	}
+	else
+	{
+		uint64 *hashes;
+		int32	n = 0;
+
+		size = offsetof(approxhashset_t, data) +
+			(Size) state->nelements * sizeof(uint64);
+		set = palloc0(size);
+		set->nelements = state->nelements;
+
+		hashes = APPROXHASHSET_HASHES(set);
+
+		if (state->has_zero)
+			hashes[n++] = 0;
+
+		for (int32 i = 0; i < state->capacity; i++)
+		{
+			if (state->hashes[i] != 0)
+				hashes[n++] = state->hashes[i];
+		}
+
+		Assert(n == state->nelements);
+
+		qsort(hashes, n, sizeof(uint64), approxhashset_hash_cmp);
+	}
+
+	SET_VARSIZE(set, size);
+	set->threshold = state->threshold;
+	set->elemtype = state->elemtype;
+
+	return set;
+}
+
+/*
+ * approxhashset_estimate
+ *		HyperLogLog estimate of the number of distinct hashes in the sketch.
+ *
+ * Uses the linear counting estimate when the raw estimate is small and some
+ * registers are still empty. With 64-bit hashes no correction is needed for
+ * large cardinalities.
+ */
+static int64
+approxhashset_estimate(const uint8 *registers)
+{
+	double	m = HASHSET_APPROX_REGISTERS;
+	double	alpha = 0.7213 / (1.0 + 1.079 / m);
+	double	sum = 0.0;
+	int		nzeros = 0;
+	double	estimate;
+
+	for (int i = 0; i < HASHSET_APPROX_REGISTERS; i++)
+	{
+		sum += ldexp(1.0, -registers[i]);
+
+		if (registers[i] == 0)
+			nzeros++;
+	}
+
+	estimate = alpha * m * m / sum;
+
+	if (estimate <= 2.5 * m && nzeros > 0)
+		estimate = m * log(m / nzeros);
+
+	return (int64) rint(estimate);
+}
+
+/*
+ * The binary format is the version, the flags, the threshold and the OID of
+ * the type of the values (like in the binary format of arrays), followed by
+ * either the number of hashes and the hashes, or the precision and the
+ * registers of the sketch. The text format is the same bytes, hex-encoded
+ * the same way as bytea.
+ *
+ * Version 1 did not have the type, such sets are read as of unknown type.
+ */
+static bytea *
+approxhashset_serialize(approxhashset_t *set)
+{
+	StringInfoData	buf;
+
+	pq_begintypsend(&buf);
+
+	pq_sendint8(&buf, 2);		/* version */
+	pq_sendint8(&buf, set->flags);
+	pq_sendint32(&buf, set->threshold);
+	pq_sendint32(&buf, set->elemtype);
+
+	if (HASHSET_APPROX_IS_SKETCH(set))
+	{
+		pq_sendint8(&buf, HASHSET_APPROX_PRECISION);
+		pq_sendbytes(&buf, (char *) APPROXHASHSET_REGISTERS(set),
+					 HASHSET_APPROX_REGISTERS);
+	}
+	else
+	{
+		uint64 *hashes = APPROXHASHSET_HASHES(set);
+
+		pq_sendint32(&buf, set->nelements);
+
+		for (int32 i = 0; i < set->nelements; i++)
+			pq_sendint64(&buf, hashes[i]);
+	}
+
+	return pq_endtypsend(&buf);
+}
+
+static approxhashset_t *
+approxhashset_deserialize(StringInfo buf)
+{
+	approxhashset_state_t *state;
+	int			version;
+	int			flags;
+	int32		threshold;
+	Oid			elemtype = InvalidOid;
+
+	version = pq_getmsgint(buf, 1);
+	if (version != 1 && version != 2)
+		elog(ERROR, "unsupported hashset version number %d", version);
+
+	flags = pq_getmsgint(buf, 1);
+	threshold = pq_getmsgint(buf, 4);
+
+	if (version >= 2)
+		elemtype = pq_getmsgint(buf, 4);
+
+	if ((flags & ~HASHSET_APPROX_FLAG_SKETCH) != 0 ||
+		threshold < 0 || threshold > HASHSET_APPROX_MAX_THRESHOLD)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid hashset parameters")));
+
+	state = approxhashset_state_create(threshold, elemtype, CurrentMemoryContext);
+
+	if (flags & HASHSET_APPROX_FLAG_SKETCH)
+	{
+		int		precision = pq_getmsgint(buf, 1);
+		const uint8 *registers;
+
+		if (precision != HASHSET_APPROX_PRECISION)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+					 errmsg("unsupported hashset precision %d", precision)));
+
+		registers = (const uint8 *) pq_getmsgbytes(buf, HASHSET_APPROX_REGISTERS);
+
+		approxhashset_state_to_sketch(state);
+
+		for (int i = 0; i < HASHSET_APPROX_REGISTERS; i++)
+		{
+			if (registers[i] > 64 - HASHSET_APPROX_PRECISION + 1)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+						 errmsg("invalid hashset register value")));
+
+			state->registers[i] = registers[i];
+		}
+	}
+	else
+	{
+		int32	nelements = pq_getmsgint(buf, 4);
+
+		if (nelements < 0 ||
+			nelements > (buf->len - buf->cursor) / sizeof(uint64))
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+					 errmsg("invalid hashset size")));
+
+		/*
+		 * Duplicates are simply ignored, and a set with too many hashes
+		 * becomes a sketch, so we don't need to trust the sender with that.
+		 */
+		for (int32 i = 0; i < nelements; i++)
+			approxhashset_state_add(state, (uint64) pq_getmsgint64(buf));
+	}
+
+	pq_getmsgend(buf);
+
+	return approxhashset_state_flatten(state);
+}
+
+/*
+ * Hash a value of the aggregated type, using its extended hash function.
+ * The result is mixed once more, as the sketch relies on all bits of the
+ * hash being uniformly distributed.
+ */
+static uint64
+approxhashset_hash_value(FunctionCallInfo fcinfo, int argno)
+{
+	approxhashset_hashfn_t *hashfn = (approxhashset_hashfn_t *) fcinfo->flinfo->fn_extra;
+	Oid			typid = get_fn_expr_argtype(fcinfo->flinfo, argno);
+	Datum		hash;
+
+	if (hashfn == NULL || hashfn->typid != typid)
+	{
+		TypeCacheEntry *typentry;
+
+		if (!OidIsValid(typid))
+			elog(ERROR, "could not determine data type of input");
+
+		typentry = lookup_type_cache(typid, TYPECACHE_HASH_EXTENDED_PROC);
+
+		if (!OidIsValid(typentry->hash_extended_proc))
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_FUNCTION),
+					 errmsg("could not identify an extended hash function for type %s",
+							format_type_be(typid))));
+
+		if (hashfn == NULL)
+			hashfn = MemoryContextAlloc(fcinfo->flinfo->fn_mcxt,
+										sizeof(approxhashset_hashfn_t));
+
+		hashfn->typid = typid;
+		fmgr_info_cxt(typentry->hash_extended_proc, &hashfn->proc,
+					  fcinfo->flinfo->fn_mcxt);
+
+		fcinfo->flinfo->fn_extra = hashfn;
+	}
+
+	hash = FunctionCall2Coll(&hashfn->proc, PG_GET_COLLATION(),
+							 PG_GETARG_DATUM(argno), Int64GetDatum(0));
+
+	return hashset_mix64(DatumGetUInt64(hash));
+}
+
+Datum
+approxhashset_in(PG_FUNCTION_ARGS)
+{
+	char	   *str = PG_GETARG_CSTRING(0);
+	bytea	   *bytes;
+	StringInfoData buf;
+
+	bytes = DatumGetByteaPP(DirectFunctionCall1(byteain, CStringGetDatum(str)));
+
+	buf.data = VARDATA_ANY(bytes);
+	buf.len = VARSIZE_ANY_EXHDR(bytes);
+	buf.maxlen = buf.len;
+	buf.cursor = 0;
+
+	PG_RETURN_POINTER(approxhashset_deserialize(&buf));
+}
+
+Datum
+approxhashset_out(PG_FUNCTION_ARGS)
+{
+	approxhashset_t *set = PG_GETARG_APPROXHASHSET(0);
+
+	PG_RETURN_DATUM(DirectFunctionCall1(byteaout,
+										PointerGetDatum(approxhashset_serialize(set))));
+}
+
+Datum
+approxhashset_send(PG_FUNCTION_ARGS)
+{
+	approxhashset_t *set = PG_GETARG_APPROXHASHSET(0);
+
+	PG_RETURN_BYTEA_P(approxhashset_serialize(set));
+}
+
+Datum
+approxhashset_recv(PG_FUNCTION_ARGS)
+{
+	StringInfo	buf = (StringInfo) PG_GETARG_POINTER(0);
+
+	PG_RETURN_POINTER(approxhashset_deserialize(buf));
+}
+
+Datum
+approxhashset_cardinality(PG_FUNCTION_ARGS)
+{
+	approxhashset_t *set = PG_GETARG_APPROXHASHSET(0);
+
+	if (HASHSET_APPROX_IS_SKETCH(set))
+		PG_RETURN_INT64(approxhashset_estimate(APPROXHASHSET_REGISTERS(set)));
+
+	PG_RETURN_INT64(set->nelements);
+}
+
+Datum
+approxhashset_is_approximate(PG_FUNCTION_ARGS)
+{
+	approxhashset_t *set = PG_GETARG_APPROXHASHSET(0);
+
+	PG_RETURN_BOOL(HASHSET_APPROX_IS_SKETCH(set));
+}
+
+/*
+ * The union keeps the lower of the two thresholds, so that it does not need
+ * more memory than either of the sets was allowed to. The sets have to be of
+ * the same type.
+ */
+Datum
+approxhashset_union(PG_FUNCTION_ARGS)
+{
+	approxhashset_t *seta = PG_GETARG_APPROXHASHSET(0);
+	approxhashset_t *setb = PG_GETARG_APPROXHASHSET(1);
+	approxhashset_state_t *state;
+
+	state = approxhashset_state_create(Min(seta->threshold, setb->threshold),
+									   seta->elemtype, CurrentMemoryContext);
+
+	approxhashset_state_add_set(state, seta);
+	approxhashset_state_add_set(state, setb);
+
+	PG_RETURN_POINTER(approxhashset_state_flatten(state));
+}
+
+/*
+ * Aggregates
+ *
+ * The state is the in-memory set, allocated in the aggregate context. The
+ * threshold (the optional second argument) is only looked at when creating
+ * the state. NULL values are skipped.
+ */
+Datum
+approxhashset_agg_add(PG_FUNCTION_ARGS)
+{
+	MemoryContext	aggcontext;
+	approxhashset_state_t *state;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_approx_agg_add called in non-aggregate context");
+
+	if (PG_ARGISNULL(0))
+	{
+		int32	threshold = HASHSET_APPROX_DEFAULT_THRESHOLD;
+
+		if (PG_NARGS() > 2 && !PG_ARGISNULL(2))
+			threshold = PG_GETARG_INT32(2);
+
+		approxhashset_check_threshold(threshold);
+
+		state = approxhashset_state_create(threshold,
+										   get_fn_expr_argtype(fcinfo->flinfo, 1),
+										   aggcontext);
+	}
+	else
+		state = (approxhashset_state_t *) PG_GETARG_POINTER(0);
+
+	if (!PG_ARGISNULL(1))
+		approxhashset_state_add(state, approxhashset_hash_value(fcinfo, 1));
+
+	PG_RETURN_POINTER(state);
+}
+
+Datum
+approxhashset_agg_add_set(PG_FUNCTION_ARGS)
+{
+	MemoryContext	aggcontext;
+	approxhashset_state_t *state;
+	approxhashset_t *set;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_approx_agg_add_set called in non-aggregate context");
+
+	if (PG_ARGISNULL(1))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+	}
+
+	set = PG_GETARG_APPROXHASHSET(1);
+
+	/* the first set determines the threshold */
+	if (PG_ARGISNULL(0))
+		state = approxhashset_state_create(set->threshold, set->elemtype,
+										   aggcontext);
+	else
+		state = (approxhashset_state_t *) PG_GETARG_POINTER(0);
+
+	approxhashset_state_add_set(state, set);
+
+	PG_RETURN_POINTER(state);
+}
+
+Datum
+approxhashset_agg_final(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_POINTER(approxhashset_state_flatten(
+		(approxhashset_state_t *) PG_GETARG_POINTER(0)));
+}
+
+Datum
+approxhashset_agg_combine(PG_FUNCTION_ARGS)
+{
+	MemoryContext	aggcontext;
+	approxhashset_state_t *src;
+	approxhashset_state_t *dst;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_approx_agg_combine called in non-aggregate context");
+
+	if (PG_ARGISNULL(1))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+	}
+
+	src = (approxhashset_state_t *) PG_GETARG_POINTER(1);
+
+	if (PG_ARGISNULL(0))
+		dst = approxhashset_state_create(src->threshold, src->elemtype,
+										 aggcontext);
+	else
+		dst = (approxhashset_state_t *) PG_GETARG_POINTER(0);
+
+	approxhashset_state_merge(dst, src);
+
+	PG_RETURN_POINTER(dst);
+}
+
+/* The serialized state is simply the flat set */
+Datum
+approxhashset_agg_serial(PG_FUNCTION_ARGS)
+{
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "hashset_approx_agg_serial called in non-aggregate context");
+
+	PG_RETURN_BYTEA_P((bytea *) approxhashset_state_flatten(
+		(approxhashset_state_t *) PG_GETARG_POINTER(0)));
+}
+
+Datum
+approxhashset_agg_deserial(PG_FUNCTION_ARGS)
+{
+	MemoryContext	aggcontext;
+	approxhashset_t *set;
+	approxhashset_state_t *state;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_approx_agg_deserial called in non-aggregate context");
+
+	/* make sure the data is properly aligned */
+	set = (approxhashset_t *) PG_DETOAST_DATUM_COPY(PG_GETARG_DATUM(0));
+
+	state = approxhashset_state_create(set->threshold, set->elemtype,
+									   aggcontext);
+	approxhashset_state_add_set(state, set);
+
+	PG_RETURN_POINTER(state);
+}
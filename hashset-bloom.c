@@ -0,0 +1,385 @@
+/*
+ * hashset-bloom.c
+ *
+ * int4bloom, a bloom filter built from an int4hashset.
+ *
+ * The filter answers "definitely not in the set" or "maybe in the set",
+ * using a fraction of the space of the set itself (about 1.2 bytes per
+ * element for a 1% false positive rate). It is meant to stand in for a
+ * large set on paths where most lookups miss, and to be shipped to clients.
+ *
+ * The bits of an element are derived from a single 64-bit hash, the fixed
+ * hashset_mix64 mixer of the value (as uint32), independent of the hash
+ * function of the set. The low and high halves of the hash are combined
+ * (h1 + i * h2) to get nhashes 32-bit values, each mapped to a bit position
+ * in [0, nbits) by multiplication (instead of a modulo). So filters with the
+ * same parameters can be merged by OR-ing the bits, and clients can probe
+ * them without knowing anything else about the extension.
+ */
+
+#include "hashset.h"
+
+#include <math.h>
+
+PG_FUNCTION_INFO_V1(int4bloom_in);
+PG_FUNCTION_INFO_V1(int4bloom_out);
+PG_FUNCTION_INFO_V1(int4bloom_send);
+PG_FUNCTION_INFO_V1(int4bloom_recv);
+PG_FUNCTION_INFO_V1(int4hashset_to_bloom);
+PG_FUNCTION_INFO_V1(int4bloom_contains);
+PG_FUNCTION_INFO_V1(int4bloom_contains_any);
+PG_FUNCTION_INFO_V1(int4bloom_union);
+
+Datum int4bloom_in(PG_FUNCTION_ARGS);
+Datum int4bloom_out(PG_FUNCTION_ARGS);
+Datum int4bloom_send(PG_FUNCTION_ARGS);
+Datum int4bloom_recv(PG_FUNCTION_ARGS);
+Datum int4hashset_to_bloom(PG_FUNCTION_ARGS);
+Datum int4bloom_contains(PG_FUNCTION_ARGS);
+Datum int4bloom_contains_any(PG_FUNCTION_ARGS);
+Datum int4bloom_union(PG_FUNCTION_ARGS);
+
+/* Limits on the filter parameters (the bits take at most 256MB) */
+#define INT4BLOOM_MIN_BITS		64
+#define INT4BLOOM_MAX_BITS		((int64) 1 << 31)
+#define INT4BLOOM_MAX_HASHES	16
+
+typedef struct int4bloom_t {
+	int32		vl_len_;		/* Varlena header (do not touch directly!) */
+	int32		flags;			/* Reserved for future use (versioning, ...) */
+	int32		nbits;			/* Number of bits (a multiple of 64) */
+	int32		nhashes;		/* Number of bits set per element */
+	int32		nelements;		/* Number of elements added (at most) */
+	int32		pad;			/* Keep the bits aligned */
+	uint64		bits[FLEXIBLE_ARRAY_MEMBER];
+} int4bloom_t;
+
+#define INT4BLOOM_SIZE(nbits) \
+	(offsetof(int4bloom_t, bits) + ((nbits) / 64) * sizeof(uint64))
+
+#define PG_GETARG_INT4BLOOM(x)	(int4bloom_t *) PG_DETOAST_DATUM(PG_GETARG_DATUM(x))
+
+static int4bloom_t *
+int4bloom_allocate(int32 nbits, int32 nhashes)
+{
+	Size			size = INT4BLOOM_SIZE(nbits);
+	int4bloom_t	   *bloom = palloc0(size);
+
+	SET_VARSIZE(bloom, size);
+	bloom->nbits = nbits;
+	bloom->nhashes = nhashes;
+
+	return bloom;
+}
+
+/*
+ * int4bloom_create
+ *		Allocate a filter sized for nelements with the false positive rate.
+ *
+ * Uses the usual optimal parameters, nbits = -n * ln(fpr) / ln(2)^2 (rounded
+ * up to whole words) and nhashes = nbits / n * ln(2).
+ */
+static int4bloom_t *
+int4bloom_create(int64 nelements, float8 fpr)
+{
+	double	n = Max(nelements, 1);
+	double	nbits;
+	int32	nhashes;
+
+	if (!(fpr > 0.0 && fpr < 1.0))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("false positive rate must be between 0.0 and 1.0")));
+
+	nbits = ceil(-n * log(fpr) / (M_LN2 * M_LN2));
+	nbits = Max(INT4BLOOM_MIN_BITS, ceil(nbits / 64) * 64);
+
+	if (nbits > INT4BLOOM_MAX_BITS - 64)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("bloom filter would be too large")));
+
+	nhashes = (int32) rint(nbits / n * M_LN2);
+	nhashes = Max(1, Min(nhashes, INT4BLOOM_MAX_HASHES));
+
+	return int4bloom_allocate((int32) nbits, nhashes);
+}
+
+/*
+ * The two 32-bit halves of the element hash. The second one is odd, so
+ * that the positions differ even when it's (almost) zero.
+ */
+static inline void
+int4bloom_hash(int32 value, uint32 *h1, uint32 *h2)
+{
+	uint64	hash = hashset_mix64((uint64) (uint32) value);
+
+	*h1 = (uint32) hash;
+	*h2 = (uint32) (hash >> 32) | 1;
+}
+
+static inline uint32
+int4bloom_position(int4bloom_t *bloom, uint32 h1, uint32 h2, int i)
+{
+	uint32	h = h1 + (uint32) i * h2;
+
+	return (uint32) (((uint64) h * (uint32) bloom->nbits) >> 32);
+}
+
+static void
+int4bloom_add(int4bloom_t *bloom, int32 value)
+{
+	uint32	h1;
+	uint32	h2;
+
+	int4bloom_hash(value, &h1, &h2);
+
+	for (int i = 0; i < bloom->nhashes; i++)
+	{
+		uint32	pos = int4bloom_position(bloom, h1, h2, i);
+
+		bloom->bits[pos / 64] |= UINT64CONST(1) << (pos % 64);
+	}
+}
+
+static inline bool
+int4bloom_test(int4bloom_t *bloom, uint32 h1, uint32 h2)
+{
+	for (int i = 0; i < bloom->nhashes; i++)
+	{
+		uint32	pos = int4bloom_position(bloom, h1, h2, i);
+
+		if ((bloom->bits[pos / 64] & (UINT64CONST(1) << (pos % 64))) == 0)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * The binary format is the version and the header fields, followed by the
+ * bits as int8 words (bit b is bit b % 64 of word b / 64). The text format
+ * is the same bytes, hex-encoded the same way as bytea.
+ */
+static bytea *
+int4bloom_serialize(int4bloom_t *bloom)
+{
+	StringInfoData	buf;
+
+	pq_begintypsend(&buf);
+
+	pq_sendint8(&buf, 1);		/* version */
+	pq_sendint32(&buf, bloom->nbits);
+	pq_sendint32(&buf, bloom->nhashes);
+	pq_sendint32(&buf, bloom->nelements);
+
+	for (int32 i = 0; i < bloom->nbits / 64; i++)
+		pq_sendint64(&buf, bloom->bits[i]);
+
+	return pq_endtypsend(&buf);
+}
+
+static int4bloom_t *
+int4bloom_deserialize(StringInfo buf)
+{
+	int4bloom_t	   *bloom;
+	int				version;
+	int32			nbits;
+	int32			nhashes;
+	int32			nelements;
+
+	version = pq_getmsgint(buf, 1);
+	if (version != 1)
+		elog(ERROR, "unsupported hashset version number %d", version);
+
+	nbits = pq_getmsgint(buf, 4);
+	nhashes = pq_getmsgint(buf, 4);
+	nelements = pq_getmsgint(buf, 4);
+
+	if (nbits < INT4BLOOM_MIN_BITS || nbits % 64 != 0 ||
+		nbits / 64 != (buf->len - buf->cursor) / sizeof(uint64) ||
+		nhashes < 1 || nhashes > INT4BLOOM_MAX_HASHES || nelements < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid bloom filter parameters")));
+
+	bloom = int4bloom_allocate(nbits, nhashes);
+	bloom->nelements = nelements;
+
+	for (int32 i = 0; i < nbits / 64; i++)
+		bloom->bits[i] = (uint64) pq_getmsgint64(buf);
+
+	pq_getmsgend(buf);
+
+	return bloom;
+}
+
+Datum
+int4bloom_in(PG_FUNCTION_ARGS)
+{
+	char	   *str = PG_GETARG_CSTRING(0);
+	bytea	   *bytes;
+	StringInfoData buf;
+
+	bytes = DatumGetByteaPP(DirectFunctionCall1(byteain, CStringGetDatum(str)));
+
+	buf.data = VARDATA_ANY(bytes);
+	buf.len = VARSIZE_ANY_EXHDR(bytes);
+	buf.maxlen = buf.len;
+	buf.cursor = 0;
+
+	PG_RETURN_POINTER(int4bloom_deserialize(&buf));
+}
+
+Datum
+int4bloom_out(PG_FUNCTION_ARGS)
+{
+	int4bloom_t	   *bloom = PG_GETARG_INT4BLOOM(0);
+
+	PG_RETURN_DATUM(DirectFunctionCall1(byteaout,
+										PointerGetDatum(int4bloom_serialize(bloom))));
+}
+
+Datum
+int4bloom_send(PG_FUNCTION_ARGS)
+{
+	int4bloom_t	   *bloom = PG_GETARG_INT4BLOOM(0);
+
+	PG_RETURN_BYTEA_P(int4bloom_serialize(bloom));
+}
+
+Datum
+int4bloom_recv(PG_FUNCTION_ARGS)
+{
+	StringInfo	buf = (StringInfo) PG_GETARG_POINTER(0);
+
+	PG_RETURN_POINTER(int4bloom_deserialize(buf));
+}
+
+/*
+ * int4hashset_to_bloom
+ *		Build a bloom filter from the elements of the hashset.
+ *
+ * The filter is sized for the number of elements in the set, or for the
+ * expected_count (the optional third argument), so that filters built from
+ * different sets can be merged. The NULL element is not included. The
+ * elements are read directly from either format of the set, without
+ * rebuilding the hash table.
+ */
+Datum
+int4hashset_to_bloom(PG_FUNCTION_ARGS)
+{
+	int4hashset_t		   *set = PG_GETARG_INT4HASHSET_ANY(0);
+	float8					fpr = PG_GETARG_FLOAT8(1);
+	int64					expected = set->nelements;
+	int4bloom_t			   *bloom;
+	int4hashset_iterator_t	iter;
+	int32					value;
+
+	if (PG_NARGS() > 2)
+	{
+		expected = PG_GETARG_INT32(2);
+
+		if (expected < 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("expected count cannot be negative")));
+	}
+
+	bloom = int4bloom_create(expected, fpr);
+	bloom->nelements = set->nelements;
+
+	int4hashset_iterator_init(&iter, set);
+	while (int4hashset_iterator_next(&iter, &value))
+		int4bloom_add(bloom, value);
+
+	PG_RETURN_POINTER(bloom);
+}
+
+Datum
+int4bloom_contains(PG_FUNCTION_ARGS)
+{
+	int4bloom_t	   *bloom = PG_GETARG_INT4BLOOM(0);
+	uint32			h1;
+	uint32			h2;
+
+	int4bloom_hash(PG_GETARG_INT32(1), &h1, &h2);
+
+	PG_RETURN_BOOL(int4bloom_test(bloom, h1, h2));
+}
+
+/*
+ * int4bloom_contains_any
+ *		Check if the filter may contain any of the array elements.
+ *
+ * Same as "bloom_contains(bloom, x)" OR-ed over the array elements, so the
+ * result is NULL if none of the elements may be contained but the array
+ * has NULL elements. The values are hashed in batches, prefetching the
+ * first word of each, as the filter may be much larger than the caches.
+ */
+Datum
+int4bloom_contains_any(PG_FUNCTION_ARGS)
+{
+	int4bloom_t	   *bloom = PG_GETARG_INT4BLOOM(0);
+	ArrayType	   *array = PG_GETARG_ARRAYTYPE_P(1);
+	int32		   *values;
+	int				nvalues;
+	bool			has_null;
+
+	values = int4hashset_array_values(array, &nvalues, &has_null);
+
+	for (int i = 0; i < nvalues; i += HASHSET_BATCH_SIZE)
+	{
+		int		n = Min(HASHSET_BATCH_SIZE, nvalues - i);
+		uint32	h1[HASHSET_BATCH_SIZE];
+		uint32	h2[HASHSET_BATCH_SIZE];
+
+		for (int j = 0; j < n; j++)
+		{
+			int4bloom_hash(values[i + j], &h1[j], &h2[j]);
+			hashset_prefetch(&bloom->bits[int4bloom_position(bloom, h1[j], h2[j], 0) / 64]);
+		}
+
+		for (int j = 0; j < n; j++)
+		{
+			if (int4bloom_test(bloom, h1[j], h2[j]))
+				PG_RETURN_BOOL(true);
+		}
+	}
+
+	if (has_null)
+		PG_RETURN_NULL();
+
+	PG_RETURN_BOOL(false);
+}
+
+/*
+ * int4bloom_union
+ *		Merge two filters with the same parameters.
+ *
+ * The result may contain everything either of the filters may contain, and
+ * is the same as a filter built from the union of the sets (except for the
+ * nelements estimate, which is just the sum).
+ */
+Datum
+int4bloom_union(PG_FUNCTION_ARGS)
+{
+	int4bloom_t	   *a = PG_GETARG_INT4BLOOM(0);
+	int4bloom_t	   *b = PG_GETARG_INT4BLOOM(1);
+	int4bloom_t	   *result;
+
+	if (a->nbits != b->nbits || a->nhashes != b->nhashes)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot merge bloom filters with different parameters"),
+				 errdetail("Filters have %d bits and %d hashes, and %d bits and %d hashes.",
+						   a->nbits, a->nhashes, b->nbits, b->nhashes)));
+
+	result = int4bloom_allocate(a->nbits, a->nhashes);
+	result->nelements = (int32) Min((int64) a->nelements + b->nelements, PG_INT32_MAX);
+
+	for (int32 i = 0; i < a->nbits / 64; i++)
+		result->bits[i] = a->bits[i] | b->bits[i];
+
+	PG_RETURN_POINTER(result);
+}
@@ -0,0 +1,480 @@
+/*
+ * hashset-containers.c
+ *
+ * Container encoding of compact hashsets (see HASHSET_FLAG_CONTAINERS).
+ *
+ * Sets of sequential or clustered elements are common (IDs generated by
+ * sequences, generate_series, ...), and for those even the varint encoding
+ * needs a byte per element. The container encoding splits the elements
+ * into chunks of 65536 values and picks the smallest container for each -
+ * a sorted array for sparse chunks, a bitmap for dense ones, and a list of
+ * runs for contiguous ranges. The compact format uses it whenever it's
+ * smaller than the varints.
+ *
+ * Unlike the varints, the containers can be searched directly: a lookup is
+ * a binary search in the chunk directory, followed by a bit test or another
+ * binary search, so the hash table does not need to be rebuilt even for
+ * many lookups. Intersections of two such sets are done chunk by chunk,
+ * AND-ing the words of two bitmaps.
+ */
+
+#include "hashset.h"
+
+/*
+ * hashset_containers_plan
+ *		Split the sorted (and distinct) values into chunks, and pick the
+ *		container for each of them.
+ *
+ * Returns the chunk directory and sets the number of chunks and the length
+ * of the encoded data.
+ */
+static hashset_chunk_t *
+hashset_containers_plan(const int32 *values, int nvalues, uint32 *nchunks,
+						Size *len)
+{
+	hashset_chunk_t	   *chunks;
+	uint32				offset = 0;
+	int					i = 0;
+
+	chunks = palloc(Max(Min(nvalues, 65536), 1) * sizeof(hashset_chunk_t));
+	*nchunks = 0;
+
+	while (i < nvalues)
+	{
+		hashset_chunk_t	   *chunk = &chunks[(*nchunks)++];
+		int					start = i;
+		uint32				nruns = 1;
+		Size				array_size;
+		Size				runs_size;
+
+		chunk->key = HASHSET_CHUNK_KEY(values[i]);
+
+		for (i++; i < nvalues && HASHSET_CHUNK_KEY(values[i]) == chunk->key; i++)
+		{
+			if (HASHSET_CHUNK_LOW(values[i]) != HASHSET_CHUNK_LOW(values[i - 1]) + 1)
+				nruns++;
+		}
+
+		array_size = (i - start) * sizeof(uint16);
+		runs_size = nruns * 2 * sizeof(uint16);
+
+		chunk->offset = offset;
+
+		if (runs_size < array_size && runs_size < HASHSET_BITMAP_SIZE)
+		{
+			chunk->type = HASHSET_CONTAINER_RUNS;
+			chunk->count = nruns;
+			offset += runs_size;
+		}
+		else if (array_size <= HASHSET_BITMAP_SIZE)
+		{
+			chunk->type = HASHSET_CONTAINER_ARRAY;
+			chunk->count = i - start;
+			offset += array_size;
+		}
+		else
+		{
+			chunk->type = HASHSET_CONTAINER_BITMAP;
+			chunk->count = i - start;
+			offset += HASHSET_BITMAP_SIZE;
+		}
+	}
+
+	*len = sizeof(uint32) + *nchunks * sizeof(hashset_chunk_t) + offset;
+
+	return chunks;
+}
+
+/*
+ * hashset_containers_length
+ *		Length of the container encoding of the sorted (and distinct) values.
+ */
+Size
+hashset_containers_length(const int32 *values, int nvalues)
+{
+	uint32				nchunks;
+	Size				len;
+	hashset_chunk_t	   *chunks;
+
+	chunks = hashset_containers_plan(values, nvalues, &nchunks, &len);
+	pfree(chunks);
+
+	return len;
+}
+
+/*
+ * hashset_containers_encode
+ *		Write the container encoding of the sorted (and distinct) values.
+ *
+ * The data needs hashset_containers_length() bytes.
+ */
+void
+hashset_containers_encode(char *data, const int32 *values, int nvalues)
+{
+	uint32				nchunks;
+	Size				len;
+	hashset_chunk_t	   *chunks;
+	char			   *containers;
+	int					i = 0;
+
+	chunks = hashset_containers_plan(values, nvalues, &nchunks, &len);
+
+	memcpy(data, &nchunks, sizeof(uint32));
+	memcpy(data + sizeof(uint32), chunks, nchunks * sizeof(hashset_chunk_t));
+	containers = data + sizeof(uint32) + nchunks * sizeof(hashset_chunk_t);
+
+	for (uint32 c = 0; c < nchunks; c++)
+	{
+		hashset_chunk_t	   *chunk = &chunks[c];
+		char			   *ptr = containers + chunk->offset;
+
+		switch (chunk->type)
+		{
+			case HASHSET_CONTAINER_ARRAY:
+				for (uint32 j = 0; j < chunk->count; j++)
+				{
+					uint16	low = HASHSET_CHUNK_LOW(values[i++]);
+
+					memcpy(ptr + j * sizeof(uint16), &low, sizeof(uint16));
+				}
+				break;
+
+			case HASHSET_CONTAINER_BITMAP:
+				{
+					uint64	words[HASHSET_BITMAP_WORDS];
+
+					memset(words, 0, sizeof(words));
+
+					for (uint32 j = 0; j < chunk->count; j++)
+					{
+						uint16	low = HASHSET_CHUNK_LOW(values[i++]);
+
+						words[low / 64] |= UINT64CONST(1) << (low % 64);
+					}
+
+					memcpy(ptr, words, HASHSET_BITMAP_SIZE);
+				}
+				break;
+
+			case HASHSET_CONTAINER_RUNS:
+				for (uint32 j = 0; j < chunk->count; j++)
+				{
+					uint16	run[2];
+
+					run[0] = HASHSET_CHUNK_LOW(values[i++]);
+					run[1] = 0;
+
+					while (i < nvalues &&
+						   HASHSET_CHUNK_KEY(values[i]) == chunk->key &&
+						   HASHSET_CHUNK_LOW(values[i]) == run[0] + run[1] + 1)
+					{
+						run[1]++;
+						i++;
+					}
+
+					memcpy(ptr + j * sizeof(run), run, sizeof(run));
+				}
+				break;
+		}
+	}
+
+	Assert(i == nvalues);
+
+	pfree(chunks);
+}
+
+/*
+ * hashset_find_chunk
+ *		Binary search for the chunk with the key in the directory.
+ */
+static bool
+hashset_find_chunk(int4hashset_t *set, uint32 nchunks, uint16 key,
+				   hashset_chunk_t *chunk)
+{
+	uint32	lo = 0;
+	uint32	hi = nchunks;
+
+	while (lo < hi)
+	{
+		uint32	mid = lo + (hi - lo) / 2;
+
+		hashset_get_chunk(set->data, mid, chunk);
+
+		if (chunk->key == key)
+			return true;
+
+		if (chunk->key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return false;
+}
+
+/*
+ * hashset_chunk_contains
+ *		Check if the container of the chunk contains the low 16 bits.
+ */
+static inline bool
+hashset_chunk_contains(const char *containers, const hashset_chunk_t *chunk,
+					   uint32 low)
+{
+	const char *container = containers + chunk->offset;
+	uint32		lo = 0;
+	uint32		hi = chunk->count;
+
+	switch (chunk->type)
+	{
+		case HASHSET_CONTAINER_BITMAP:
+			return (hashset_get_word(container, low / 64) >> (low % 64)) & 1;
+
+		case HASHSET_CONTAINER_ARRAY:
+			while (lo < hi)
+			{
+				uint32	mid = lo + (hi - lo) / 2;
+				uint32	value = hashset_get_uint16(container, mid);
+
+				if (value == low)
+					return true;
+
+				if (value < low)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			return false;
+
+		case HASHSET_CONTAINER_RUNS:
+			/* find the last run starting at or before the value */
+			while (lo < hi)
+			{
+				uint32	mid = lo + (hi - lo) / 2;
+
+				if (hashset_get_uint16(container, 2 * mid) <= low)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+
+			if (lo == 0)
+				return false;
+
+			return (low <= (uint32) hashset_get_uint16(container, 2 * (lo - 1)) +
+					hashset_get_uint16(container, 2 * (lo - 1) + 1));
+	}
+
+	return false;
+}
+
+/*
+ * hashset_containers_contains
+ *		Check if the set (using the container encoding) contains the value.
+ */
+bool
+hashset_containers_contains(int4hashset_t *set, int32 value)
+{
+	uint32			nchunks = hashset_get_nchunks(set->data);
+	hashset_chunk_t	chunk;
+
+	Assert(HASHSET_IS_CONTAINERS(set));
+
+	if (!hashset_find_chunk(set, nchunks, HASHSET_CHUNK_KEY(value), &chunk))
+		return false;
+
+	return hashset_chunk_contains(HASHSET_CONTAINERS(set, nchunks), &chunk,
+								  HASHSET_CHUNK_LOW(value));
+}
+
+/*
+ * hashset_chunk_decode
+ *		Decode the low 16 bits of all elements of the chunk into values.
+ */
+static int
+hashset_chunk_decode(const char *containers, const hashset_chunk_t *chunk,
+					 uint16 *values)
+{
+	const char *container = containers + chunk->offset;
+	int			n = 0;
+
+	switch (chunk->type)
+	{
+		case HASHSET_CONTAINER_ARRAY:
+			memcpy(values, container, chunk->count * sizeof(uint16));
+			return chunk->count;
+
+		case HASHSET_CONTAINER_BITMAP:
+			for (uint32 w = 0; w < HASHSET_BITMAP_WORDS; w++)
+			{
+				uint64	word = hashset_get_word(container, w);
+
+				while (word != 0)
+				{
+					values[n++] = w * 64 + pg_rightmost_one_pos64(word);
+					word &= (word - 1);
+				}
+			}
+			return n;
+
+		case HASHSET_CONTAINER_RUNS:
+			for (uint32 r = 0; r < chunk->count; r++)
+			{
+				uint32	start = hashset_get_uint16(container, 2 * r);
+				uint32	length = hashset_get_uint16(container, 2 * r + 1);
+
+				for (uint32 v = start; v <= start + length; v++)
+					values[n++] = v;
+			}
+			return n;
+	}
+
+	return 0;
+}
+
+/*
+ * hashset_containers_intersect
+ *		Collect the elements of two sets using the container encoding that
+ *		are in both of them, in ascending order.
+ *
+ * The chunk directories are merged by key. Pairs of bitmaps are AND-ed a
+ * word at a time, for other pairs the elements of one container are looked
+ * up in the other one.
+ */
+static int
+hashset_containers_intersect(int4hashset_t *a, int4hashset_t *b, int32 *result)
+{
+	uint32		na = hashset_get_nchunks(a->data);
+	uint32		nb = hashset_get_nchunks(b->data);
+	const char *containers_a = HASHSET_CONTAINERS(a, na);
+	const char *containers_b = HASHSET_CONTAINERS(b, nb);
+	uint16	   *values = NULL;
+	uint32		i = 0;
+	uint32		j = 0;
+	int			nresult = 0;
+
+	while (i < na && j < nb)
+	{
+		hashset_chunk_t	chunk_a;
+		hashset_chunk_t	chunk_b;
+		uint32			high;
+
+		hashset_get_chunk(a->data, i, &chunk_a);
+		hashset_get_chunk(b->data, j, &chunk_b);
+
+		if (chunk_a.key != chunk_b.key)
+		{
+			if (chunk_a.key < chunk_b.key)
+				i++;
+			else
+				j++;
+
+			continue;
+		}
+
+		high = (uint32) chunk_a.key << 16;
+
+		if (chunk_a.type == HASHSET_CONTAINER_BITMAP &&
+			chunk_b.type == HASHSET_CONTAINER_BITMAP)
+		{
+			const char *bitmap_a = containers_a + chunk_a.offset;
+			const char *bitmap_b = containers_b + chunk_b.offset;
+
+			for (uint32 w = 0; w < HASHSET_BITMAP_WORDS; w++)
+			{
+				uint64	word = hashset_get_word(bitmap_a, w) &
+							   hashset_get_word(bitmap_b, w);
+
+				while (word != 0)
+				{
+					result[nresult++] = HASHSET_UNBIAS(high | (w * 64 + pg_rightmost_one_pos64(word)));
+					word &= (word - 1);
+				}
+			}
+		}
+		else
+		{
+			const char		   *decode_containers = containers_a;
+			const char		   *probe_containers = containers_b;
+			hashset_chunk_t	   *decode_chunk = &chunk_a;
+			hashset_chunk_t	   *probe_chunk = &chunk_b;
+			int					nvalues;
+
+			/* decode the container that's not a bitmap, probe the other */
+			if (chunk_a.type == HASHSET_CONTAINER_BITMAP)
+			{
+				decode_containers = containers_b;
+				probe_containers = containers_a;
+				decode_chunk = &chunk_b;
+				probe_chunk = &chunk_a;
+			}
+
+			if (values == NULL)
+				values = palloc(65536 * sizeof(uint16));
+
+			nvalues = hashset_chunk_decode(decode_containers, decode_chunk, values);
+
+			for (int k = 0; k < nvalues; k++)
+			{
+				if (hashset_chunk_contains(probe_containers, probe_chunk, values[k]))
+					result[nresult++] = HASHSET_UNBIAS(high | values[k]);
+			}
+		}
+
+		i++;
+		j++;
+	}
+
+	if (values != NULL)
+		pfree(values);
+
+	return nresult;
+}
+
+/*
+ * hashset_containers_filter
+ *		Collect elements of src that are (found = true) or are not (found =
+ *		false) contained in the set using the container encoding.
+ *
+ * Same as int4hashset_filter. When src uses the container encoding too, the
+ * intersection is done chunk by chunk. Otherwise the elements of src (in any
+ * format) are looked up directly in the containers, remembering the last
+ * chunk, so clustered elements need a single directory search per chunk.
+ */
+int
+hashset_containers_filter(int4hashset_t *set, int4hashset_t *src, bool found,
+						  int32 *result)
+{
+	uint32					nchunks = hashset_get_nchunks(set->data);
+	const char			   *containers = HASHSET_CONTAINERS(set, nchunks);
+	int4hashset_iterator_t	iter;
+	int32					value;
+	int32					key = -1;
+	bool					has_chunk = false;
+	hashset_chunk_t			chunk;
+	int						nresult = 0;
+
+	Assert(HASHSET_IS_CONTAINERS(set));
+
+	if (found && HASHSET_IS_CONTAINERS(src))
+		return hashset_containers_intersect(set, src, result);
+
+	int4hashset_iterator_init(&iter, src);
+	while (int4hashset_iterator_next(&iter, &value))
+	{
+		bool	contains;
+
+		if (HASHSET_CHUNK_KEY(value) != key)
+		{
+			key = HASHSET_CHUNK_KEY(value);
+			has_chunk = hashset_find_chunk(set, nchunks, key, &chunk);
+		}
+
+		contains = has_chunk &&
+			hashset_chunk_contains(containers, &chunk, HASHSET_CHUNK_LOW(value));
+
+		if (contains == found)
+			result[nresult++] = value;
+	}
+
+	return nresult;
+}
@@ -0,0 +1,293 @@
+/*
+ * hashset-frontier.c
+ *
+ * Aggregates skipping elements of a "visited" set, for graph traversals.
+ *
+ * A breadth-first search in a recursive CTE aggregates the neighbors of the
+ * current frontier at each level, and then removes the nodes visited at
+ * the previous levels (e.g. using hashset_difference). Most of the nodes
+ * aggregated at the later levels are thrown away, so hashset_agg_excluding
+ * probes the visited set first and only adds the new elements. And
+ * hashset_agg_frontier returns the updated visited set too, so that each
+ * level needs a single pass over the neighbors.
+ *
+ * The visited set of hashset_agg_frontier has to be the same for all rows
+ * of the group (a constant or a reference to the outer query). That's
+ * checked when the aggregate state gets created, we don't want to compare
+ * the sets for each row. hashset_agg_excluding accepts a different set for
+ * each row, but it's much faster when the set is the same.
+ *
+ * A per-row visited set is usually compact (coming from a table or a CTE
+ * worktable), and probing a compact set decodes it. So we keep a copy of
+ * the last visited set, and when the next row has the same one, we build
+ * its hash table (once) and use that. The sets are compared by value, as
+ * a different datum may end up at the same address. The headers are
+ * compared first (size, number of elements and the sum of the element
+ * hashes), so a different set is almost always recognized without looking
+ * at the elements.
+ */
+
+#include "hashset.h"
+
+#include "access/htup_details.h"
+#include "funcapi.h"
+#include "optimizer/optimizer.h"
+
+PG_FUNCTION_INFO_V1(int4hashset_agg_excluding_add);
+PG_FUNCTION_INFO_V1(int4hashset_agg_excluding_final);
+PG_FUNCTION_INFO_V1(int4hashset_agg_frontier_add);
+PG_FUNCTION_INFO_V1(int4hashset_agg_frontier_final);
+
+Datum int4hashset_agg_excluding_add(PG_FUNCTION_ARGS);
+Datum int4hashset_agg_excluding_final(PG_FUNCTION_ARGS);
+Datum int4hashset_agg_frontier_add(PG_FUNCTION_ARGS);
+Datum int4hashset_agg_frontier_final(PG_FUNCTION_ARGS);
+
+/*
+ * State of hashset_agg_excluding and hashset_agg_frontier.
+ *
+ * The visited set is a private copy (a hash table) in the aggregate context,
+ * hashset_agg_frontier adds the new elements to it. For hashset_agg_excluding
+ * the visited set may differ between rows, and then it's NULL and each row
+ * probes its own set instead (see hashset_row_visited).
+ */
+typedef struct hashset_frontier_state_t {
+	int4hashset_t  *frontier;	/* Elements not in the visited set */
+	int4hashset_t  *visited;	/* Copy of the visited set (or NULL) */
+	int4hashset_t  *row_set;	/* Copy of the last per-row visited set */
+	int4hashset_t  *row_table;	/* Hash table built from row_set (or NULL) */
+} hashset_frontier_state_t;
+
+static bool hashset_visited_is_stable(FunctionCallInfo fcinfo);
+static bool hashset_row_set_equal(int4hashset_t *a, int4hashset_t *b);
+static bool hashset_row_visited(hashset_frontier_state_t *state,
+								int4hashset_t *visited, int32 value);
+static Datum hashset_frontier_add(FunctionCallInfo fcinfo, bool update_visited);
+
+/*
+ * hashset_visited_is_stable
+ *		Is the visited argument of the aggregate the same for all rows?
+ *
+ * That's true for expressions without Vars of the aggregated rows and
+ * volatile functions - constants and parameters (references to the outer
+ * query are passed as parameters) don't change within the group.
+ */
+static bool
+hashset_visited_is_stable(FunctionCallInfo fcinfo)
+{
+	Aggref	   *aggref = AggGetAggref(fcinfo);
+	Node	   *expr;
+
+	if (aggref == NULL || list_length(aggref->args) < 2)
+		return false;
+
+	expr = (Node *) ((TargetEntry *) lsecond(aggref->args))->expr;
+
+	return (!contain_var_clause(expr) && !contain_volatile_functions(expr));
+}
+
+/*
+ * hashset_row_set_equal
+ *		Are the two (compact) sets the same?
+ *
+ * The header fields rule out most different sets cheaply, only sets that
+ * match on all of them get compared byte by byte.
+ */
+static bool
+hashset_row_set_equal(int4hashset_t *a, int4hashset_t *b)
+{
+	if (VARSIZE(a) != VARSIZE(b) ||
+		a->nelements != b->nelements ||
+		a->hash != b->hash ||
+		a->null_element != b->null_element)
+		return false;
+
+	return (memcmp(a, b, VARSIZE(a)) == 0);
+}
+
+/*
+ * hashset_row_visited
+ *		Is the value in the visited set passed with the current row?
+ *
+ * Compact sets are scanned the first time, and get the hash table built
+ * when the next row has the same set (see the comment at the top). Called
+ * in the aggregate context.
+ */
+static bool
+hashset_row_visited(hashset_frontier_state_t *state, int4hashset_t *visited,
+					int32 value)
+{
+	if (!HASHSET_IS_COMPACT(visited))
+		return int4hashset_contains_element(visited, value);
+
+	if (state->row_set == NULL ||
+		!hashset_row_set_equal(state->row_set, visited))
+	{
+		if (state->row_set != NULL)
+			pfree(state->row_set);
+
+		if (state->row_table != NULL)
+			pfree(state->row_table);
+
+		state->row_set = palloc(VARSIZE(visited));
+		memcpy(state->row_set, visited, VARSIZE(visited));
+		state->row_table = NULL;
+
+		return int4hashset_contains_element(visited, value);
+	}
+
+	if (state->row_table == NULL)
+		state->row_table = int4hashset_rebuild(visited);
+
+	return int4hashset_contains_element(state->row_table, value);
+}
+
+/*
+ * hashset_frontier_add
+ *		Transition function of both aggregates.
+ *
+ * With update_visited, the new elements are added to the visited set, so
+ * that a single probe both checks and records the element.
+ */
+static Datum
+hashset_frontier_add(FunctionCallInfo fcinfo, bool update_visited)
+{
+	MemoryContext				aggcontext;
+	MemoryContext				oldcontext;
+	hashset_frontier_state_t   *state;
+	int32						value;
+
+	/* cannot be called directly because of internal-type argument */
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_frontier_add called in non-aggregate context");
+
+	if (PG_ARGISNULL(0))
+	{
+		bool	stable = hashset_visited_is_stable(fcinfo);
+
+		if (update_visited && !stable)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("visited set of hashset_agg_frontier must be the same for all rows")));
+
+		oldcontext = MemoryContextSwitchTo(aggcontext);
+
+		state = palloc0(sizeof(hashset_frontier_state_t));
+		state->frontier = int4hashset_allocate(
+			DEFAULT_INITIAL_CAPACITY,
+			DEFAULT_LOAD_FACTOR,
+			DEFAULT_GROWTH_FACTOR,
+			DEFAULT_HASHFN_ID
+		);
+
+		/* a NULL visited set is the same as an empty one */
+		if (!stable)
+			state->visited = NULL;
+		else if (PG_ARGISNULL(2))
+			state->visited = int4hashset_allocate(
+				DEFAULT_INITIAL_CAPACITY,
+				DEFAULT_LOAD_FACTOR,
+				DEFAULT_GROWTH_FACTOR,
+				DEFAULT_HASHFN_ID
+			);
+		else
+		{
+			int4hashset_t  *visited = PG_GETARG_INT4HASHSET_ANY(2);
+
+			if (HASHSET_IS_COMPACT(visited))
+				state->visited = int4hashset_rebuild(visited);
+			else
+				state->visited = int4hashset_copy(visited);
+		}
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+	else
+		state = (hashset_frontier_state_t *) PG_GETARG_POINTER(0);
+
+	/* NULL values are skipped, just like in hashset_agg */
+	if (PG_ARGISNULL(1))
+		PG_RETURN_POINTER(state);
+
+	value = PG_GETARG_INT32(1);
+
+	oldcontext = MemoryContextSwitchTo(aggcontext);
+
+	if (update_visited)
+	{
+		int32	nelements = state->visited->nelements;
+
+		state->visited = int4hashset_add_element(state->visited, value);
+
+		if (state->visited->nelements > nelements)
+			state->frontier = int4hashset_add_element(state->frontier, value);
+	}
+	else
+	{
+		bool	visited;
+
+		if (state->visited != NULL)
+			visited = int4hashset_contains_element(state->visited, value);
+		else
+			visited = !PG_ARGISNULL(2) &&
+				hashset_row_visited(state, PG_GETARG_INT4HASHSET_ANY(2), value);
+
+		if (!visited)
+			state->frontier = int4hashset_add_element(state->frontier, value);
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	PG_RETURN_POINTER(state);
+}
+
+Datum
+int4hashset_agg_excluding_add(PG_FUNCTION_ARGS)
+{
+	return hashset_frontier_add(fcinfo, false);
+}
+
+Datum
+int4hashset_agg_frontier_add(PG_FUNCTION_ARGS)
+{
+	return hashset_frontier_add(fcinfo, true);
+}
+
+Datum
+int4hashset_agg_excluding_final(PG_FUNCTION_ARGS)
+{
+	hashset_frontier_state_t   *state;
+
+	state = (hashset_frontier_state_t *) PG_GETARG_POINTER(0);
+
+	PG_RETURN_DATUM(int4hashset_expand(PointerGetDatum(state->frontier),
+									   CurrentMemoryContext));
+}
+
+/*
+ * int4hashset_agg_frontier_final
+ *		Build the (frontier, visited) composite.
+ *
+ * The NULL element of the visited set is preserved, NULL values are never
+ * added to the frontier.
+ */
+Datum
+int4hashset_agg_frontier_final(PG_FUNCTION_ARGS)
+{
+	hashset_frontier_state_t   *state;
+	TupleDesc					tupdesc;
+	Datum						values[2];
+	bool						nulls[2] = {false, false};
+
+	state = (hashset_frontier_state_t *) PG_GETARG_POINTER(0);
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	values[0] = PointerGetDatum(int4hashset_compact(state->frontier));
+	values[1] = PointerGetDatum(int4hashset_compact(state->visited));
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
@@ -0,0 +1,197 @@
+/*
+ * hashset-gin.c
+ *
+ * GIN operator classes for the hashset types, indexing the individual
+ * elements.
+ *
+ * The keys are the elements of the set (of the element type, e.g. int4 for
+ * int4hashset), so the index can answer element containment (@> int), set
+ * containment (@>, <@), overlap (&&) and equality. The NULL element is
+ * indexed as a NULL key, so that the operators (which treat it as a regular
+ * element) don't need a recheck because of it.
+ */
+
+#include "hashset.h"
+
+#include "access/gin.h"
+#include "access/stratnum.h"
+
+PG_FUNCTION_INFO_V1(int4hashset_gin_consistent);
+
+Datum int4hashset_gin_consistent(PG_FUNCTION_ARGS);
+
+static Datum *hashset_gin_extract(Datum setdatum, Oid elemtype, int32 *nentries, bool **nullFlags);
+
+/*
+ * hashset_gin_extract_value
+ *		Extract the elements of an indexed hashset as GIN keys.
+ *
+ * Called by the extractValue functions of the hashset types (e.g.
+ * int4hashset_gin_extract_value), with the element type of the set.
+ */
+Datum
+hashset_gin_extract_value(FunctionCallInfo fcinfo, Oid elemtype)
+{
+	int32		   *nentries = (int32 *) PG_GETARG_POINTER(1);
+	bool		  **nullFlags = (bool **) PG_GETARG_POINTER(2);
+
+	PG_RETURN_POINTER(hashset_gin_extract(PG_GETARG_DATUM(0), elemtype,
+										  nentries, nullFlags));
+}
+
+/*
+ * hashset_gin_extract_query
+ *		Extract the GIN keys to search for.
+ *
+ * For the element containment the query is a single value of the element
+ * type, for the other strategies it's a hashset.
+ */
+Datum
+hashset_gin_extract_query(FunctionCallInfo fcinfo, Oid elemtype)
+{
+	int32		   *nentries = (int32 *) PG_GETARG_POINTER(1);
+	StrategyNumber	strategy = PG_GETARG_UINT16(2);
+	bool		  **nullFlags = (bool **) PG_GETARG_POINTER(4);
+	int32		   *searchMode = (int32 *) PG_GETARG_POINTER(6);
+	Datum		   *entries;
+
+	if (strategy == HASHSET_GIN_CONTAINS_ELEM_STRATEGY)
+	{
+		entries = (Datum *) palloc(sizeof(Datum));
+		entries[0] = PG_GETARG_DATUM(0);
+		*nentries = 1;
+
+		PG_RETURN_POINTER(entries);
+	}
+
+	entries = hashset_gin_extract(PG_GETARG_DATUM(0), elemtype,
+								  nentries, nullFlags);
+
+	switch (strategy)
+	{
+		case HASHSET_GIN_OVERLAP_STRATEGY:
+			/* nothing overlaps an empty set (no keys means no match) */
+			break;
+		case HASHSET_GIN_CONTAINS_STRATEGY:
+			/* everything contains an empty set */
+			if (*nentries == 0)
+				*searchMode = GIN_SEARCH_MODE_ALL;
+			break;
+		case HASHSET_GIN_CONTAINED_STRATEGY:
+			/* empty sets are contained in anything */
+			*searchMode = GIN_SEARCH_MODE_INCLUDE_EMPTY;
+			break;
+		case HASHSET_GIN_EQUAL_STRATEGY:
+			if (*nentries == 0)
+				*searchMode = GIN_SEARCH_MODE_INCLUDE_EMPTY;
+			break;
+		default:
+			elog(ERROR, "hashset_gin_extract_query: unknown strategy number: %d",
+				 strategy);
+	}
+
+	PG_RETURN_POINTER(entries);
+}
+
+/*
+ * int4hashset_gin_consistent
+ *		Check if an indexed hashset matches the query, given the keys found.
+ *
+ * This does not look at the keys, so it's used by all the hashset types.
+ *
+ * The keys are exactly the elements, so overlap and containment are decided
+ * by the index alone. For "contained by" and equality the indexed set may
+ * have elements not in the query, so those need a recheck.
+ */
+Datum
+int4hashset_gin_consistent(PG_FUNCTION_ARGS)
+{
+	bool		   *check = (bool *) PG_GETARG_POINTER(0);
+	StrategyNumber	strategy = PG_GETARG_UINT16(1);
+	int32			nkeys = PG_GETARG_INT32(3);
+	bool		   *recheck = (bool *) PG_GETARG_POINTER(5);
+	bool			result;
+	int32			i;
+
+	switch (strategy)
+	{
+		case HASHSET_GIN_OVERLAP_STRATEGY:
+			*recheck = false;
+			result = false;
+			for (i = 0; i < nkeys; i++)
+			{
+				if (check[i])
+				{
+					result = true;
+					break;
+				}
+			}
+			break;
+		case HASHSET_GIN_CONTAINS_STRATEGY:
+		case HASHSET_GIN_CONTAINS_ELEM_STRATEGY:
+		case HASHSET_GIN_EQUAL_STRATEGY:
+			*recheck = (strategy == HASHSET_GIN_EQUAL_STRATEGY);
+			result = true;
+			for (i = 0; i < nkeys; i++)
+			{
+				if (!check[i])
+				{
+					result = false;
+					break;
+				}
+			}
+			break;
+		case HASHSET_GIN_CONTAINED_STRATEGY:
+			*recheck = true;
+			result = true;
+			break;
+		default:
+			elog(ERROR, "int4hashset_gin_consistent: unknown strategy number: %d",
+				 strategy);
+			result = false;
+	}
+
+	PG_RETURN_BOOL(result);
+}
+
+/*
+ * hashset_gin_extract
+ *		Build the array of GIN keys for a hashset (in any format).
+ *
+ * The elements are read without building a hash table. They come out
+ * sorted (GIN sorts the keys anyway), which is cheap for compact sets.
+ */
+static Datum *
+hashset_gin_extract(Datum setdatum, Oid elemtype, int32 *nentries,
+					bool **nullFlags)
+{
+	int64		   *values;
+	int				nelements;
+	bool			null_element;
+	int32			n;
+	Datum		   *entries;
+	bool		   *nulls;
+
+	values = hashset_datum_elements(setdatum, elemtype, &nelements,
+									&null_element);
+
+	entries = (Datum *) palloc((nelements + 1) * sizeof(Datum));
+	nulls = (bool *) palloc0((nelements + 1) * sizeof(bool));
+
+	for (n = 0; n < nelements; n++)
+		entries[n] = hashset_element_datum(values[n], elemtype);
+
+	if (null_element)
+	{
+		entries[n] = (Datum) 0;
+		nulls[n] = true;
+		n++;
+	}
+
+	pfree(values);
+
+	*nentries = n;
+	*nullFlags = nulls;
+
+	return entries;
+}
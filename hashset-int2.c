@@ -0,0 +1,26 @@
+/*
+ * hashset-int2.c
+ *
+ * int2hashset, a hashset of smallint values. The core is shared with the other
+ * hashset types (hashset-type.h), and so are the SQL functions - this only
+ * generates them for the element type (see hashset-type-api.h).
+ */
+
+#include "hashset.h"
+
+#include "funcapi.h"
+#include "lib/hyperloglog.h"
+#include "nodes/execnodes.h"
+#include "utils/sortsupport.h"
+
+#define HASHSET_PREFIX					int2hashset
+#define HASHSET_ELEMENT_TYPE			int16
+#define HASHSET_ELEMENT_OID				INT2OID
+#define HASHSET_ELEMENT_NAME			"smallint"
+#define HASHSET_ELEMENT_MIN				PG_INT16_MIN
+#define HASHSET_ELEMENT_MAX				PG_INT16_MAX
+#define HASHSET_GETARG_ELEMENT(n)		PG_GETARG_INT16(n)
+#define HASHSET_ELEMENT_GET_DATUM(value)	Int16GetDatum(value)
+#define HASHSET_SEND_ELEMENT(buf, value)	pq_sendint16((buf), (value))
+#define HASHSET_RECV_ELEMENT(buf)		((int16) pq_getmsgint((buf), 2))
+#include "hashset-type-api.h"
@@ -0,0 +1,26 @@
+/*
+ * hashset-int8.c
+ *
+ * int8hashset, a hashset of bigint values. The core is shared with the other
+ * hashset types (hashset-type.h), and so are the SQL functions - this only
+ * generates them for the element type (see hashset-type-api.h).
+ */
+
+#include "hashset.h"
+
+#include "funcapi.h"
+#include "lib/hyperloglog.h"
+#include "nodes/execnodes.h"
+#include "utils/sortsupport.h"
+
+#define HASHSET_PREFIX					int8hashset
+#define HASHSET_ELEMENT_TYPE			int64
+#define HASHSET_ELEMENT_OID				INT8OID
+#define HASHSET_ELEMENT_NAME			"bigint"
+#define HASHSET_ELEMENT_MIN				PG_INT64_MIN
+#define HASHSET_ELEMENT_MAX				PG_INT64_MAX
+#define HASHSET_GETARG_ELEMENT(n)		PG_GETARG_INT64(n)
+#define HASHSET_ELEMENT_GET_DATUM(value)	Int64GetDatum(value)
+#define HASHSET_SEND_ELEMENT(buf, value)	pq_sendint64((buf), (value))
+#define HASHSET_RECV_ELEMENT(buf)		pq_getmsgint64(buf)
+#include "hashset-type-api.h"
@@ -0,0 +1,528 @@
+/*
+ * hashset-kernels.h
+ *
+ * Template for the hash table kernels specialized for one hash function.
+ *
+ * The hash function is a property of the whole set, so instead of checking
+ * hashfn_id for every element we generate a copy of the insert / lookup /
+ * remove loops for each hash function, and dispatch once per operation.
+ * This way the hash calculation is inlined into the probing loop.
+ *
+ * Before including this file, define:
+ *
+ *	HASHSET_KERNEL_SUFFIX - suffix of the generated function names
+ *	HASHSET_KERNEL_HASH(value) - hash of an element (returns uint32)
+ *
+ * The file may be included multiple times, the macros are undefined at the
+ * end. It's meant to be included from the HASHSET_DEFINE section of
+ * hashset-type.h only, which provides the element type and the names.
+ */
+
+#define HASHSET_KERNEL_MAKE_NAME_(name, suffix) name##_##suffix
+#define HASHSET_KERNEL_MAKE_NAME(name, suffix) HASHSET_KERNEL_MAKE_NAME_(name, suffix)
+#define HASHSET_KERNEL_NAME(name) \
+	HASHSET_NAME(HASHSET_KERNEL_MAKE_NAME(name, HASHSET_KERNEL_SUFFIX))
+
+#define HASHSET_KERNEL_INSERT	HASHSET_KERNEL_NAME(insert)
+#define HASHSET_KERNEL_INSERT_HASH	HASHSET_KERNEL_NAME(insert_hash)
+#define HASHSET_KERNEL_LOOKUP	HASHSET_KERNEL_NAME(lookup)
+#define HASHSET_KERNEL_LOOKUP_HASH	HASHSET_KERNEL_NAME(lookup_hash)
+#define HASHSET_KERNEL_LOOKUP_VALUES	HASHSET_KERNEL_NAME(lookup_values)
+#define HASHSET_KERNEL_ADD_SET	HASHSET_KERNEL_NAME(add_set)
+#define HASHSET_KERNEL_ADD_VALUES	HASHSET_KERNEL_NAME(add_values)
+#define HASHSET_KERNEL_FILTER	HASHSET_KERNEL_NAME(filter)
+#define HASHSET_KERNEL_FILTER_ALIGNED	HASHSET_KERNEL_NAME(filter_aligned)
+#define HASHSET_KERNEL_REMOVE_HASH	HASHSET_KERNEL_NAME(remove_hash)
+#define HASHSET_KERNEL_REMOVE_VALUES	HASHSET_KERNEL_NAME(remove_values)
+
+/*
+ * Add the value with a precomputed hash to the hash table (resizing it if
+ * needed).
+ */
+static inline HASHSET_TYPE *
+HASHSET_KERNEL_INSERT_HASH(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE value, uint32 hash)
+{
+	uint32	group;
+	uint32	mask;
+	uint32	probe;
+	uint8	tag;
+	uint8  *ctrl;
+	HASHSET_ELEMENT_TYPE *values;
+	int32	current_collisions = 0;
+	int		free_slot = -1;
+
+	Assert(!HASHSET_IS_COMPACT(set));
+
+	/*
+	 * Resize early, so that there's always at least one empty slot. The
+	 * tombstones count too, as they make the probe sequences longer.
+	 */
+	if (unlikely(set->capacity == 0 ||
+				 set->nelements + set->ndeleted >= set->capacity * set->load_factor))
+		set = HASHSET_NAME(resize)(set);
+
+	tag = HASHSET_HASH_TAG(hash);
+
+	mask = set->capacity / HASHSET_GROUP_SIZE - 1;
+	group = HASHSET_HASH_GROUP(hash) & mask;
+
+	ctrl = HASHSET_GET_CTRL(set);
+	values = HASHSET_GET_VALUES(set);
+
+	/*
+	 * Probe the groups in triangular order (offsets 0, 1, 3, 6, ...), which
+	 * visits all groups when the number of groups is a power of two.
+	 */
+	for (probe = 1; ; probe++)
+	{
+		uint8  *gctrl = ctrl + group * HASHSET_GROUP_SIZE;
+		HASHSET_ELEMENT_TYPE *gvalues = values + group * HASHSET_GROUP_SIZE;
+		uint32	match;
+
+		/* Slots with a matching tag - maybe it's the same value? */
+		match = hashset_group_match(gctrl, tag);
+		while (match != 0)
+		{
+			int		i = pg_rightmost_one_pos32(match);
+
+			/* Same value, we're done */
+			if (gvalues[i] == value)
+				return set;
+
+			match &= (match - 1);
+		}
+
+		/* Remember the first free slot, a tombstone may be reused */
+		if (free_slot < 0)
+		{
+			match = hashset_group_match_free(gctrl);
+			if (match != 0)
+				free_slot = group * HASHSET_GROUP_SIZE + pg_rightmost_one_pos32(match);
+		}
+
+		/* Found an empty slot, so the value is not in the set - add it */
+		if (hashset_group_match_empty(gctrl) != 0)
+		{
+			if (ctrl[free_slot] == HASHSET_CTRL_DELETED)
+				set->ndeleted--;
+
+			ctrl[free_slot] = tag;
+			values[free_slot] = value;
+
+			set->nelements++;
+			set->hash += HASHSET_ELEMENT_HASH(value);
+
+			return set;
+		}
+
+		/* No empty slot in the group, increment the collision counter */
+		set->ncollisions++;
+		current_collisions++;
+
+		if (current_collisions > set->max_collisions)
+			set->max_collisions = current_collisions;
+
+		group = (group + probe) & mask;
+	}
+}
+
+/*
+ * Add the value to the hash table (resizing it if needed).
+ */
+static inline HASHSET_TYPE *
+HASHSET_KERNEL_INSERT(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE value)
+{
+	return HASHSET_KERNEL_INSERT_HASH(set, value, HASHSET_KERNEL_HASH(value));
+}
+
+/*
+ * Check if the hash table contains the value, with a precomputed hash.
+ */
+static inline bool
+HASHSET_KERNEL_LOOKUP_HASH(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE value, uint32 hash)
+{
+	uint32	group;
+	uint32	mask;
+	uint32	probe;
+	uint8	tag;
+	uint8  *ctrl;
+	HASHSET_ELEMENT_TYPE *values;
+
+	Assert(!HASHSET_IS_COMPACT(set));
+
+	if (set->nelements == 0)
+		return false;
+
+	tag = HASHSET_HASH_TAG(hash);
+
+	mask = set->capacity / HASHSET_GROUP_SIZE - 1;
+	group = HASHSET_HASH_GROUP(hash) & mask;
+
+	ctrl = HASHSET_GET_CTRL(set);
+	values = HASHSET_GET_VALUES(set);
+
+	/* Same probe sequence as the insert, visiting each group once */
+	for (probe = 1; probe <= mask + 1; probe++)
+	{
+		uint8  *gctrl = ctrl + group * HASHSET_GROUP_SIZE;
+		HASHSET_ELEMENT_TYPE *gvalues = values + group * HASHSET_GROUP_SIZE;
+		uint32	match;
+
+		match = hashset_group_match(gctrl, tag);
+		while (match != 0)
+		{
+			int		i = pg_rightmost_one_pos32(match);
+
+			if (gvalues[i] == value)
+				return true;
+
+			match &= (match - 1);
+		}
+
+		/* Found an empty slot, value is not there */
+		if (hashset_group_match_empty(gctrl) != 0)
+			return false;
+
+		group = (group + probe) & mask;
+	}
+
+	return false;
+}
+
+/*
+ * Check if the hash table contains the value.
+ */
+static inline bool
+HASHSET_KERNEL_LOOKUP(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE value)
+{
+	return HASHSET_KERNEL_LOOKUP_HASH(set, value, HASHSET_KERNEL_HASH(value));
+}
+
+/*
+ * Check which of the values the hash table contains, in batches (the same
+ * way as HASHSET_KERNEL_ADD_VALUES).
+ */
+static void
+HASHSET_KERNEL_LOOKUP_VALUES(HASHSET_TYPE *set, const HASHSET_ELEMENT_TYPE *values,
+							 int nvalues, bool *result)
+{
+	int		i,
+			j;
+	uint32	hashes[HASHSET_BATCH_SIZE];
+	uint32	mask = (set->capacity / HASHSET_GROUP_SIZE) - 1;
+
+	if (set->nelements == 0)
+	{
+		memset(result, 0, nvalues * sizeof(bool));
+		return;
+	}
+
+	for (i = 0; i < nvalues; i += HASHSET_BATCH_SIZE)
+	{
+		int		n = Min(HASHSET_BATCH_SIZE, nvalues - i);
+
+		for (j = 0; j < n; j++)
+		{
+			hashes[j] = HASHSET_KERNEL_HASH(values[i + j]);
+			hashset_prefetch_group(set, HASHSET_HASH_GROUP(hashes[j]) & mask);
+		}
+
+		for (j = 0; j < n; j++)
+			result[i + j] = HASHSET_KERNEL_LOOKUP_HASH(set, values[i + j],
+													   hashes[j]);
+	}
+}
+
+/*
+ * Remove the value with a precomputed hash from the hash table. Returns
+ * true if the value was found (and removed).
+ *
+ * The slot becomes empty when the group has another empty slot - probes
+ * stop at such group, so none of them can depend on this one being taken.
+ * Otherwise we have to leave a tombstone, for elements pushed to one of the
+ * following groups while this one was full. The table is never resized.
+ */
+static inline bool
+HASHSET_KERNEL_REMOVE_HASH(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE value, uint32 hash)
+{
+	uint32	group;
+	uint32	mask;
+	uint32	probe;
+	uint8	tag;
+	uint8  *ctrl;
+	HASHSET_ELEMENT_TYPE *values;
+
+	Assert(!HASHSET_IS_COMPACT(set));
+
+	if (set->nelements == 0)
+		return false;
+
+	tag = HASHSET_HASH_TAG(hash);
+
+	mask = set->capacity / HASHSET_GROUP_SIZE - 1;
+	group = HASHSET_HASH_GROUP(hash) & mask;
+
+	ctrl = HASHSET_GET_CTRL(set);
+	values = HASHSET_GET_VALUES(set);
+
+	/* Same probe sequence as the lookup */
+	for (probe = 1; probe <= mask + 1; probe++)
+	{
+		uint8  *gctrl = ctrl + group * HASHSET_GROUP_SIZE;
+		HASHSET_ELEMENT_TYPE *gvalues = values + group * HASHSET_GROUP_SIZE;
+		uint32	match;
+		uint32	empty = hashset_group_match_empty(gctrl);
+
+		match = hashset_group_match(gctrl, tag);
+		while (match != 0)
+		{
+			int		i = pg_rightmost_one_pos32(match);
+
+			if (gvalues[i] == value)
+			{
+				if (empty != 0)
+					gctrl[i] = HASHSET_CTRL_EMPTY;
+				else
+				{
+					gctrl[i] = HASHSET_CTRL_DELETED;
+					set->ndeleted++;
+				}
+
+				set->nelements--;
+				set->hash -= HASHSET_ELEMENT_HASH(value);
+
+				return true;
+			}
+
+			match &= (match - 1);
+		}
+
+		/* Found an empty slot, value is not there */
+		if (empty != 0)
+			return false;
+
+		group = (group + probe) & mask;
+	}
+
+	return false;
+}
+
+/*
+ * Remove an array of values from the hash table, in batches (the same way
+ * as HASHSET_KERNEL_ADD_VALUES). Returns the number of removed values.
+ */
+static int
+HASHSET_KERNEL_REMOVE_VALUES(HASHSET_TYPE *set, const HASHSET_ELEMENT_TYPE *values,
+							 int nvalues)
+{
+	int		i,
+			j;
+	int		nremoved = 0;
+	uint32	hashes[HASHSET_BATCH_SIZE];
+	uint32	mask = (set->capacity / HASHSET_GROUP_SIZE) - 1;
+
+	for (i = 0; i < nvalues && set->nelements > 0; i += HASHSET_BATCH_SIZE)
+	{
+		int		n = Min(HASHSET_BATCH_SIZE, nvalues - i);
+
+		for (j = 0; j < n; j++)
+		{
+			hashes[j] = HASHSET_KERNEL_HASH(values[i + j]);
+			hashset_prefetch_group(set, HASHSET_HASH_GROUP(hashes[j]) & mask);
+		}
+
+		for (j = 0; j < n; j++)
+		{
+			if (HASHSET_KERNEL_REMOVE_HASH(set, values[i + j], hashes[j]))
+				nremoved++;
+		}
+	}
+
+	return nremoved;
+}
+
+/*
+ * Add all elements of src (in any format) to the hash table.
+ */
+static HASHSET_TYPE *
+HASHSET_KERNEL_ADD_SET(HASHSET_TYPE *set, HASHSET_TYPE *src)
+{
+	HASHSET_ITERATOR	iter;
+	HASHSET_ELEMENT_TYPE	value;
+
+	HASHSET_NAME(iterator_init)(&iter, src);
+	while (HASHSET_NAME(iterator_next)(&iter, &value))
+		set = HASHSET_KERNEL_INSERT(set, value);
+
+	return set;
+}
+
+/*
+ * Add an array of values to the hash table.
+ *
+ * The values are processed in batches - we first calculate the hashes and
+ * prefetch the first group for each value, and only then do the inserts.
+ * For tables that don't fit into CPU caches this overlaps the cache misses
+ * instead of waiting for them one by one. The prefetch is just a hint, so
+ * it does not matter if the table gets resized in the middle of a batch.
+ */
+static HASHSET_TYPE *
+HASHSET_KERNEL_ADD_VALUES(HASHSET_TYPE *set, const HASHSET_ELEMENT_TYPE *values, int nvalues)
+{
+	int		i,
+			j;
+	uint32	hashes[HASHSET_BATCH_SIZE];
+
+	for (i = 0; i < nvalues; i += HASHSET_BATCH_SIZE)
+	{
+		int		n = Min(HASHSET_BATCH_SIZE, nvalues - i);
+		uint32	mask = (set->capacity / HASHSET_GROUP_SIZE) - 1;
+
+		for (j = 0; j < n; j++)
+		{
+			hashes[j] = HASHSET_KERNEL_HASH(values[i + j]);
+
+			if (set->capacity > 0)
+				hashset_prefetch_group(set, HASHSET_HASH_GROUP(hashes[j]) & mask);
+		}
+
+		for (j = 0; j < n; j++)
+			set = HASHSET_KERNEL_INSERT_HASH(set, values[i + j], hashes[j]);
+	}
+
+	return set;
+}
+
+/*
+ * Collect elements of src (in any format) that are (or are not, depending
+ * on "found") contained in the hash table. Returns the number of elements
+ * written to result, which needs space for all elements of src.
+ */
+static int
+HASHSET_KERNEL_FILTER(HASHSET_TYPE *set, HASHSET_TYPE *src, bool found,
+					  HASHSET_ELEMENT_TYPE *result)
+{
+	HASHSET_ITERATOR	iter;
+	HASHSET_ELEMENT_TYPE	value;
+	int						nresult = 0;
+
+	HASHSET_NAME(iterator_init)(&iter, src);
+	while (HASHSET_NAME(iterator_next)(&iter, &value))
+	{
+		if (HASHSET_KERNEL_LOOKUP(set, value) == found)
+			result[nresult++] = value;
+	}
+
+	return nresult;
+}
+
+/*
+ * Copy elements of the hash table src that are (or are not, depending on
+ * "found") contained in the hash table set into result, an empty hash
+ * table with the same capacity and hash function as src. The set has to
+ * use the same hash function too, so each element is hashed only once.
+ *
+ * Each element goes into the same slot it has in src, without probing
+ * result at all. That's only correct for elements stored in their home
+ * group - a lookup for an element pushed to a later group might stop at
+ * an empty slot of a group that is full in src but not in result. The
+ * few displaced elements are inserted the usual way at the end, when all
+ * the slots they might collide with are taken already.
+ */
+static HASHSET_TYPE *
+HASHSET_KERNEL_FILTER_ALIGNED(HASHSET_TYPE *result, HASHSET_TYPE *set,
+							  HASHSET_TYPE *src, bool found)
+{
+	uint32	group;
+	uint32	mask = src->capacity / HASHSET_GROUP_SIZE - 1;
+	uint8  *sctrl = HASHSET_GET_CTRL(src);
+	HASHSET_ELEMENT_TYPE *svalues = HASHSET_GET_VALUES(src);
+	uint8  *rctrl = HASHSET_GET_CTRL(result);
+	HASHSET_ELEMENT_TYPE *rvalues = HASHSET_GET_VALUES(result);
+	HASHSET_ELEMENT_TYPE *displaced = NULL;
+	uint32 *displaced_hashes = NULL;
+	int		ndisplaced = 0;
+	int		maxdisplaced = 0;
+	int		i;
+
+	Assert(!HASHSET_IS_COMPACT(set) && !HASHSET_IS_COMPACT(src));
+	Assert(set->hashfn_id == src->hashfn_id);
+	Assert(src->capacity == result->capacity && src->capacity > 0);
+	Assert(src->hashfn_id == result->hashfn_id && result->nelements == 0);
+
+	for (group = 0; group <= mask; group++)
+	{
+		uint32	match = hashset_group_match_full(sctrl + group * HASHSET_GROUP_SIZE);
+
+		while (match != 0)
+		{
+			int		slot = group * HASHSET_GROUP_SIZE + pg_rightmost_one_pos32(match);
+			HASHSET_ELEMENT_TYPE value = svalues[slot];
+			uint32	hash = HASHSET_KERNEL_HASH(value);
+
+			match &= (match - 1);
+
+			if (HASHSET_KERNEL_LOOKUP_HASH(set, value, hash) != found)
+				continue;
+
+			if ((HASHSET_HASH_GROUP(hash) & mask) == group)
+			{
+				rctrl[slot] = sctrl[slot];
+				rvalues[slot] = value;
+
+				result->nelements++;
+				result->hash += HASHSET_ELEMENT_HASH(value);
+				continue;
+			}
+
+			if (ndisplaced == maxdisplaced)
+			{
+				maxdisplaced = Max(maxdisplaced * 2, HASHSET_GROUP_SIZE);
+				if (displaced == NULL)
+				{
+					displaced = palloc(maxdisplaced * sizeof(HASHSET_ELEMENT_TYPE));
+					displaced_hashes = palloc(maxdisplaced * sizeof(uint32));
+				}
+				else
+				{
+					displaced = repalloc(displaced, maxdisplaced * sizeof(HASHSET_ELEMENT_TYPE));
+					displaced_hashes = repalloc(displaced_hashes,
+												maxdisplaced * sizeof(uint32));
+				}
+			}
+
+			displaced[ndisplaced] = value;
+			displaced_hashes[ndisplaced] = hash;
+			ndisplaced++;
+		}
+	}
+
+	for (i = 0; i < ndisplaced; i++)
+		result = HASHSET_KERNEL_INSERT_HASH(result, displaced[i],
+											displaced_hashes[i]);
+
+	if (displaced != NULL)
+	{
+		pfree(displaced);
+		pfree(displaced_hashes);
+	}
+
+	return result;
+}
+
+#undef HASHSET_KERNEL_MAKE_NAME_
+#undef HASHSET_KERNEL_MAKE_NAME
+#undef HASHSET_KERNEL_NAME
+#undef HASHSET_KERNEL_INSERT
+#undef HASHSET_KERNEL_INSERT_HASH
+#undef HASHSET_KERNEL_LOOKUP
+#undef HASHSET_KERNEL_LOOKUP_HASH
+#undef HASHSET_KERNEL_LOOKUP_VALUES
+#undef HASHSET_KERNEL_ADD_SET
+#undef HASHSET_KERNEL_ADD_VALUES
+#undef HASHSET_KERNEL_FILTER
+#undef HASHSET_KERNEL_FILTER_ALIGNED
+#undef HASHSET_KERNEL_REMOVE_HASH
+#undef HASHSET_KERNEL_REMOVE_VALUES
+#undef HASHSET_KERNEL_SUFFIX
+#undef HASHSET_KERNEL_HASH
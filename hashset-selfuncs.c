@@ -0,0 +1,511 @@
+/*
+ * hashset-selfuncs.c
+ *
+ * Selectivity estimation for the hashset containment and overlap operators.
+ *
+ * With element statistics (see hashset-typanalyze.c), the elements of the
+ * constant are looked up in the most common elements, and the elements are
+ * assumed to be independent: a set contains {a, b} with probability
+ * freq(a) * freq(b), and so on. The histogram of the number of elements is
+ * used for "contained by", and for the joins.
+ *
+ * Without statistics, the estimates are based on a simple model of the
+ * column: the sets have HASHSET_DEFAULT_NELEMENTS elements each, and each
+ * value is contained in HASHSET_DEFAULT_ELEM_SEL of the sets. That is, the
+ * elements are drawn from a "universe" of (nelements / elem_sel) values.
+ */
+
+#include "hashset.h"
+
+#include "access/htup_details.h"
+#include "catalog/pg_statistic.h"
+#include "utils/lsyscache.h"
+#include "utils/selfuncs.h"
+
+#include <math.h>
+
+#define HASHSET_DEFAULT_NELEMENTS	10
+#define HASHSET_DEFAULT_ELEM_SEL	0.005
+
+/* Operators we know how to estimate */
+#define HASHSET_SEL_CONTAINS		1	/* hashset @> hashset */
+#define HASHSET_SEL_CONTAINED		2	/* hashset <@ hashset */
+#define HASHSET_SEL_OVERLAP			3	/* hashset && hashset */
+#define HASHSET_SEL_CONTAINS_ELEM	4	/* hashset @> element */
+
+/* Element statistics of a hashset column */
+typedef struct hashset_stats_t
+{
+	Oid				elemtype;	/* element type of the hashset */
+	bool			have_mcelem;
+	bool			have_hist;
+	AttStatsSlot	mcelem;		/* most common elements and frequencies */
+	AttStatsSlot	hist;		/* histogram of the numbers of elements */
+} hashset_stats_t;
+
+static int hashset_sel_operator(Oid operator, Oid elemtype);
+static Selectivity hashset_restriction_sel(PlannerInfo *root, int op, List *args, int varRelid, Oid elemtype);
+static Selectivity hashset_join_sel(PlannerInfo *root, int op, List *args, SpecialJoinInfo *sjinfo, Oid elemtype);
+static Selectivity hashset_sel_model(int op, double nelements, double avg_count);
+static Selectivity hashset_sel_stats(int op, int64 *values, int nelements, bool null_element, hashset_stats_t *stats);
+static double hashset_sel_nullfrac(VariableStatData *vardata);
+static void hashset_load_stats(VariableStatData *vardata, Oid elemtype, hashset_stats_t *stats);
+static void hashset_free_stats(hashset_stats_t *stats);
+static double hashset_avg_count(hashset_stats_t *stats);
+static double hashset_elem_freq(hashset_stats_t *stats, int64 value);
+static double hashset_null_elem_freq(hashset_stats_t *stats);
+
+/*
+ * hashset_sel
+ *		Restriction selectivity of the containment and overlap operators.
+ *
+ * Called by the estimators of the hashset types (e.g. int4hashset_sel),
+ * with the element type of the set.
+ */
+Datum
+hashset_sel(FunctionCallInfo fcinfo, Oid elemtype)
+{
+	PlannerInfo	   *root = (PlannerInfo *) PG_GETARG_POINTER(0);
+	Oid				operator = PG_GETARG_OID(1);
+	List		   *args = (List *) PG_GETARG_POINTER(2);
+	int				varRelid = PG_GETARG_INT32(3);
+
+	PG_RETURN_FLOAT8(hashset_restriction_sel(root,
+											 hashset_sel_operator(operator, elemtype),
+											 args, varRelid, elemtype));
+}
+
+/*
+ * hashset_joinsel
+ *		Join selectivity of the containment and overlap operators.
+ */
+Datum
+hashset_joinsel(FunctionCallInfo fcinfo, Oid elemtype)
+{
+	PlannerInfo	   *root = (PlannerInfo *) PG_GETARG_POINTER(0);
+	Oid				operator = PG_GETARG_OID(1);
+	List		   *args = (List *) PG_GETARG_POINTER(2);
+	SpecialJoinInfo *sjinfo = (SpecialJoinInfo *) PG_GETARG_POINTER(4);
+
+	PG_RETURN_FLOAT8(hashset_join_sel(root,
+									  hashset_sel_operator(operator, elemtype),
+									  args, sjinfo, elemtype));
+}
+
+/*
+ * hashset_contains_sel
+ *		Selectivity of a hashset_contains() call (for its support function).
+ *
+ * hashset_contains(set, value) is true for the same rows as "set @> value",
+ * so it's estimated the same way.
+ */
+Selectivity
+hashset_contains_sel(PlannerInfo *root, List *args, int varRelid,
+					 bool is_join, SpecialJoinInfo *sjinfo, Oid elemtype)
+{
+	if (!is_join)
+		return hashset_restriction_sel(root, HASHSET_SEL_CONTAINS_ELEM,
+									   args, varRelid, elemtype);
+
+	if (sjinfo == NULL)
+		return hashset_sel_model(HASHSET_SEL_CONTAINS_ELEM, 1,
+								 HASHSET_DEFAULT_NELEMENTS);
+
+	return hashset_join_sel(root, HASHSET_SEL_CONTAINS_ELEM, args, sjinfo,
+							elemtype);
+}
+
+/*
+ * hashset_restriction_sel
+ *		Restriction selectivity of the operator op, with the given arguments.
+ */
+static Selectivity
+hashset_restriction_sel(PlannerInfo *root, int op, List *args, int varRelid,
+						Oid elemtype)
+{
+	VariableStatData vardata;
+	Node		   *other;
+	bool			varonleft;
+	Const		   *constant;
+	Selectivity		selec;
+	int64		   *values;
+	int				nelements;
+	bool			null_element;
+
+	if (!get_restriction_variable(root, args, varRelid,
+								  &vardata, &other, &varonleft))
+		return hashset_sel_model(op, -1, HASHSET_DEFAULT_NELEMENTS);
+
+	if (!IsA(other, Const))
+	{
+		ReleaseVariableStats(vardata);
+		return hashset_sel_model(op, -1, HASHSET_DEFAULT_NELEMENTS);
+	}
+
+	constant = (Const *) other;
+
+	/* all the operators are strict */
+	if (constant->constisnull)
+	{
+		ReleaseVariableStats(vardata);
+		return 0.0;
+	}
+
+	if (op == HASHSET_SEL_CONTAINS_ELEM && !varonleft)
+	{
+		/*
+		 * "constant @> column", i.e. the (integer) column has to be one of
+		 * the elements, like "column = ANY (constant)".
+		 */
+		bool			isdefault;
+		double			ndistinct;
+
+		values = hashset_datum_elements(constant->constvalue, elemtype,
+										&nelements, &null_element);
+		pfree(values);
+
+		ndistinct = get_variable_numdistinct(&vardata, &isdefault);
+
+		selec = nelements / Max(ndistinct, 1.0);
+	}
+	else
+	{
+		hashset_stats_t	stats;
+
+		/* "constant @> column" is "column <@ constant", and vice versa */
+		if (!varonleft && op == HASHSET_SEL_CONTAINS)
+			op = HASHSET_SEL_CONTAINED;
+		else if (!varonleft && op == HASHSET_SEL_CONTAINED)
+			op = HASHSET_SEL_CONTAINS;
+
+		hashset_load_stats(&vardata, elemtype, &stats);
+
+		if (op == HASHSET_SEL_CONTAINS_ELEM)
+		{
+			if (stats.have_mcelem)
+				selec = hashset_elem_freq(&stats,
+										  hashset_datum_element(constant->constvalue,
+																elemtype));
+			else
+				selec = hashset_sel_model(op, 1, hashset_avg_count(&stats));
+		}
+		else
+		{
+			values = hashset_datum_elements(constant->constvalue, elemtype,
+											&nelements, &null_element);
+
+			if (stats.have_mcelem)
+				selec = hashset_sel_stats(op, values, nelements, null_element,
+										  &stats);
+			else
+				selec = hashset_sel_model(op,
+										  nelements + (null_element ? 1 : 0),
+										  hashset_avg_count(&stats));
+
+			pfree(values);
+		}
+
+		hashset_free_stats(&stats);
+	}
+
+	selec *= (1.0 - hashset_sel_nullfrac(&vardata));
+
+	ReleaseVariableStats(vardata);
+
+	CLAMP_PROBABILITY(selec);
+
+	return selec;
+}
+
+/*
+ * hashset_join_sel
+ *		Join selectivity of the operator op, with the given arguments.
+ *
+ * For "set @> integer" a value matches a set with nelements elements with
+ * probability (nelements / ndistinct), where ndistinct is the number of
+ * distinct values of the integer column, and nelements is the average from
+ * the statistics. For the operators on two sets, we use the model with a
+ * "typical" set on both sides.
+ */
+static Selectivity
+hashset_join_sel(PlannerInfo *root, int op, List *args, SpecialJoinInfo *sjinfo,
+				 Oid elemtype)
+{
+	VariableStatData vardata1;
+	VariableStatData vardata2;
+	bool			join_is_reversed;
+	hashset_stats_t	stats;
+	double			avg_count;
+	Selectivity		selec;
+
+	get_join_variables(root, args, sjinfo,
+					   &vardata1, &vardata2, &join_is_reversed);
+
+	hashset_load_stats(&vardata1, elemtype, &stats);
+	avg_count = hashset_avg_count(&stats);
+	hashset_free_stats(&stats);
+
+	if (op == HASHSET_SEL_CONTAINS_ELEM)
+	{
+		bool	isdefault;
+		double	ndistinct = get_variable_numdistinct(&vardata2, &isdefault);
+
+		if (isdefault)
+			selec = hashset_sel_model(op, 1, avg_count);
+		else
+			selec = avg_count / Max(ndistinct, 1.0);
+	}
+	else
+		selec = hashset_sel_model(op, -1, avg_count);
+
+	selec *= (1.0 - hashset_sel_nullfrac(&vardata1));
+	selec *= (1.0 - hashset_sel_nullfrac(&vardata2));
+
+	ReleaseVariableStats(vardata1);
+	ReleaseVariableStats(vardata2);
+
+	CLAMP_PROBABILITY(selec);
+
+	return selec;
+}
+
+/*
+ * hashset_sel_operator
+ *		Identify the operator (we don't know the OIDs of our operators).
+ */
+static int
+hashset_sel_operator(Oid operator, Oid elemtype)
+{
+	char   *opname = get_opname(operator);
+	Oid		lefttype;
+	Oid		righttype;
+
+	if (opname == NULL)
+		elog(ERROR, "cache lookup failed for operator %u", operator);
+
+	op_input_types(operator, &lefttype, &righttype);
+
+	if (strcmp(opname, "@>") == 0)
+		return (righttype == elemtype) ? HASHSET_SEL_CONTAINS_ELEM : HASHSET_SEL_CONTAINS;
+	else if (strcmp(opname, "<@") == 0)
+		return HASHSET_SEL_CONTAINED;
+	else if (strcmp(opname, "&&") == 0)
+		return HASHSET_SEL_OVERLAP;
+
+	elog(ERROR, "unexpected hashset operator \"%s\"", opname);
+	pg_unreachable();
+}
+
+/*
+ * hashset_sel_model
+ *		Selectivity of the operator with a constant of nelements elements,
+ *		without element statistics.
+ *
+ * The sets are assumed to have avg_count elements. A negative nelements
+ * means the constant is not known, and we assume it's a "typical" set (for
+ * containment a single element, so that we don't underestimate too much).
+ */
+static Selectivity
+hashset_sel_model(int op, double nelements, double avg_count)
+{
+	double	m = Max(avg_count, 1.0);
+	double	p = HASHSET_DEFAULT_ELEM_SEL;
+	double	universe = m / p;
+
+	switch (op)
+	{
+		case HASHSET_SEL_CONTAINS_ELEM:
+			return p;
+
+		case HASHSET_SEL_CONTAINS:
+			/* each element has to be in the set */
+			if (nelements < 0)
+				return p;
+			return pow(p, nelements);
+
+		case HASHSET_SEL_CONTAINED:
+			/* each of the m elements of the set has to be in the constant */
+			if (nelements < 0)
+				return p;
+			return pow(Min(1.0, nelements / universe), m);
+
+		case HASHSET_SEL_OVERLAP:
+			/* at least one of the m elements has to be in the constant */
+			if (nelements < 0)
+				nelements = m;
+			return 1.0 - pow(Max(0.0, 1.0 - nelements / universe), m);
+	}
+
+	elog(ERROR, "unexpected hashset operator %d", op);
+	pg_unreachable();
+}
+
+/*
+ * hashset_sel_stats
+ *		Selectivity of the operator with a constant set, using the most
+ *		common elements.
+ *
+ * For "contained by", the sum of the frequencies of the constant's elements
+ * divided by the average number of elements is the probability that an
+ * element of a set is one of them. A set of n elements is then contained
+ * with probability q^n, which we average over the histogram of the numbers
+ * of elements (so empty sets are always contained, as they should).
+ */
+static Selectivity
+hashset_sel_stats(int op, int64 *values, int nelements, bool null_element,
+				  hashset_stats_t *stats)
+{
+	double		freq;
+	Selectivity	selec;
+
+	switch (op)
+	{
+		case HASHSET_SEL_CONTAINS:
+			selec = 1.0;
+			if (null_element)
+				selec *= hashset_null_elem_freq(stats);
+
+			for (int i = 0; i < nelements; i++)
+				selec *= hashset_elem_freq(stats, values[i]);
+
+			return selec;
+
+		case HASHSET_SEL_OVERLAP:
+			selec = 1.0;
+			if (null_element)
+				selec *= (1.0 - hashset_null_elem_freq(stats));
+
+			for (int i = 0; i < nelements; i++)
+				selec *= (1.0 - hashset_elem_freq(stats, values[i]));
+
+			return 1.0 - selec;
+
+		case HASHSET_SEL_CONTAINED:
+			freq = null_element ? hashset_null_elem_freq(stats) : 0.0;
+
+			for (int i = 0; i < nelements; i++)
+				freq += hashset_elem_freq(stats, values[i]);
+
+			freq = Min(1.0, freq / Max(hashset_avg_count(stats), 1.0));
+
+			if (!stats->have_hist)
+				return pow(freq, hashset_avg_count(stats));
+
+			/* the last number is the average, not a histogram boundary */
+			selec = 0.0;
+			for (int i = 0; i < stats->hist.nnumbers - 1; i++)
+				selec += pow(freq, stats->hist.numbers[i]);
+
+			return selec / (stats->hist.nnumbers - 1);
+	}
+
+	elog(ERROR, "unexpected hashset operator %d", op);
+	pg_unreachable();
+}
+
+static double
+hashset_sel_nullfrac(VariableStatData *vardata)
+{
+	if (!HeapTupleIsValid(vardata->statsTuple))
+		return 0.0;
+
+	return ((Form_pg_statistic) GETSTRUCT(vardata->statsTuple))->stanullfrac;
+}
+
+/*
+ * hashset_load_stats
+ *		Fetch the element statistics of a hashset column (if any).
+ */
+static void
+hashset_load_stats(VariableStatData *vardata, Oid elemtype,
+				   hashset_stats_t *stats)
+{
+	stats->elemtype = elemtype;
+	stats->have_mcelem = false;
+	stats->have_hist = false;
+
+	if (!HeapTupleIsValid(vardata->statsTuple) ||
+		!statistic_proc_security_check(vardata,
+									   get_opcode(hashset_element_eq_operator(elemtype))))
+		return;
+
+	/* the frequencies are followed by the min, max and NULL frequencies */
+	stats->have_mcelem = get_attstatsslot(&stats->mcelem, vardata->statsTuple,
+										  STATISTIC_KIND_MCELEM, InvalidOid,
+										  ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS);
+
+	if (stats->have_mcelem &&
+		stats->mcelem.nnumbers != stats->mcelem.nvalues + 3)
+	{
+		free_attstatsslot(&stats->mcelem);
+		stats->have_mcelem = false;
+	}
+
+	/* at least two boundaries, followed by the average */
+	stats->have_hist = get_attstatsslot(&stats->hist, vardata->statsTuple,
+										STATISTIC_KIND_DECHIST, InvalidOid,
+										ATTSTATSSLOT_NUMBERS);
+
+	if (stats->have_hist && stats->hist.nnumbers < 3)
+	{
+		free_attstatsslot(&stats->hist);
+		stats->have_hist = false;
+	}
+}
+
+static void
+hashset_free_stats(hashset_stats_t *stats)
+{
+	if (stats->have_mcelem)
+		free_attstatsslot(&stats->mcelem);
+
+	if (stats->have_hist)
+		free_attstatsslot(&stats->hist);
+}
+
+static double
+hashset_avg_count(hashset_stats_t *stats)
+{
+	if (!stats->have_hist)
+		return HASHSET_DEFAULT_NELEMENTS;
+
+	return stats->hist.numbers[stats->hist.nnumbers - 1];
+}
+
+/*
+ * hashset_elem_freq
+ *		Frequency of an element, using a binary search in the (sorted) most
+ *		common elements.
+ *
+ * Elements not in the list are less frequent than all of them, we assume
+ * half the minimum frequency (as array_selfuncs.c does).
+ */
+static double
+hashset_elem_freq(hashset_stats_t *stats, int64 value)
+{
+	int		lo = 0;
+	int		hi = stats->mcelem.nvalues - 1;
+
+	while (lo <= hi)
+	{
+		int		mid = lo + (hi - lo) / 2;
+		int64	elem = hashset_datum_element(stats->mcelem.values[mid],
+												 stats->elemtype);
+
+		if (elem == value)
+			return stats->mcelem.numbers[mid];
+		else if (elem < value)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+
+	return Min(HASHSET_DEFAULT_ELEM_SEL,
+			   stats->mcelem.numbers[stats->mcelem.nvalues] / 2);
+}
+
+static double
+hashset_null_elem_freq(hashset_stats_t *stats)
+{
+	return stats->mcelem.numbers[stats->mcelem.nvalues + 2];
+}
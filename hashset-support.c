@@ -0,0 +1,410 @@
+/*
+ * hashset-support.c
+ *
+ * Planner support functions for the hashset functions. They are shared by
+ * all the hashset types, the element type is determined from the call
+ * (e.g. the type of the value passed to hashset_contains).
+ */
+
+#include "hashset.h"
+
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "nodes/supportnodes.h"
+#include "optimizer/optimizer.h"
+#include "parser/parse_func.h"
+
+PG_FUNCTION_INFO_V1(int4hashset_support);
+PG_FUNCTION_INFO_V1(int4hashset_elements_support);
+PG_FUNCTION_INFO_V1(int4hashset_contains_support);
+
+Datum int4hashset_support(PG_FUNCTION_ARGS);
+Datum int4hashset_elements_support(PG_FUNCTION_ARGS);
+Datum int4hashset_contains_support(PG_FUNCTION_ARGS);
+
+static Node *hashset_contains_simplify(SupportRequestSimplify *req);
+static List *hashset_contains_index_condition(SupportRequestIndexCondition *req);
+static Node *hashset_elements_array(Node *setarg, Oid elemtype, Oid funcid);
+
+#if PG_VERSION_NUM >= 180000
+static bool hashset_references_param(Node *node, int *paramid);
+#endif
+
+/*
+ * int4hashset_support
+ *		Planner support function for hashset_add(), hashset_remove() and
+ *		hashset_union().
+ *
+ * Since PostgreSQL 18, PL/pgSQL asks the support function whether it may
+ * pass the target variable of an assignment like "s := hashset_add(s, x)"
+ * as a read/write expanded datum. If we say yes, the set is modified in
+ * place instead of being copied for every element.
+ */
+Datum
+int4hashset_support(PG_FUNCTION_ARGS)
+{
+	Node	   *ret = NULL;
+
+#if PG_VERSION_NUM >= 180000
+	Node	   *rawreq = (Node *) PG_GETARG_POINTER(0);
+
+	if (IsA(rawreq, SupportRequestModifyInPlace))
+	{
+		SupportRequestModifyInPlace *req = (SupportRequestModifyInPlace *) rawreq;
+		Param	   *arg = (Param *) linitial(req->args);
+		ListCell   *lc;
+
+		if (arg == NULL || !IsA(arg, Param) ||
+			arg->paramkind != PARAM_EXTERN ||
+			arg->paramid != req->paramid)
+			PG_RETURN_POINTER(NULL);
+
+		/*
+		 * The set must not be referenced by the other arguments, otherwise
+		 * hashset_union(s, s) might modify (and free) the set it's reading.
+		 */
+		for_each_from(lc, req->args, 1)
+		{
+			if (hashset_references_param((Node *) lfirst(lc), &req->paramid))
+				PG_RETURN_POINTER(NULL);
+		}
+
+		ret = (Node *) arg;
+	}
+#endif
+
+	PG_RETURN_POINTER(ret);
+}
+
+/*
+ * int4hashset_elements_support
+ *		Planner support function for hashset_elements().
+ *
+ * When the set is a constant, the number of rows is simply its cardinality.
+ * Otherwise we don't know anything, and the planner uses the ROWS estimate
+ * from the function definition.
+ */
+Datum
+int4hashset_elements_support(PG_FUNCTION_ARGS)
+{
+	Node	   *rawreq = (Node *) PG_GETARG_POINTER(0);
+	Node	   *ret = NULL;
+
+	if (IsA(rawreq, SupportRequestRows))
+	{
+		SupportRequestRows *req = (SupportRequestRows *) rawreq;
+
+		if (is_funcclause(req->node))
+		{
+			FuncExpr   *expr = (FuncExpr *) req->node;
+			Node	   *arg = (Node *) linitial(expr->args);
+
+			if (IsA(arg, Const) && !((Const *) arg)->constisnull)
+			{
+				int64  *values;
+				int		nelements;
+				bool	null_element;
+
+				/* the function returns the elements, so that's the type */
+				values = hashset_datum_elements(((Const *) arg)->constvalue,
+												expr->funcresulttype,
+												&nelements, &null_element);
+				pfree(values);
+
+				req->rows = nelements + (null_element ? 1 : 0);
+				ret = (Node *) req;
+			}
+		}
+	}
+
+	PG_RETURN_POINTER(ret);
+}
+
+/*
+ * int4hashset_contains_support
+ *		Planner support function for hashset_contains().
+ *
+ * Without this, hashset_contains() is a black box to the planner: it gets a
+ * default selectivity, and can't use indexes. So we
+ *
+ * - estimate the selectivity the same way as for "set @> value",
+ *
+ * - simplify calls with an empty or single-element constant set to "false"
+ *   and "value = element", which the planner understands much better,
+ *
+ * - turn hashset_contains(set, column) into "column = ANY (array)" with the
+ *   elements of the set, usable by btree indexes on the integer column, and
+ *   hashset_contains(column, value) into "column @> value", usable by GIN
+ *   indexes on the hashset column.
+ */
+Datum
+int4hashset_contains_support(PG_FUNCTION_ARGS)
+{
+	Node	   *rawreq = (Node *) PG_GETARG_POINTER(0);
+	Node	   *ret = NULL;
+
+	if (IsA(rawreq, SupportRequestSimplify))
+	{
+		ret = hashset_contains_simplify((SupportRequestSimplify *) rawreq);
+	}
+	else if (IsA(rawreq, SupportRequestSelectivity))
+	{
+		SupportRequestSelectivity *req = (SupportRequestSelectivity *) rawreq;
+
+		req->selectivity = hashset_contains_sel(req->root, req->args,
+												req->varRelid,
+												req->is_join,
+												req->sjinfo,
+												exprType((Node *) lsecond(req->args)));
+		ret = (Node *) req;
+	}
+	else if (IsA(rawreq, SupportRequestIndexCondition))
+	{
+		ret = (Node *) hashset_contains_index_condition((SupportRequestIndexCondition *) rawreq);
+	}
+
+	PG_RETURN_POINTER(ret);
+}
+
+/*
+ * hashset_contains_simplify
+ *		Replace hashset_contains() with a trivial constant set.
+ *
+ * An empty set (without the NULL element) contains nothing, even for NULL
+ * values. A set with a single (non-NULL) element is the same as comparing
+ * the value to the element, including the NULL result for NULL values.
+ */
+static Node *
+hashset_contains_simplify(SupportRequestSimplify *req)
+{
+	FuncExpr	   *expr = req->fcall;
+	Node		   *setarg;
+	Node		   *valuearg;
+	Oid				elemtype;
+	int64		   *values;
+	int				nelements;
+	bool			null_element;
+
+	if (list_length(expr->args) != 2)
+		return NULL;
+
+	setarg = (Node *) linitial(expr->args);
+	valuearg = (Node *) lsecond(expr->args);
+
+	if (!IsA(setarg, Const) || ((Const *) setarg)->constisnull)
+		return NULL;
+
+	elemtype = exprType(valuearg);
+	values = hashset_datum_elements(((Const *) setarg)->constvalue, elemtype,
+									&nelements, &null_element);
+
+	if (null_element)
+		return NULL;
+
+	if (nelements == 0)
+	{
+		/* don't throw away volatile expressions */
+		if (contain_volatile_functions(valuearg))
+			return NULL;
+
+		return makeBoolConst(false, false);
+	}
+
+	if (nelements == 1)
+	{
+		Oid			eq_opr = hashset_element_eq_operator(elemtype);
+		int16		typlen;
+		bool		typbyval;
+		OpExpr	   *clause;
+
+		get_typlenbyval(elemtype, &typlen, &typbyval);
+
+		clause = (OpExpr *) make_opclause(eq_opr, BOOLOID, false,
+										  (Expr *) valuearg,
+										  (Expr *) makeConst(elemtype, -1, InvalidOid,
+															 typlen,
+															 hashset_element_datum(values[0],
+																				   elemtype),
+															 false, typbyval),
+										  InvalidOid, InvalidOid);
+		clause->opfuncid = get_opcode(eq_opr);
+		clause->location = expr->location;
+
+		return (Node *) clause;
+	}
+
+	return NULL;
+}
+
+/*
+ * hashset_contains_index_condition
+ *		Derive an index condition from a hashset_contains() call.
+ *
+ * The conditions are exact (not lossy), as they're true for exactly the same
+ * rows as the call itself (NULL and false are the same thing in WHERE).
+ */
+static List *
+hashset_contains_index_condition(SupportRequestIndexCondition *req)
+{
+	FuncExpr   *expr;
+	Node	   *setarg;
+	Node	   *valuearg;
+	Oid			elemtype;
+
+	if (!is_funcclause(req->node))
+		return NIL;
+
+	expr = (FuncExpr *) req->node;
+
+	if (list_length(expr->args) != 2)
+		return NIL;
+
+	setarg = (Node *) linitial(expr->args);
+	valuearg = (Node *) lsecond(expr->args);
+	elemtype = exprType(valuearg);
+
+	if (req->indexarg == 1)
+	{
+		ScalarArrayOpExpr  *saop;
+		Node			   *array;
+		Oid					eq_opr = hashset_element_eq_operator(elemtype);
+
+		/*
+		 * hashset_contains(set, column) is "column = ANY (elements)". Only
+		 * for indexes that can search for arrays natively (btree), the
+		 * planner doesn't expect other indexes to get such conditions.
+		 */
+		if (!req->index->amsearcharray ||
+			!op_in_opfamily(eq_opr, req->opfamily) ||
+			!is_pseudo_constant_for_index(req->root, setarg, req->index))
+			return NIL;
+
+		array = hashset_elements_array(setarg, elemtype, expr->funcid);
+		if (array == NULL)
+			return NIL;
+
+		saop = makeNode(ScalarArrayOpExpr);
+		saop->opno = eq_opr;
+		saop->opfuncid = get_opcode(eq_opr);
+		saop->useOr = true;
+		saop->inputcollid = InvalidOid;
+		saop->args = list_make2(valuearg, array);
+		saop->location = expr->location;
+
+		req->lossy = false;
+
+		return list_make1(saop);
+	}
+	else if (req->indexarg == 0)
+	{
+		OpExpr	   *clause;
+		Oid			opno;
+
+		/* hashset_contains(column, value) is "column @> value" */
+		opno = get_opfamily_member(req->opfamily, exprType(setarg), elemtype,
+								   HASHSET_GIN_CONTAINS_ELEM_STRATEGY);
+
+		if (!OidIsValid(opno) ||
+			!is_pseudo_constant_for_index(req->root, valuearg, req->index))
+			return NIL;
+
+		clause = (OpExpr *) make_opclause(opno, BOOLOID, false,
+										  (Expr *) setarg, (Expr *) valuearg,
+										  InvalidOid, InvalidOid);
+		set_opfuncid(clause);
+		clause->location = expr->location;
+
+		req->lossy = false;
+
+		return list_make1(clause);
+	}
+
+	return NIL;
+}
+
+/*
+ * hashset_elements_array
+ *		Build an expression returning the elements of a set as an array.
+ *
+ * For a constant set the array is built right away (with sorted elements,
+ * which is what the index scan needs anyway), otherwise we call the
+ * hashset_to_array() function from the same schema as hashset_contains().
+ * The NULL element is left out, it can't match anything.
+ */
+static Node *
+hashset_elements_array(Node *setarg, Oid elemtype, Oid funcid)
+{
+	List   *funcname;
+	Oid		argtypes[1];
+	Oid		to_array;
+	Oid		arraytype = get_array_type(elemtype);
+
+	if (!OidIsValid(arraytype))
+		return NULL;
+
+	if (IsA(setarg, Const))
+	{
+		int64		   *values;
+		int				nelements;
+		bool			null_element;
+		Datum		   *elems;
+		ArrayType	   *array;
+		int16			typlen;
+		bool			typbyval;
+		char			typalign;
+
+		if (((Const *) setarg)->constisnull)
+			return (Node *) makeNullConst(arraytype, -1, InvalidOid);
+
+		values = hashset_datum_elements(((Const *) setarg)->constvalue,
+										elemtype, &nelements, &null_element);
+		elems = (Datum *) palloc(Max(nelements, 1) * sizeof(Datum));
+
+		for (int i = 0; i < nelements; i++)
+			elems[i] = hashset_element_datum(values[i], elemtype);
+
+		get_typlenbyvalalign(elemtype, &typlen, &typbyval, &typalign);
+
+		if (nelements == 0)
+			array = construct_empty_array(elemtype);
+		else
+			array = construct_array(elems, nelements, elemtype,
+									typlen, typbyval, typalign);
+
+		return (Node *) makeConst(arraytype, -1, InvalidOid, -1,
+								  PointerGetDatum(array), false, false);
+	}
+
+	funcname = list_make2(makeString(get_namespace_name(get_func_namespace(funcid))),
+						  makeString("hashset_to_array"));
+	argtypes[0] = exprType(setarg);
+
+	to_array = LookupFuncName(funcname, 1, argtypes, true);
+	if (!OidIsValid(to_array))
+		return NULL;
+
+	return (Node *) makeFuncExpr(to_array, arraytype, list_make1(setarg),
+								 InvalidOid, InvalidOid, COERCE_EXPLICIT_CALL);
+}
+
+#if PG_VERSION_NUM >= 180000
+/*
+ * Does the expression reference the external parameter paramid?
+ */
+static bool
+hashset_references_param(Node *node, int *paramid)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Param))
+	{
+		Param	   *param = (Param *) node;
+
+		if (param->paramkind == PARAM_EXTERN && param->paramid == *paramid)
+			return true;
+	}
+
+	return expression_tree_walker(node, hashset_references_param, paramid);
+}
+#endif
@@ -0,0 +1,1380 @@
+/*
+ * hashset-text.c
+ *
+ * texthashset, a hashset of text values.
+ *
+ * The elements have variable length, so they are not stored in the hash
+ * table itself. The bytes of all elements are kept one after another in a
+ * single arena, and each element is identified by its index - the start of
+ * its bytes in the arena and its hash are kept in arrays indexed by it.
+ * The hash table (control bytes and group probing, the same as for
+ * int4hashset) only maps the slots to element indexes. So adding a string
+ * just copies it at the end of the arena (there's no palloc per element),
+ * and thanks to the cached hashes, neither resizing the table nor merging
+ * sets has to hash the strings again.
+ *
+ * The flat (on-disk) format is the same arrays without the hash table: the
+ * header, the hashes, the offsets and the arena. Flattening is thus just a
+ * couple of memcpy calls, and the table is rebuilt from the cached hashes.
+ * Functions doing a single lookup scan the hashes in the flat format, and
+ * don't build the table at all (unless the set is a constant).
+ *
+ * The elements are compared byte by byte, so only deterministic collations
+ * are supported (in those, strings are equal only when the bytes are).
+ */
+
+#include "hashset.h"
+
+#include "catalog/pg_collation.h"
+#include "funcapi.h"
+#include "mb/pg_wchar.h"
+#include "utils/fmgroids.h"
+
+PG_FUNCTION_INFO_V1(texthashset_in);
+PG_FUNCTION_INFO_V1(texthashset_out);
+PG_FUNCTION_INFO_V1(texthashset_send);
+PG_FUNCTION_INFO_V1(texthashset_recv);
+PG_FUNCTION_INFO_V1(texthashset_init);
+PG_FUNCTION_INFO_V1(texthashset_add);
+PG_FUNCTION_INFO_V1(texthashset_contains);
+PG_FUNCTION_INFO_V1(texthashset_union);
+PG_FUNCTION_INFO_V1(texthashset_cardinality);
+PG_FUNCTION_INFO_V1(texthashset_capacity);
+PG_FUNCTION_INFO_V1(texthashset_to_array);
+PG_FUNCTION_INFO_V1(texthashset_to_sorted_array);
+PG_FUNCTION_INFO_V1(texthashset_elements);
+PG_FUNCTION_INFO_V1(texthashset_from_array);
+PG_FUNCTION_INFO_V1(texthashset_eq);
+PG_FUNCTION_INFO_V1(texthashset_ne);
+PG_FUNCTION_INFO_V1(texthashset_hash);
+PG_FUNCTION_INFO_V1(texthashset_hash_extended);
+PG_FUNCTION_INFO_V1(texthashset_agg_add);
+PG_FUNCTION_INFO_V1(texthashset_agg_add_set);
+PG_FUNCTION_INFO_V1(texthashset_agg_final);
+PG_FUNCTION_INFO_V1(texthashset_agg_combine);
+PG_FUNCTION_INFO_V1(texthashset_agg_serial);
+PG_FUNCTION_INFO_V1(texthashset_agg_deserial);
+
+Datum texthashset_in(PG_FUNCTION_ARGS);
+Datum texthashset_out(PG_FUNCTION_ARGS);
+Datum texthashset_send(PG_FUNCTION_ARGS);
+Datum texthashset_recv(PG_FUNCTION_ARGS);
+Datum texthashset_init(PG_FUNCTION_ARGS);
+Datum texthashset_add(PG_FUNCTION_ARGS);
+Datum texthashset_contains(PG_FUNCTION_ARGS);
+Datum texthashset_union(PG_FUNCTION_ARGS);
+Datum texthashset_cardinality(PG_FUNCTION_ARGS);
+Datum texthashset_capacity(PG_FUNCTION_ARGS);
+Datum texthashset_to_array(PG_FUNCTION_ARGS);
+Datum texthashset_to_sorted_array(PG_FUNCTION_ARGS);
+Datum texthashset_elements(PG_FUNCTION_ARGS);
+Datum texthashset_from_array(PG_FUNCTION_ARGS);
+Datum texthashset_eq(PG_FUNCTION_ARGS);
+Datum texthashset_ne(PG_FUNCTION_ARGS);
+Datum texthashset_hash(PG_FUNCTION_ARGS);
+Datum texthashset_hash_extended(PG_FUNCTION_ARGS);
+Datum texthashset_agg_add(PG_FUNCTION_ARGS);
+Datum texthashset_agg_add_set(PG_FUNCTION_ARGS);
+Datum texthashset_agg_final(PG_FUNCTION_ARGS);
+Datum texthashset_agg_combine(PG_FUNCTION_ARGS);
+Datum texthashset_agg_serial(PG_FUNCTION_ARGS);
+Datum texthashset_agg_deserial(PG_FUNCTION_ARGS);
+
+/*
+ * The flat format. The data are the hashes (nelements), the offsets of the
+ * elements in the arena (nelements + 1, the last one is the arena length)
+ * and the arena.
+ */
+typedef struct texthashset_t {
+	int32		vl_len_;		/* Varlena header (do not touch directly!) */
+	int32		flags;			/* Reserved for future use (versioning, ...) */
+	int32		capacity;		/* Capacity of the hash table (when built) */
+	int32		nelements;		/* Number of elements */
+	float4		load_factor;	/* Load factor before triggering resize */
+	float4		growth_factor;	/* Growth factor when resizing the hashset */
+	bool		null_element;	/* Indicates if null is present in hashset */
+	uint32		data[FLEXIBLE_ARRAY_MEMBER];
+} texthashset_t;
+
+#define TEXTHASHSET_HASHES(set)		((set)->data)
+#define TEXTHASHSET_OFFSETS(set)	((set)->data + (set)->nelements)
+#define TEXTHASHSET_ARENA(set)		((char *) ((set)->data + 2 * (set)->nelements + 1))
+
+#define PG_GETARG_TEXTHASHSET(x)	((texthashset_t *) PG_DETOAST_DATUM(PG_GETARG_DATUM(x)))
+
+/*
+ * The in-memory hash table, used to build sets (e.g. in aggregates) and for
+ * lookups in constant sets. All the arrays are in the same memory context,
+ * and grow independently.
+ */
+typedef struct texthashset_table_t {
+	int32		capacity;		/* Number of slots */
+	int32		nelements;		/* Number of elements */
+	float4		load_factor;	/* Load factor before triggering resize */
+	float4		growth_factor;	/* Growth factor when resizing the table */
+	bool		null_element;	/* Indicates if null is present in hashset */
+	uint8	   *ctrl;			/* Control bytes (capacity) */
+	int32	   *slots;			/* Element index for each slot (capacity) */
+	uint32	   *hashes;			/* Hash of each element */
+	uint32	   *offsets;		/* Start of each element in the arena, and
+								 * the end of the last one */
+	char	   *arena;			/* Bytes of the elements */
+	int32		maxelements;	/* Allocated length of hashes (and offsets) */
+	Size		arena_size;		/* Allocated length of the arena */
+	MemoryContext mcxt;			/* Memory context of the arrays */
+} texthashset_table_t;
+
+/* Constant set argument of a lookup function, with the table built for it */
+typedef struct texthashset_arg_cache_t {
+	Pointer		source;			/* Datum the table was built from */
+	texthashset_table_t *table;	/* The hash table */
+} texthashset_arg_cache_t;
+
+static texthashset_table_t *texthashset_table_create(int capacity, float4 load_factor, float4 growth_factor);
+static void texthashset_table_grow(texthashset_table_t *table, int64 nelements, Size arena_len);
+static void texthashset_table_resize(texthashset_table_t *table, int capacity);
+static void texthashset_table_reserve(texthashset_table_t *table, int64 nelements);
+static void texthashset_table_place(texthashset_table_t *table, int32 index);
+static int32 texthashset_table_find(texthashset_table_t *table, uint32 hash, const char *str, int len);
+static bool texthashset_table_insert(texthashset_table_t *table, uint32 hash, const char *str, int len);
+static void texthashset_table_add_set(texthashset_table_t *table, texthashset_t *set);
+static texthashset_table_t *texthashset_table_from_flat(texthashset_t *set);
+static texthashset_t *texthashset_table_flatten(texthashset_table_t *table);
+static bool texthashset_flat_contains(texthashset_t *set, uint32 hash, const char *str, int len);
+static texthashset_t *texthashset_flat_append(texthashset_t *set, uint32 hash, const char *str, int len);
+static texthashset_table_t *texthashset_table_from_array(ArrayType *array);
+static Datum texthashset_to_text_array(texthashset_t *set, bool sorted);
+static uint64 texthashset_canonical_hash(texthashset_t *set, uint64 seed);
+static bool texthashset_equal(texthashset_t *a, texthashset_t *b);
+static int texthashset_round_capacity(int capacity);
+static void texthashset_check_collation(Oid collid);
+static int texthashset_element_cmp(const void *a, const void *b, void *arg);
+
+/* Hash of an element (the hash function is not configurable) */
+static inline uint32
+texthashset_hash_bytes(const char *str, int len)
+{
+	return hash_bytes((const unsigned char *) str, len);
+}
+
+/*
+ * texthashset_check_collation
+ *		Elements are compared bytewise, which is correct only for
+ *		deterministic collations.
+ *
+ * The database default and C collations are always deterministic, so we
+ * skip the catalog lookup for them (this is called for each row).
+ */
+static void
+texthashset_check_collation(Oid collid)
+{
+	if (!OidIsValid(collid) || collid == DEFAULT_COLLATION_OID ||
+		collid == C_COLLATION_OID)
+		return;
+
+	if (!get_collation_isdeterministic(collid))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("nondeterministic collations are not supported for texthashset")));
+}
+
+/*
+ * texthashset_round_capacity
+ *		Round the capacity up to a power of two (at least one group).
+ */
+static int
+texthashset_round_capacity(int capacity)
+{
+	uint64	rounded;
+
+	if (capacity == 0)
+		return 0;
+
+	/* check the rounded capacity, that's what gets allocated */
+	rounded = (capacity < 0) ? PG_UINT64_MAX :
+		Max(HASHSET_GROUP_SIZE, pg_nextpower2_64((uint64) capacity));
+
+	if (rounded > MaxAllocSize / (sizeof(int32) + 1))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("hashset capacity %d is too large", capacity)));
+
+	return (int) rounded;
+}
+
+/*
+ * texthashset_table_create
+ *		Create an empty table in the current memory context.
+ */
+static texthashset_table_t *
+texthashset_table_create(int capacity, float4 load_factor, float4 growth_factor)
+{
+	texthashset_table_t *table;
+
+	table = (texthashset_table_t *) palloc0(sizeof(texthashset_table_t));
+
+	table->mcxt = CurrentMemoryContext;
+	table->load_factor = load_factor;
+	table->growth_factor = growth_factor;
+
+	texthashset_table_grow(table, 0, 0);
+	texthashset_table_resize(table, capacity);
+
+	return table;
+}
+
+/*
+ * texthashset_table_grow
+ *		Make sure there's space for nelements elements, with arena_len bytes
+ *		in total. The arrays are doubled, so that adding elements one by one
+ *		is not quadratic.
+ */
+static void
+texthashset_table_grow(texthashset_table_t *table, int64 nelements,
+					   Size arena_len)
+{
+	if (table->hashes == NULL || nelements > table->maxelements)
+	{
+		int64	n = Max(Max(nelements, 2 * (int64) table->maxelements), 8);
+
+		if (nelements >= MaxAllocSize / sizeof(uint32))
+			ereport(ERROR,
+					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+					 errmsg("texthashset is too large")));
+
+		n = Min(n, MaxAllocSize / sizeof(uint32) - 1);
+
+		if (table->hashes == NULL)
+		{
+			table->hashes = (uint32 *) MemoryContextAlloc(table->mcxt, n * sizeof(uint32));
+			table->offsets = (uint32 *) MemoryContextAlloc(table->mcxt, (n + 1) * sizeof(uint32));
+			table->offsets[0] = 0;
+		}
+		else
+		{
+			table->hashes = (uint32 *) repalloc(table->hashes, n * sizeof(uint32));
+			table->offsets = (uint32 *) repalloc(table->offsets, (n + 1) * sizeof(uint32));
+		}
+
+		table->maxelements = (int32) n;
+	}
+
+	if (table->arena == NULL || arena_len > table->arena_size)
+	{
+		Size	n = Max(Max(arena_len, 2 * table->arena_size), 256);
+
+		if (arena_len > MaxAllocSize)
+			ereport(ERROR,
+					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+					 errmsg("texthashset is too large")));
+
+		n = Min(n, MaxAllocSize);
+
+		if (table->arena == NULL)
+			table->arena = (char *) MemoryContextAlloc(table->mcxt, n);
+		else
+			table->arena = (char *) repalloc(table->arena, n);
+
+		table->arena_size = n;
+	}
+}
+
+/*
+ * texthashset_table_resize
+ *		Rebuild the hash table with the new capacity, using the cached
+ *		hashes (the elements themselves stay where they are).
+ */
+static void
+texthashset_table_resize(texthashset_table_t *table, int capacity)
+{
+	capacity = texthashset_round_capacity(capacity);
+
+	if (table->ctrl != NULL)
+	{
+		pfree(table->ctrl);
+		pfree(table->slots);
+	}
+
+	table->capacity = capacity;
+	table->ctrl = NULL;
+	table->slots = NULL;
+
+	if (capacity == 0)
+		return;
+
+	table->ctrl = (uint8 *) MemoryContextAlloc(table->mcxt, capacity);
+	table->slots = (int32 *) MemoryContextAlloc(table->mcxt, capacity * sizeof(int32));
+
+	memset(table->ctrl, HASHSET_CTRL_EMPTY, capacity);
+
+	for (int32 i = 0; i < table->nelements; i++)
+		texthashset_table_place(table, i);
+}
+
+/*
+ * texthashset_table_reserve
+ *		Make sure the table can hold nelements without resizing.
+ */
+static void
+texthashset_table_reserve(texthashset_table_t *table, int64 nelements)
+{
+	int64	capacity;
+
+	/* The last insert happens with nelements-1 elements in the table */
+	if (nelements == 0 || nelements - 1 < table->capacity * table->load_factor)
+		return;
+
+	capacity = (int64) (nelements / table->load_factor) + 1;
+
+	texthashset_table_resize(table, (int) Min(capacity, PG_INT32_MAX));
+}
+
+/*
+ * texthashset_table_place
+ *		Put an element (known not to be in the table yet) into a slot.
+ */
+static void
+texthashset_table_place(texthashset_table_t *table, int32 index)
+{
+	uint32	hash = table->hashes[index];
+	uint32	mask = table->capacity / HASHSET_GROUP_SIZE - 1;
+	uint32	group = HASHSET_HASH_GROUP(hash) & mask;
+
+	for (uint32 probe = 1; ; probe++)
+	{
+		uint8  *gctrl = table->ctrl + group * HASHSET_GROUP_SIZE;
+		uint32	match = hashset_group_match_empty(gctrl);
+
+		if (match != 0)
+		{
+			int		i = pg_rightmost_one_pos32(match);
+
+			gctrl[i] = HASHSET_HASH_TAG(hash);
+			table->slots[group * HASHSET_GROUP_SIZE + i] = index;
+			return;
+		}
+
+		group = (group + probe) & mask;
+	}
+}
+
+/* Does the element index match the string (with the given hash)? */
+static inline bool
+texthashset_table_match(texthashset_table_t *table, int32 index, uint32 hash,
+						const char *str, int len)
+{
+	return (table->hashes[index] == hash &&
+			table->offsets[index + 1] - table->offsets[index] == (uint32) len &&
+			memcmp(table->arena + table->offsets[index], str, len) == 0);
+}
+
+/*
+ * texthashset_table_find
+ *		Find the element, returns its index (or -1 if not found).
+ */
+static int32
+texthashset_table_find(texthashset_table_t *table, uint32 hash,
+					   const char *str, int len)
+{
+	uint32	group;
+	uint32	mask;
+	uint8	tag;
+
+	if (table->nelements == 0)
+		return -1;
+
+	tag = HASHSET_HASH_TAG(hash);
+	mask = table->capacity / HASHSET_GROUP_SIZE - 1;
+	group = HASHSET_HASH_GROUP(hash) & mask;
+
+	for (uint32 probe = 1; probe <= mask + 1; probe++)
+	{
+		uint8  *gctrl = table->ctrl + group * HASHSET_GROUP_SIZE;
+		int32  *gslots = table->slots + group * HASHSET_GROUP_SIZE;
+		uint32	match = hashset_group_match(gctrl, tag);
+
+		while (match != 0)
+		{
+			int		i = pg_rightmost_one_pos32(match);
+
+			if (texthashset_table_match(table, gslots[i], hash, str, len))
+				return gslots[i];
+
+			match &= (match - 1);
+		}
+
+		/* Found an empty slot, the element is not there */
+		if (hashset_group_match_empty(gctrl) != 0)
+			return -1;
+
+		group = (group + probe) & mask;
+	}
+
+	return -1;
+}
+
+/*
+ * texthashset_table_insert
+ *		Add the element (with a precomputed hash) to the table, unless it's
+ *		already there. Returns true if the element was added.
+ */
+static bool
+texthashset_table_insert(texthashset_table_t *table, uint32 hash,
+						 const char *str, int len)
+{
+	uint32	group;
+	uint32	mask;
+	uint8	tag;
+	int32	index;
+
+	/* Resize early, so that there's always at least one empty slot */
+	if (unlikely(table->capacity == 0 ||
+				 table->nelements >= table->capacity * table->load_factor))
+		texthashset_table_resize(table,
+								 Max((int) (table->capacity * table->growth_factor),
+									 table->capacity + 1));
+
+	tag = HASHSET_HASH_TAG(hash);
+	mask = table->capacity / HASHSET_GROUP_SIZE - 1;
+	group = HASHSET_HASH_GROUP(hash) & mask;
+
+	for (uint32 probe = 1; ; probe++)
+	{
+		uint8  *gctrl = table->ctrl + group * HASHSET_GROUP_SIZE;
+		int32  *gslots = table->slots + group * HASHSET_GROUP_SIZE;
+		uint32	match = hashset_group_match(gctrl, tag);
+
+		while (match != 0)
+		{
+			int		i = pg_rightmost_one_pos32(match);
+
+			if (texthashset_table_match(table, gslots[i], hash, str, len))
+				return false;
+
+			match &= (match - 1);
+		}
+
+		/* Found an empty slot, so the element is not in the set - add it */
+		match = hashset_group_match_empty(gctrl);
+		if (match != 0)
+		{
+			int		i = pg_rightmost_one_pos32(match);
+
+			index = table->nelements;
+
+			texthashset_table_grow(table, (int64) index + 1,
+								   (Size) table->offsets[index] + len);
+
+			memcpy(table->arena + table->offsets[index], str, len);
+			table->offsets[index + 1] = table->offsets[index] + len;
+			table->hashes[index] = hash;
+			table->nelements++;
+
+			gctrl[i] = tag;
+			gslots[i] = index;
+
+			return true;
+		}
+
+		group = (group + probe) & mask;
+	}
+}
+
+/*
+ * texthashset_table_add_set
+ *		Add all elements of a flat set to the table (not the NULL element),
+ *		using the hashes stored in the set.
+ */
+static void
+texthashset_table_add_set(texthashset_table_t *table, texthashset_t *set)
+{
+	uint32	   *hashes = TEXTHASHSET_HASHES(set);
+	uint32	   *offsets = TEXTHASHSET_OFFSETS(set);
+	char	   *arena = TEXTHASHSET_ARENA(set);
+
+	texthashset_table_reserve(table, (int64) table->nelements + set->nelements);
+
+	for (int32 i = 0; i < set->nelements; i++)
+		texthashset_table_insert(table, hashes[i], arena + offsets[i],
+								 offsets[i + 1] - offsets[i]);
+}
+
+/*
+ * texthashset_table_from_flat
+ *		Build the table for a flat set, in the current memory context.
+ *
+ * The elements of a flat set are distinct, so the arrays are simply copied
+ * and only the slots get filled.
+ */
+static texthashset_table_t *
+texthashset_table_from_flat(texthashset_t *set)
+{
+	texthashset_table_t *table;
+	int64				capacity;
+
+	table = texthashset_table_create(0, set->load_factor, set->growth_factor);
+
+	texthashset_table_grow(table, set->nelements,
+						   TEXTHASHSET_OFFSETS(set)[set->nelements]);
+
+	memcpy(table->hashes, TEXTHASHSET_HASHES(set),
+		   set->nelements * sizeof(uint32));
+	memcpy(table->offsets, TEXTHASHSET_OFFSETS(set),
+		   (set->nelements + 1) * sizeof(uint32));
+	memcpy(table->arena, TEXTHASHSET_ARENA(set),
+		   TEXTHASHSET_OFFSETS(set)[set->nelements]);
+
+	table->nelements = set->nelements;
+	table->null_element = set->null_element;
+
+	capacity = set->capacity;
+	if (set->nelements > 0)
+		capacity = Max(capacity, (int64) (set->nelements / set->load_factor) + 1);
+
+	texthashset_table_resize(table, (int) Min(capacity, PG_INT32_MAX));
+
+	return table;
+}
+
+/*
+ * texthashset_table_flatten
+ *		Build the flat representation of the table.
+ */
+static texthashset_t *
+texthashset_table_flatten(texthashset_table_t *table)
+{
+	texthashset_t  *set;
+	Size			arena_len = table->offsets[table->nelements];
+	Size			len;
+
+	len = offsetof(texthashset_t, data);
+	len += table->nelements * sizeof(uint32);			/* hashes */
+	len += (table->nelements + 1) * sizeof(uint32);	/* offsets */
+	len += arena_len;
+
+	if (len > MaxAllocSize)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("texthashset is too large")));
+
+	set = (texthashset_t *) palloc(len);
+	SET_VARSIZE(set, len);
+
+	set->flags = 0;
+	set->capacity = table->capacity;
+	set->nelements = table->nelements;
+	set->load_factor = table->load_factor;
+	set->growth_factor = table->growth_factor;
+	set->null_element = table->null_element;
+
+	memcpy(TEXTHASHSET_HASHES(set), table->hashes,
+		   table->nelements * sizeof(uint32));
+	memcpy(TEXTHASHSET_OFFSETS(set), table->offsets,
+		   (table->nelements + 1) * sizeof(uint32));
+	memcpy(TEXTHASHSET_ARENA(set), table->arena, arena_len);
+
+	return set;
+}
+
+/*
+ * texthashset_flat_contains
+ *		Check if the flat set contains the element, by scanning the hashes.
+ */
+static bool
+texthashset_flat_contains(texthashset_t *set, uint32 hash, const char *str,
+						  int len)
+{
+	uint32	   *hashes = TEXTHASHSET_HASHES(set);
+	uint32	   *offsets = TEXTHASHSET_OFFSETS(set);
+	char	   *arena = TEXTHASHSET_ARENA(set);
+
+	for (int32 i = 0; i < set->nelements; i++)
+	{
+		if (hashes[i] == hash &&
+			offsets[i + 1] - offsets[i] == (uint32) len &&
+			memcmp(arena + offsets[i], str, len) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * texthashset_flat_append
+ *		Build a copy of the flat set with one more element (which must not
+ *		be in the set yet).
+ *
+ * This is what hashset_add() does, as copying the arrays is much cheaper
+ * than building the hash table. The capacity grows the same way as if the
+ * element was added to the table.
+ */
+static texthashset_t *
+texthashset_flat_append(texthashset_t *set, uint32 hash, const char *str,
+						int len)
+{
+	texthashset_t  *result;
+	Size			arena_len = TEXTHASHSET_OFFSETS(set)[set->nelements];
+	Size			size;
+	int32			n = set->nelements;
+
+	size = offsetof(texthashset_t, data);
+	size += (n + 1) * sizeof(uint32);	/* hashes */
+	size += (n + 2) * sizeof(uint32);	/* offsets */
+	size += arena_len + len;
+
+	if (size > MaxAllocSize)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("texthashset is too large")));
+
+	result = (texthashset_t *) palloc(size);
+	SET_VARSIZE(result, size);
+
+	result->flags = 0;
+	result->capacity = set->capacity;
+	result->nelements = n + 1;
+	result->load_factor = set->load_factor;
+	result->growth_factor = set->growth_factor;
+	result->null_element = set->null_element;
+
+	if (set->capacity == 0 || n >= set->capacity * set->load_factor)
+		result->capacity = texthashset_round_capacity(
+			Max((int) (set->capacity * set->growth_factor), set->capacity + 1));
+
+	memcpy(TEXTHASHSET_HASHES(result), TEXTHASHSET_HASHES(set), n * sizeof(uint32));
+	TEXTHASHSET_HASHES(result)[n] = hash;
+
+	memcpy(TEXTHASHSET_OFFSETS(result), TEXTHASHSET_OFFSETS(set), (n + 1) * sizeof(uint32));
+	TEXTHASHSET_OFFSETS(result)[n + 1] = arena_len + len;
+
+	memcpy(TEXTHASHSET_ARENA(result), TEXTHASHSET_ARENA(set), arena_len);
+	memcpy(TEXTHASHSET_ARENA(result) + arena_len, str, len);
+
+	return result;
+}
+
+/*
+ * texthashset_table_from_array
+ *		Build a table from the elements of a text array (NULLs set the NULL
+ *		element).
+ */
+static texthashset_table_t *
+texthashset_table_from_array(ArrayType *array)
+{
+	texthashset_table_t *table;
+	Datum			   *elems;
+	bool			   *nulls;
+	int					nelems;
+
+	if (ARR_ELEMTYPE(array) != TEXTOID)
+		elog(ERROR, "expected text[] array");
+
+	deconstruct_array(array, TEXTOID, -1, false, TYPALIGN_INT,
+					  &elems, &nulls, &nelems);
+
+	table = texthashset_table_create(0, DEFAULT_LOAD_FACTOR,
+									 DEFAULT_GROWTH_FACTOR);
+	texthashset_table_reserve(table, nelems);
+
+	for (int i = 0; i < nelems; i++)
+	{
+		text   *t;
+
+		if (nulls[i])
+		{
+			table->null_element = true;
+			continue;
+		}
+
+		t = DatumGetTextPP(elems[i]);
+
+		texthashset_table_insert(table,
+								 texthashset_hash_bytes(VARDATA_ANY(t), VARSIZE_ANY_EXHDR(t)),
+								 VARDATA_ANY(t), VARSIZE_ANY_EXHDR(t));
+	}
+
+	return table;
+}
+
+/* qsort_arg comparator, ordering elements of a flat set bytewise */
+static int
+texthashset_element_cmp(const void *a, const void *b, void *arg)
+{
+	texthashset_t  *set = (texthashset_t *) arg;
+	uint32		   *offsets = TEXTHASHSET_OFFSETS(set);
+	char		   *arena = TEXTHASHSET_ARENA(set);
+	int32			ia = *(const int32 *) a;
+	int32			ib = *(const int32 *) b;
+	uint32			lena = offsets[ia + 1] - offsets[ia];
+	uint32			lenb = offsets[ib + 1] - offsets[ib];
+	int				cmp;
+
+	cmp = memcmp(arena + offsets[ia], arena + offsets[ib], Min(lena, lenb));
+	if (cmp != 0)
+		return cmp;
+
+	return (lena > lenb) - (lena < lenb);
+}
+
+/*
+ * texthashset_to_text_array
+ *		Build a text[] array with the elements (the NULL element last),
+ *		either in the order of the set or sorted bytewise.
+ */
+static Datum
+texthashset_to_text_array(texthashset_t *set, bool sorted)
+{
+	uint32	   *offsets = TEXTHASHSET_OFFSETS(set);
+	char	   *arena = TEXTHASHSET_ARENA(set);
+	int32	   *order;
+	Datum	   *elems;
+	bool	   *nulls;
+	int			nelems = set->nelements + (set->null_element ? 1 : 0);
+	int			dims[1];
+	int			lbs[1];
+
+	if (nelems == 0)
+		return PointerGetDatum(construct_empty_array(TEXTOID));
+
+	order = (int32 *) palloc(Max(set->nelements, 1) * sizeof(int32));
+	for (int32 i = 0; i < set->nelements; i++)
+		order[i] = i;
+
+	if (sorted)
+		qsort_arg(order, set->nelements, sizeof(int32),
+				  texthashset_element_cmp, set);
+
+	elems = (Datum *) palloc(nelems * sizeof(Datum));
+	nulls = (bool *) palloc0(nelems * sizeof(bool));
+
+	for (int32 i = 0; i < set->nelements; i++)
+		elems[i] = PointerGetDatum(cstring_to_text_with_len(arena + offsets[order[i]],
+															offsets[order[i] + 1] - offsets[order[i]]));
+
+	if (set->null_element)
+	{
+		elems[nelems - 1] = (Datum) 0;
+		nulls[nelems - 1] = true;
+	}
+
+	dims[0] = nelems;
+	lbs[0] = 1;
+
+	return PointerGetDatum(construct_md_array(elems, nulls, 1, dims, lbs,
+											  TEXTOID, -1, false, TYPALIGN_INT));
+}
+
+/*
+ * texthashset_canonical_hash
+ *		Calculate a 64-bit hash of the hashset contents.
+ *
+ * The same construction as int4hashset_canonical_hash, summing the mixed
+ * element hashes (cached in the set).
+ */
+static uint64
+texthashset_canonical_hash(texthashset_t *set, uint64 seed)
+{
+	uint32	   *hashes = TEXTHASHSET_HASHES(set);
+	uint64		sum = 0;
+	uint32		extra;
+	uint32		lo;
+	uint32		hi;
+
+	for (int32 i = 0; i < set->nelements; i++)
+		sum += hashset_mix64((uint64) hashes[i] + seed);
+
+	extra = ((uint32) set->nelements << 1) | (set->null_element ? 1 : 0);
+
+	lo = murmurhash32((uint32) sum ^ murmurhash32(extra));
+	hi = (uint32) (hashset_mix64(sum ^ ((uint64) extra << 32)) >> 32);
+
+	return ((uint64) hi << 32) | lo;
+}
+
+/*
+ * texthashset_equal
+ *		Check if the sets have the same elements (and the NULL element).
+ */
+static bool
+texthashset_equal(texthashset_t *a, texthashset_t *b)
+{
+	texthashset_table_t *table;
+	uint32			   *hashes = TEXTHASHSET_HASHES(a);
+	uint32			   *offsets = TEXTHASHSET_OFFSETS(a);
+	char			   *arena = TEXTHASHSET_ARENA(a);
+
+	if (a->nelements != b->nelements || a->null_element != b->null_element)
+		return false;
+
+	if (a->nelements == 0)
+		return true;
+
+	table = texthashset_table_from_flat(b);
+
+	for (int32 i = 0; i < a->nelements; i++)
+	{
+		if (texthashset_table_find(table, hashes[i], arena + offsets[i],
+								   offsets[i + 1] - offsets[i]) < 0)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * The text format is the same as for text[] arrays (with the same quoting
+ * rules), so the parsing and printing is done by array_in / array_out. The
+ * output lists the elements sorted bytewise, with NULL last.
+ */
+Datum
+texthashset_in(PG_FUNCTION_ARGS)
+{
+	char	   *str = PG_GETARG_CSTRING(0);
+	Datum		array;
+
+	while (hashset_isspace(*str)) str++;
+
+	if (*str != '{')
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+				 errmsg("invalid input syntax for hashset: \"%s\"", str),
+				 errdetail("Hashset representation must start with \"{\".")));
+
+	array = OidInputFunctionCall(F_ARRAY_IN, str, TEXTOID, -1);
+
+	PG_RETURN_POINTER(texthashset_table_flatten(
+		texthashset_table_from_array(DatumGetArrayTypeP(array))));
+}
+
+Datum
+texthashset_out(PG_FUNCTION_ARGS)
+{
+	texthashset_t  *set = PG_GETARG_TEXTHASHSET(0);
+
+	PG_RETURN_CSTRING(OidOutputFunctionCall(F_ARRAY_OUT,
+											texthashset_to_text_array(set, true)));
+}
+
+/*
+ * The binary format is the parameters followed by the elements, each one
+ * as a length and the bytes (converted to the client encoding).
+ */
+Datum
+texthashset_send(PG_FUNCTION_ARGS)
+{
+	texthashset_t  *set = PG_GETARG_TEXTHASHSET(0);
+	uint32		   *offsets = TEXTHASHSET_OFFSETS(set);
+	char		   *arena = TEXTHASHSET_ARENA(set);
+	StringInfoData	buf;
+
+	pq_begintypsend(&buf);
+
+	pq_sendint8(&buf, 1);		/* version */
+	pq_sendint32(&buf, set->capacity);
+	pq_sendint32(&buf, set->nelements);
+	pq_sendfloat4(&buf, set->load_factor);
+	pq_sendfloat4(&buf, set->growth_factor);
+	pq_sendbyte(&buf, set->null_element ? 1 : 0);
+
+	for (int32 i = 0; i < set->nelements; i++)
+	{
+		int		len = offsets[i + 1] - offsets[i];
+		char   *p = pg_server_to_client(arena + offsets[i], len);
+
+		if (p != arena + offsets[i])
+			len = strlen(p);
+
+		pq_sendint32(&buf, len);
+		pq_sendbytes(&buf, p, len);
+	}
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+Datum
+texthashset_recv(PG_FUNCTION_ARGS)
+{
+	StringInfo			buf = (StringInfo) PG_GETARG_POINTER(0);
+	int					version;
+	int32				capacity;
+	int32				nelements;
+	float4				load_factor;
+	float4				growth_factor;
+	texthashset_table_t *table;
+
+	version = pq_getmsgint(buf, 1);
+	if (version != 1)
+		elog(ERROR, "unsupported hashset version number %d", version);
+
+	capacity = pq_getmsgint(buf, 4);
+	nelements = pq_getmsgint(buf, 4);
+	load_factor = pq_getmsgfloat4(buf);
+	growth_factor = pq_getmsgfloat4(buf);
+
+	if (capacity < 0 || nelements < 0 ||
+		nelements > (buf->len - buf->cursor) / sizeof(int32))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid hashset size")));
+
+	if (!(load_factor > 0.0 && load_factor < 1.0) ||
+		!(growth_factor > 1.0))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid hashset parameters")));
+
+	table = texthashset_table_create(capacity, load_factor, growth_factor);
+	table->null_element = (pq_getmsgbyte(buf) == 1);
+
+	texthashset_table_reserve(table, nelements);
+
+	/* duplicates (from a broken sender) are simply ignored */
+	for (int32 i = 0; i < nelements; i++)
+	{
+		int		len = pq_getmsgint(buf, 4);
+		int		nbytes;
+		char   *str;
+
+		if (len < 0 || len > buf->len - buf->cursor)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+					 errmsg("invalid hashset element length")));
+
+		str = pq_getmsgtext(buf, len, &nbytes);
+
+		texthashset_table_insert(table, texthashset_hash_bytes(str, nbytes),
+								 str, nbytes);
+		pfree(str);
+	}
+
+	pq_getmsgend(buf);
+
+	PG_RETURN_POINTER(texthashset_table_flatten(table));
+}
+
+Datum
+texthashset_init(PG_FUNCTION_ARGS)
+{
+	int32	capacity = PG_GETARG_INT32(0);
+	float4	load_factor = PG_GETARG_FLOAT4(1);
+	float4	growth_factor = PG_GETARG_FLOAT4(2);
+
+	hashset_check_parameters(capacity, load_factor, growth_factor,
+							 DEFAULT_HASHFN_ID);
+
+	PG_RETURN_POINTER(texthashset_table_flatten(
+		texthashset_table_create(capacity, load_factor, growth_factor)));
+}
+
+/*
+ * Add an element (or the NULL element) to the set, a NULL set is treated
+ * as an empty one.
+ */
+Datum
+texthashset_add(PG_FUNCTION_ARGS)
+{
+	texthashset_t  *set;
+	text		   *value;
+	uint32			hash;
+
+	if (PG_ARGISNULL(0))
+		set = texthashset_table_flatten(
+			texthashset_table_create(DEFAULT_INITIAL_CAPACITY, DEFAULT_LOAD_FACTOR,
+									 DEFAULT_GROWTH_FACTOR));
+	else
+		set = PG_GETARG_TEXTHASHSET(0);
+
+	if (PG_ARGISNULL(1))
+	{
+		if (!set->null_element)
+		{
+			set = (texthashset_t *) PG_DETOAST_DATUM_COPY(PointerGetDatum(set));
+			set->null_element = true;
+		}
+
+		PG_RETURN_POINTER(set);
+	}
+
+	texthashset_check_collation(PG_GET_COLLATION());
+
+	value = PG_GETARG_TEXT_PP(1);
+	hash = texthashset_hash_bytes(VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value));
+
+	if (texthashset_flat_contains(set, hash, VARDATA_ANY(value),
+								  VARSIZE_ANY_EXHDR(value)))
+		PG_RETURN_POINTER(set);
+
+	PG_RETURN_POINTER(texthashset_flat_append(set, hash, VARDATA_ANY(value),
+											  VARSIZE_ANY_EXHDR(value)));
+}
+
+/*
+ * Same NULL handling as hashset_contains(int4hashset, int). For a constant
+ * set, the hash table is built once and kept in fn_extra, otherwise we
+ * scan the hashes of the flat set.
+ */
+Datum
+texthashset_contains(PG_FUNCTION_ARGS)
+{
+	texthashset_t  *set;
+	text		   *value;
+	uint32			hash;
+	bool			result;
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	set = PG_GETARG_TEXTHASHSET(0);
+
+	if (set->nelements == 0 && !set->null_element)
+		PG_RETURN_BOOL(false);
+
+	if (PG_ARGISNULL(1))
+		PG_RETURN_NULL();
+
+	texthashset_check_collation(PG_GET_COLLATION());
+
+	value = PG_GETARG_TEXT_PP(1);
+	hash = texthashset_hash_bytes(VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value));
+
+	if (hashset_arg_is_const(fcinfo->flinfo, 0))
+	{
+		texthashset_arg_cache_t *cache;
+
+		cache = (texthashset_arg_cache_t *) fcinfo->flinfo->fn_extra;
+		if (cache == NULL)
+		{
+			cache = MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt,
+										   sizeof(texthashset_arg_cache_t));
+			fcinfo->flinfo->fn_extra = cache;
+		}
+
+		if (cache->source != DatumGetPointer(PG_GETARG_DATUM(0)))
+		{
+			MemoryContext	oldcontext;
+
+			/* the old table is simply leaked, the value of a Const doesn't change */
+			oldcontext = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+			cache->table = texthashset_table_from_flat(set);
+			MemoryContextSwitchTo(oldcontext);
+
+			cache->source = DatumGetPointer(PG_GETARG_DATUM(0));
+		}
+
+		result = (texthashset_table_find(cache->table, hash, VARDATA_ANY(value),
+										 VARSIZE_ANY_EXHDR(value)) >= 0);
+	}
+	else
+		result = texthashset_flat_contains(set, hash, VARDATA_ANY(value),
+										   VARSIZE_ANY_EXHDR(value));
+
+	if (!result && set->null_element)
+		PG_RETURN_NULL();
+
+	PG_RETURN_BOOL(result);
+}
+
+/*
+ * The union builds the table for the larger set (when that makes no
+ * difference for the result) and adds the smaller one to it.
+ */
+Datum
+texthashset_union(PG_FUNCTION_ARGS)
+{
+	texthashset_t		*seta = PG_GETARG_TEXTHASHSET(0);
+	texthashset_t		*setb = PG_GETARG_TEXTHASHSET(1);
+	texthashset_table_t *table;
+
+	if (seta->nelements < setb->nelements &&
+		seta->load_factor == setb->load_factor &&
+		seta->growth_factor == setb->growth_factor)
+	{
+		texthashset_t *tmp = seta;
+
+		seta = setb;
+		setb = tmp;
+	}
+
+	table = texthashset_table_from_flat(seta);
+	texthashset_table_add_set(table, setb);
+
+	table->null_element = (seta->null_element || setb->null_element);
+
+	PG_RETURN_POINTER(texthashset_table_flatten(table));
+}
+
+Datum
+texthashset_cardinality(PG_FUNCTION_ARGS)
+{
+	texthashset_t  *set = PG_GETARG_TEXTHASHSET(0);
+
+	PG_RETURN_INT64(set->nelements + (set->null_element ? 1 : 0));
+}
+
+Datum
+texthashset_capacity(PG_FUNCTION_ARGS)
+{
+	texthashset_t  *set = PG_GETARG_TEXTHASHSET(0);
+
+	PG_RETURN_INT64(set->capacity);
+}
+
+Datum
+texthashset_to_array(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DATUM(texthashset_to_text_array(PG_GETARG_TEXTHASHSET(0), false));
+}
+
+Datum
+texthashset_to_sorted_array(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DATUM(texthashset_to_text_array(PG_GETARG_TEXTHASHSET(0), true));
+}
+
+Datum
+texthashset_elements(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	texthashset_t  *set;
+	int32			i;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext	oldcontext;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		/* the detoasted set has to survive across calls */
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+		funcctx->user_fctx = PG_GETARG_TEXTHASHSET(0);
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	set = (texthashset_t *) funcctx->user_fctx;
+	i = (int32) funcctx->call_cntr;
+
+	if (i < set->nelements)
+	{
+		uint32 *offsets = TEXTHASHSET_OFFSETS(set);
+
+		SRF_RETURN_NEXT(funcctx, PointerGetDatum(
+			cstring_to_text_with_len(TEXTHASHSET_ARENA(set) + offsets[i],
+									 offsets[i + 1] - offsets[i])));
+	}
+
+	if (set->null_element && i == set->nelements)
+		SRF_RETURN_NEXT_NULL(funcctx);
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+Datum
+texthashset_from_array(PG_FUNCTION_ARGS)
+{
+	ArrayType  *array = PG_GETARG_ARRAYTYPE_P(0);
+
+	texthashset_check_collation(PG_GET_COLLATION());
+
+	PG_RETURN_POINTER(texthashset_table_flatten(
+		texthashset_table_from_array(array)));
+}
+
+Datum
+texthashset_eq(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(texthashset_equal(PG_GETARG_TEXTHASHSET(0),
+									 PG_GETARG_TEXTHASHSET(1)));
+}
+
+Datum
+texthashset_ne(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(!texthashset_equal(PG_GETARG_TEXTHASHSET(0),
+									  PG_GETARG_TEXTHASHSET(1)));
+}
+
+Datum
+texthashset_hash(PG_FUNCTION_ARGS)
+{
+	texthashset_t  *set = PG_GETARG_TEXTHASHSET(0);
+
+	PG_RETURN_INT32((int32) texthashset_canonical_hash(set, 0));
+}
+
+Datum
+texthashset_hash_extended(PG_FUNCTION_ARGS)
+{
+	texthashset_t  *set = PG_GETARG_TEXTHASHSET(0);
+
+	PG_RETURN_INT64((int64) texthashset_canonical_hash(set, PG_GETARG_INT64(1)));
+}
+
+/*
+ * Aggregates
+ *
+ * The state is the hash table, with all its arrays in the aggregate
+ * context. NULL values, and NULL elements of the aggregated sets, are
+ * skipped.
+ */
+Datum
+texthashset_agg_add(PG_FUNCTION_ARGS)
+{
+	MemoryContext		aggcontext;
+	MemoryContext		oldcontext;
+	texthashset_table_t *state;
+	text			   *value;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_agg_add called in non-aggregate context");
+
+	if (PG_ARGISNULL(1))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+	}
+
+	texthashset_check_collation(PG_GET_COLLATION());
+
+	value = PG_GETARG_TEXT_PP(1);
+
+	/* a single group of slots, the first resize may use the planner estimate */
+	if (PG_ARGISNULL(0))
+	{
+		oldcontext = MemoryContextSwitchTo(aggcontext);
+		state = texthashset_table_create(HASHSET_GROUP_SIZE,
+										 DEFAULT_LOAD_FACTOR,
+										 DEFAULT_GROWTH_FACTOR);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	else
+		state = (texthashset_table_t *) PG_GETARG_POINTER(0);
+
+	if (unlikely(state->capacity == HASHSET_GROUP_SIZE))
+		texthashset_table_reserve(state,
+								  hashset_agg_resize_estimate(fcinfo, state->capacity,
+															  state->nelements,
+															  state->load_factor,
+															  state->growth_factor));
+
+	texthashset_table_insert(state,
+							 texthashset_hash_bytes(VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value)),
+							 VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value));
+
+	PG_RETURN_POINTER(state);
+}
+
+Datum
+texthashset_agg_add_set(PG_FUNCTION_ARGS)
+{
+	MemoryContext		aggcontext;
+	MemoryContext		oldcontext;
+	texthashset_table_t *state;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_agg_add_set called in non-aggregate context");
+
+	if (PG_ARGISNULL(1))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		oldcontext = MemoryContextSwitchTo(aggcontext);
+		state = texthashset_table_create(DEFAULT_INITIAL_CAPACITY,
+										 DEFAULT_LOAD_FACTOR,
+										 DEFAULT_GROWTH_FACTOR);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	else
+		state = (texthashset_table_t *) PG_GETARG_POINTER(0);
+
+	texthashset_table_add_set(state, PG_GETARG_TEXTHASHSET(1));
+
+	PG_RETURN_POINTER(state);
+}
+
+Datum
+texthashset_agg_final(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_POINTER(texthashset_table_flatten(
+		(texthashset_table_t *) PG_GETARG_POINTER(0)));
+}
+
+/*
+ * The partial states are merged using the cached hashes, so the strings
+ * are not hashed again.
+ */
+Datum
+texthashset_agg_combine(PG_FUNCTION_ARGS)
+{
+	MemoryContext		aggcontext;
+	MemoryContext		oldcontext;
+	texthashset_table_t *src;
+	texthashset_table_t *dst;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_agg_combine called in non-aggregate context");
+
+	if (PG_ARGISNULL(1))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+	}
+
+	src = (texthashset_table_t *) PG_GETARG_POINTER(1);
+
+	if (PG_ARGISNULL(0))
+	{
+		oldcontext = MemoryContextSwitchTo(aggcontext);
+		dst = texthashset_table_create(src->capacity, src->load_factor,
+									   src->growth_factor);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	else
+		dst = (texthashset_table_t *) PG_GETARG_POINTER(0);
+
+	texthashset_table_reserve(dst, (int64) dst->nelements + src->nelements);
+
+	for (int32 i = 0; i < src->nelements; i++)
+		texthashset_table_insert(dst, src->hashes[i],
+								 src->arena + src->offsets[i],
+								 src->offsets[i + 1] - src->offsets[i]);
+
+	dst->null_element |= src->null_element;
+
+	PG_RETURN_POINTER(dst);
+}
+
+/* The serialized state is simply the flat set */
+Datum
+texthashset_agg_serial(PG_FUNCTION_ARGS)
+{
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "hashset_agg_serial called in non-aggregate context");
+
+	PG_RETURN_BYTEA_P((bytea *) texthashset_table_flatten(
+		(texthashset_table_t *) PG_GETARG_POINTER(0)));
+}
+
+Datum
+texthashset_agg_deserial(PG_FUNCTION_ARGS)
+{
+	texthashset_t  *set;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "hashset_agg_deserial called in non-aggregate context");
+
+	/* make sure the data is properly aligned */
+	set = (texthashset_t *) PG_DETOAST_DATUM_COPY(PG_GETARG_DATUM(0));
+
+	PG_RETURN_POINTER(texthashset_table_from_flat(set));
+}
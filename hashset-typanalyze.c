@@ -0,0 +1,354 @@
+/*
+ * hashset-typanalyze.c
+ *
+ * ANALYZE support for hashset columns, collecting statistics about the
+ * elements of the sets, not just about the whole values. Modeled on
+ * array_typanalyze: the most common elements are found by the Lossy
+ * Counting algorithm, and the numbers of elements are summarized by a
+ * histogram. The elements are read directly from the compact data (or the
+ * hash table), without building a hash table. The code is shared by all
+ * the hashset types, the statistics are values of the element type.
+ *
+ * The statistics use the same slot kinds as arrays (so pg_stats shows them
+ * as most_common_elems, most_common_elem_freqs and elem_count_histogram):
+ *
+ * - STATISTIC_KIND_MCELEM: the most common elements (sorted by value) and
+ *   their frequencies, followed by the minimum and maximum frequency and
+ *   the frequency of the NULL element.
+ *
+ * - STATISTIC_KIND_DECHIST: histogram of the numbers of elements of the
+ *   sets (including the NULL element), followed by the average number.
+ */
+
+#include "hashset.h"
+
+#include "catalog/pg_statistic.h"
+#include "commands/vacuum.h"
+#include "utils/hsearch.h"
+
+#if PG_VERSION_NUM >= 170000
+#define HASHSET_STATTARGET(stats)	((stats)->attstattarget)
+#else
+#define HASHSET_STATTARGET(stats)	((stats)->attr->attstattarget)
+#endif
+
+/* State saved from std_typanalyze, for the whole-value statistics */
+typedef struct hashset_analyze_t
+{
+	AnalyzeAttrComputeStatsFunc	std_compute_stats;
+	void					   *std_extra_data;
+	Oid							elemtype;	/* element type of the hashset */
+} hashset_analyze_t;
+
+/* An element tracked by the Lossy Counting algorithm */
+typedef struct hashset_track_t
+{
+	int64	value;			/* Hash key (must be first) */
+	int		frequency;		/* Number of sets containing the element */
+	int		delta;			/* Maximum error of the frequency */
+} hashset_track_t;
+
+static void compute_hashset_stats(VacAttrStats *stats, AnalyzeAttrFetchFunc fetchfunc, int samplerows, double totalrows);
+static void hashset_prune_elements(HTAB *elements, int b_current);
+static int hashset_track_cmp_frequency(const void *a, const void *b);
+static int hashset_track_cmp_value(const void *a, const void *b);
+static int hashset_count_cmp(const void *a, const void *b);
+
+/*
+ * hashset_typanalyze
+ *		Set up the computation of the element statistics.
+ *
+ * Called by the typanalyze functions of the hashset types (e.g.
+ * int4hashset_typanalyze), with the element type of the set. The
+ * whole-value statistics are still computed by the standard code, the
+ * element statistics go into the slots it leaves unused.
+ */
+Datum
+hashset_typanalyze(FunctionCallInfo fcinfo, Oid elemtype)
+{
+	VacAttrStats	   *stats = (VacAttrStats *) PG_GETARG_POINTER(0);
+	hashset_analyze_t  *extra_data;
+
+	if (!std_typanalyze(stats))
+		PG_RETURN_BOOL(false);
+
+	extra_data = (hashset_analyze_t *) palloc(sizeof(hashset_analyze_t));
+	extra_data->std_compute_stats = stats->compute_stats;
+	extra_data->std_extra_data = stats->extra_data;
+	extra_data->elemtype = elemtype;
+
+	stats->compute_stats = compute_hashset_stats;
+	stats->extra_data = extra_data;
+
+	PG_RETURN_BOOL(true);
+}
+
+/*
+ * compute_hashset_stats
+ *		Compute the whole-value and the element statistics.
+ *
+ * The Lossy Counting works the same way as in array_typanalyze: the sample
+ * is split into buckets of bucket_width elements, and at the end of each
+ * bucket we forget elements that can't be frequent enough to matter. Unlike
+ * arrays, the elements of a set are distinct, so each element is counted
+ * at most once per set.
+ */
+static void
+compute_hashset_stats(VacAttrStats *stats, AnalyzeAttrFetchFunc fetchfunc,
+					  int samplerows, double totalrows)
+{
+	hashset_analyze_t  *extra_data = (hashset_analyze_t *) stats->extra_data;
+	int					num_mcelem;
+	int					num_hist;
+	int					bucket_width;
+	int					b_current = 1;
+	int64				element_no = 0;
+	int					nonnull_cnt = 0;
+	int					null_element_cnt = 0;
+	double				total_count = 0;
+	int				   *counts;
+	HASHCTL				ctl;
+	HTAB			   *elements;
+	int					slot_idx;
+	Oid					eq_opr = hashset_element_eq_operator(extra_data->elemtype);
+
+	/* Compute the whole-value statistics first, using the standard code */
+	stats->extra_data = extra_data->std_extra_data;
+	extra_data->std_compute_stats(stats, fetchfunc, samplerows, totalrows);
+	stats->extra_data = extra_data;
+
+	/* The same sizing as for arrays (see array_typanalyze) */
+	num_mcelem = HASHSET_STATTARGET(stats) * 10;
+	num_hist = Max(HASHSET_STATTARGET(stats), 2);
+	bucket_width = num_mcelem * 1000 / 7;
+
+	ctl.keysize = sizeof(int64);
+	ctl.entrysize = sizeof(hashset_track_t);
+	ctl.hcxt = CurrentMemoryContext;
+	elements = hash_create("Analyzed hashset elements", num_mcelem, &ctl,
+						   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	counts = (int *) palloc(Max(samplerows, 1) * sizeof(int));
+
+	for (int i = 0; i < samplerows; i++)
+	{
+		Datum		value;
+		bool		isnull;
+		int64	   *values;
+		int			nelements;
+		bool		null_element;
+
+#if PG_VERSION_NUM >= 180000
+		vacuum_delay_point(true);
+#else
+		vacuum_delay_point();
+#endif
+
+		value = fetchfunc(stats, i, &isnull);
+		if (isnull)
+			continue;
+
+		values = hashset_datum_elements(value, extra_data->elemtype,
+										&nelements, &null_element);
+
+		for (int j = 0; j < nelements; j++)
+		{
+			hashset_track_t	   *item;
+			bool				found;
+
+			item = (hashset_track_t *) hash_search(elements, &values[j],
+												   HASH_ENTER, &found);
+
+			if (found)
+				item->frequency++;
+			else
+			{
+				item->frequency = 1;
+				item->delta = b_current - 1;
+			}
+
+			/* end of a bucket, forget the infrequent elements */
+			if (++element_no % bucket_width == 0)
+			{
+				hashset_prune_elements(elements, b_current);
+				b_current++;
+			}
+		}
+
+		if (null_element)
+			null_element_cnt++;
+
+		counts[nonnull_cnt] = nelements + (null_element ? 1 : 0);
+		total_count += counts[nonnull_cnt];
+		nonnull_cnt++;
+
+		pfree(values);
+	}
+
+	/* the standard code already handled the all-NULL case */
+	if (nonnull_cnt == 0)
+		return;
+
+	/* The element statistics go into the slots not used by the standard code */
+	slot_idx = 0;
+	while (slot_idx < STATISTIC_NUM_SLOTS && stats->stakind[slot_idx] != 0)
+		slot_idx++;
+
+	if (slot_idx > STATISTIC_NUM_SLOTS - 2)
+		elog(ERROR, "insufficient pg_statistic slots for hashset stats");
+
+	/* Most common elements, i.e. frequent enough to survive the pruning */
+	{
+		int					cutoff_freq = (int) (9 * element_no / bucket_width);
+		long				nentries = hash_get_num_entries(elements);
+		hashset_track_t	  **sort_table;
+		hashset_track_t	   *item;
+		HASH_SEQ_STATUS		scan;
+		int					track_len = 0;
+		int					minfreq = PG_INT32_MAX;
+		int					maxfreq = 0;
+
+		sort_table = (hashset_track_t **) palloc(Max(nentries, 1) * sizeof(hashset_track_t *));
+
+		hash_seq_init(&scan, elements);
+		while ((item = (hashset_track_t *) hash_seq_search(&scan)) != NULL)
+		{
+			if (item->frequency > cutoff_freq)
+				sort_table[track_len++] = item;
+		}
+
+		if (track_len > num_mcelem)
+		{
+			qsort(sort_table, track_len, sizeof(hashset_track_t *),
+				  hashset_track_cmp_frequency);
+			track_len = num_mcelem;
+		}
+
+		if (track_len > 0)
+		{
+			MemoryContext	oldcontext;
+			Datum		   *mcelem_values;
+			float4		   *mcelem_freqs;
+			int16			typlen;
+			bool			typbyval;
+			char			typalign;
+
+			for (int i = 0; i < track_len; i++)
+			{
+				minfreq = Min(minfreq, sort_table[i]->frequency);
+				maxfreq = Max(maxfreq, sort_table[i]->frequency);
+			}
+
+			/* sorted by value, so that the estimators can use a binary search */
+			qsort(sort_table, track_len, sizeof(hashset_track_t *),
+				  hashset_track_cmp_value);
+
+			oldcontext = MemoryContextSwitchTo(stats->anl_context);
+
+			mcelem_values = (Datum *) palloc(track_len * sizeof(Datum));
+			mcelem_freqs = (float4 *) palloc((track_len + 3) * sizeof(float4));
+
+			for (int i = 0; i < track_len; i++)
+			{
+				mcelem_values[i] = hashset_element_datum(sort_table[i]->value,
+														 extra_data->elemtype);
+				mcelem_freqs[i] = (double) sort_table[i]->frequency / nonnull_cnt;
+			}
+
+			mcelem_freqs[track_len] = (double) minfreq / nonnull_cnt;
+			mcelem_freqs[track_len + 1] = (double) maxfreq / nonnull_cnt;
+			mcelem_freqs[track_len + 2] = (double) null_element_cnt / nonnull_cnt;
+
+			MemoryContextSwitchTo(oldcontext);
+
+			get_typlenbyvalalign(extra_data->elemtype,
+								 &typlen, &typbyval, &typalign);
+
+			stats->stakind[slot_idx] = STATISTIC_KIND_MCELEM;
+			stats->staop[slot_idx] = eq_opr;
+			stats->stacoll[slot_idx] = InvalidOid;
+			stats->stanumbers[slot_idx] = mcelem_freqs;
+			stats->numnumbers[slot_idx] = track_len + 3;
+			stats->stavalues[slot_idx] = mcelem_values;
+			stats->numvalues[slot_idx] = track_len;
+			stats->statypid[slot_idx] = extra_data->elemtype;
+			stats->statyplen[slot_idx] = typlen;
+			stats->statypbyval[slot_idx] = typbyval;
+			stats->statypalign[slot_idx] = typalign;
+			slot_idx++;
+		}
+	}
+
+	/* Histogram of the numbers of elements (evenly spaced quantiles) */
+	{
+		MemoryContext	oldcontext;
+		float4		   *hist;
+
+		qsort(counts, nonnull_cnt, sizeof(int), hashset_count_cmp);
+
+		oldcontext = MemoryContextSwitchTo(stats->anl_context);
+
+		hist = (float4 *) palloc((num_hist + 1) * sizeof(float4));
+
+		for (int i = 0; i < num_hist; i++)
+			hist[i] = counts[(int64) i * (nonnull_cnt - 1) / (num_hist - 1)];
+
+		hist[num_hist] = total_count / nonnull_cnt;
+
+		MemoryContextSwitchTo(oldcontext);
+
+		stats->stakind[slot_idx] = STATISTIC_KIND_DECHIST;
+		stats->staop[slot_idx] = eq_opr;
+		stats->stacoll[slot_idx] = InvalidOid;
+		stats->stanumbers[slot_idx] = hist;
+		stats->numnumbers[slot_idx] = num_hist + 1;
+		slot_idx++;
+	}
+}
+
+/*
+ * hashset_prune_elements
+ *		Forget elements that can't be frequent (at the end of a bucket).
+ */
+static void
+hashset_prune_elements(HTAB *elements, int b_current)
+{
+	HASH_SEQ_STATUS		scan;
+	hashset_track_t	   *item;
+
+	hash_seq_init(&scan, elements);
+	while ((item = (hashset_track_t *) hash_seq_search(&scan)) != NULL)
+	{
+		if (item->frequency + item->delta <= b_current)
+		{
+			if (hash_search(elements, &item->value, HASH_REMOVE, NULL) == NULL)
+				elog(ERROR, "hash table corrupted");
+		}
+	}
+}
+
+/* qsort comparator, by frequency in descending order */
+static int
+hashset_track_cmp_frequency(const void *a, const void *b)
+{
+	const hashset_track_t *ta = *(const hashset_track_t *const *) a;
+	const hashset_track_t *tb = *(const hashset_track_t *const *) b;
+
+	return tb->frequency - ta->frequency;
+}
+
+/* qsort comparator, by element value */
+static int
+hashset_track_cmp_value(const void *a, const void *b)
+{
+	const hashset_track_t *ta = *(const hashset_track_t *const *) a;
+	const hashset_track_t *tb = *(const hashset_track_t *const *) b;
+
+	return (ta->value > tb->value) - (ta->value < tb->value);
+}
+
+static int
+hashset_count_cmp(const void *a, const void *b)
+{
+	return *(const int *) a - *(const int *) b;
+}
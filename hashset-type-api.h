@@ -0,0 +1,2061 @@
+/*
+ * hashset-type-api.h
+ *
+ * Template for the SQL functions of a hashset type, generated for each of
+ * the integer types from the core in hashset-type.h. The including file
+ * provides the module-wide includes (and PG_MODULE_MAGIC, in the case of
+ * hashset-api.c).
+ *
+ * Parameters (all of them are undefined at the end):
+ *
+ *	HASHSET_PREFIX - prefix of the type and function names (int4hashset)
+ *	HASHSET_ELEMENT_TYPE - C type of the elements (int32)
+ *	HASHSET_ELEMENT_OID - OID of the element type (INT4OID)
+ *	HASHSET_ELEMENT_NAME - name of the element type in messages ("integer")
+ *	HASHSET_ELEMENT_MIN, HASHSET_ELEMENT_MAX - range of the element type
+ *	HASHSET_GETARG_ELEMENT(n) - fetch an element argument
+ *	HASHSET_ELEMENT_GET_DATUM(value) - convert an element to a Datum
+ *	HASHSET_SEND_ELEMENT(buf, value) - send an element (binary format)
+ *	HASHSET_RECV_ELEMENT(buf) - receive an element (binary format)
+ *	HASHSET_LEGACY_FORMAT - defined if the binary format version 1 (the raw
+ *		int4hashset of release 0.0.1) is accepted by recv
+ */
+
+#define HASHSET_MAKE_NAME_(prefix, name) prefix##_##name
+#define HASHSET_MAKE_NAME(prefix, name) HASHSET_MAKE_NAME_(prefix, name)
+#define HASHSET_NAME(name) HASHSET_MAKE_NAME(HASHSET_PREFIX, name)
+
+#define HASHSET_TYPE		HASHSET_NAME(t)
+#define HASHSET_EXPANDED	HASHSET_NAME(expanded_t)
+#define HASHSET_ITERATOR	HASHSET_NAME(iterator_t)
+
+/* Same as the PG_GETARG_INT4HASHSET macros, see hashset.h */
+#define PG_GETARG_HASHSET(x)			HASHSET_NAME(datum_get)(PG_GETARG_DATUM(x))
+#define PG_GETARG_HASHSET_ANY(x)		HASHSET_NAME(datum_get_any)(PG_GETARG_DATUM(x))
+#define PG_GETARG_HASHSET_CACHED(x)		HASHSET_NAME(getarg_cached)(fcinfo, (x))
+#define PG_GETARG_HASHSET_TABLE(x)		HASHSET_NAME(getarg_table)(fcinfo, (x))
+#define PG_GETARG_HASHSET_EXPANDED(x)	HASHSET_NAME(datum_get_expanded)(PG_GETARG_DATUM(x))
+#define PG_RETURN_HASHSET_EXPANDED(x)	PG_RETURN_DATUM(EOHPGetRWDatum(&(x)->hdr))
+
+PG_FUNCTION_INFO_V1(HASHSET_NAME(in));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(out));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(send));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(recv));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(add));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(remove));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(remove_array));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(shrink_to_fit));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(contains));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(cardinality));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(union));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(init));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(capacity));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(collisions));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(max_collisions));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(agg_add));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(agg_add_set));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(agg_final));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(agg_combine));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(agg_serial));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(agg_deserial));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(to_array));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(to_sorted_array));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(elements));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(eq));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(ne));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(hash));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(hash_extended));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(lt));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(le));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(gt));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(ge));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(cmp));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(sortsupport));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(intersection));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(difference));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(symmetric_difference));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(from_array));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(agg_add_array));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(contains_any));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(contains_all));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(contains_each));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(filter_array));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(is_superset));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(is_subset));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(overlaps));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(gin_extract_value));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(gin_extract_query));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(sel));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(joinsel));
+PG_FUNCTION_INFO_V1(HASHSET_NAME(typanalyze));
+
+static bool *hashset_array_lookup(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE *values, int nvalues);
+static HASHSET_EXPANDED *hashset_expanded_from_values(HASHSET_ELEMENT_TYPE *values, int nvalues);
+static bool hashset_same_parameters(HASHSET_TYPE *a, HASHSET_TYPE *b);
+static HASHSET_TYPE *hashset_agg_init_state(FunctionCallInfo fcinfo);
+static int hashset_fastcmp(Datum x, Datum y, SortSupport ssup);
+static int hashset_abbrev_cmp(Datum x, Datum y, SortSupport ssup);
+static Datum hashset_abbrev_convert(Datum original, SortSupport ssup);
+static bool hashset_abbrev_abort(int memtupcount, SortSupport ssup);
+static void hashset_free_detoasted(Datum datum, HASHSET_TYPE *set);
+
+/*
+ * State of the abbreviated sort, tracking the cardinality of the keys
+ * (the same way as the core abbreviated sorts, e.g. for numeric).
+ */
+typedef struct hashset_sortsupport_t {
+	int64				input_count;	/* Number of abbreviated keys */
+	bool				estimating;		/* Still estimating cardinality? */
+	hyperLogLogState	abbr_card;		/* Cardinality of abbreviated keys */
+} hashset_sortsupport_t;
+
+Datum
+HASHSET_NAME(in)(PG_FUNCTION_ARGS)
+{
+	char *str = PG_GETARG_CSTRING(0);
+	char *endptr;
+	HASHSET_ELEMENT_TYPE *values;
+	int nvalues = 0;
+	int maxvalues = 16;
+	bool null_element = false;
+	int64 value;
+
+	/* Skip initial spaces */
+	while (hashset_isspace(*str)) str++;
+
+	/* Check the opening brace */
+	if (*str != '{')
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+				errmsg("invalid input syntax for hashset: \"%s\"", str),
+				errdetail("Hashset representation must start with \"{\".")));
+	}
+
+	/* Start parsing from the first number (after the opening brace) */
+	str++;
+
+	/*
+	 * Collect the values into an array, we build the compact hashset from it
+	 * at the end (there's no point in building the hash table).
+	 */
+	values = (HASHSET_ELEMENT_TYPE *) palloc(maxvalues * sizeof(HASHSET_ELEMENT_TYPE));
+
+	while (true)
+	{
+		/* Skip spaces before number */
+		while (hashset_isspace(*str)) str++;
+
+		/* Check for closing brace, handling the case for an empty set */
+		if (*str == '}')
+		{
+			str++; /* Move past the closing brace */
+			break;
+		}
+
+		/* Check if "null" is encountered (case-insensitive) */
+		if (strncasecmp(str, "null", 4) == 0)
+		{
+			null_element = true;
+			str = str + 4; /* Move past "null" */
+		}
+		else
+		{
+			/* Parse the number */
+			errno = 0;
+			value = strtoll(str, &endptr, 10);
+
+			if (errno == ERANGE ||
+				value < HASHSET_ELEMENT_MIN || value > HASHSET_ELEMENT_MAX)
+			{
+				ereport(ERROR,
+						(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+						errmsg("value \"%s\" is out of range for type %s", str,
+								HASHSET_ELEMENT_NAME)));
+			}
+
+			/* Add the value to the array, enlarge it if needed */
+			if (nvalues == maxvalues)
+			{
+				maxvalues *= 2;
+				values = (HASHSET_ELEMENT_TYPE *) repalloc(values, maxvalues * sizeof(HASHSET_ELEMENT_TYPE));
+			}
+			values[nvalues++] = (HASHSET_ELEMENT_TYPE) value;
+
+			/* Error handling for strtoll */
+			if (endptr == str)
+			{
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+						errmsg("invalid input syntax for %s: \"%s\"",
+							   HASHSET_ELEMENT_NAME, str)));
+			}
+
+			str = endptr; /* Move to next number, "null" or closing brace */
+		}
+
+        /* Skip spaces before the next number or closing brace */
+		while (hashset_isspace(*str)) str++;
+
+		if (*str == ',')
+		{
+			str++; /* Skip comma before next loop iteration */
+		}
+		else if (*str != '}')
+		{
+			/* Unexpected character */
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+					errmsg("unexpected character \"%c\" in hashset input", *str)));
+		}
+	}
+
+	/* Only whitespace is allowed after the closing brace */
+	while (*str)
+	{
+		if (!hashset_isspace(*str))
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+					errmsg("malformed hashset literal: \"%s\"", str),
+					errdetail("Junk after closing right brace.")));
+		}
+		str++;
+	}
+
+	PG_RETURN_POINTER(HASHSET_NAME(compact_values)(
+		values,
+		nvalues,
+		DEFAULT_INITIAL_CAPACITY,
+		DEFAULT_LOAD_FACTOR,
+		DEFAULT_GROWTH_FACTOR,
+		DEFAULT_HASHFN_ID,
+		null_element
+	));
+}
+
+/*
+ * The elements are always printed in ascending order, so that the output
+ * does not depend on the hash function, capacity or on whether the set
+ * was loaded from disk (compact sets are sorted anyway).
+ */
+Datum
+HASHSET_NAME(out)(PG_FUNCTION_ARGS)
+{
+	int				i;
+	HASHSET_TYPE  *set = PG_GETARG_HASHSET_ANY(0);
+	HASHSET_ELEMENT_TYPE		   *values;
+	StringInfoData	str;
+
+	values = HASHSET_NAME(extract_sorted_elements)(set);
+
+	/* Initialize the StringInfo buffer */
+	initStringInfo(&str);
+
+	/* Append the opening brace for the output hashset string */
+	appendStringInfoChar(&str, '{');
+
+	/* Loop through the elements and append them to the string */
+	for (i = 0; i < set->nelements; i++)
+	{
+		/* Append the value */
+		if (str.len > 1)
+			appendStringInfoChar(&str, ',');
+		appendStringInfo(&str, INT64_FORMAT, (int64) values[i]);
+	}
+
+	/* Check if the null_element field is set */
+	if (set->null_element)
+	{
+		if (str.len > 1)
+			appendStringInfoChar(&str, ',');
+		appendStringInfoString(&str, "NULL");
+	}
+
+	/* Append the closing brace for the output hashset string */
+	appendStringInfoChar(&str, '}');
+
+	/* Return the resulting string */
+	PG_RETURN_CSTRING(str.data);
+}
+
+/*
+ * The binary format contains the parameters of the hashset and the list
+ * of elements (in ascending order), not the hash table.
+ */
+Datum
+HASHSET_NAME(send)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE		   *set = PG_GETARG_HASHSET_ANY(0);
+	StringInfoData			buf;
+	int						version = 2;
+	HASHSET_ELEMENT_TYPE				   *values;
+	int						i;
+
+	/* Begin constructing the message */
+	pq_begintypsend(&buf);
+
+	/* Send the version number */
+	pq_sendint8(&buf, version);
+
+	/* Send the non-data fields */
+	pq_sendint32(&buf, set->capacity);
+	pq_sendint32(&buf, set->nelements);
+	pq_sendint32(&buf, set->hashfn_id);
+	pq_sendfloat4(&buf, set->load_factor);
+	pq_sendfloat4(&buf, set->growth_factor);
+	pq_sendbyte(&buf, set->null_element ? 1 : 0);
+
+	/* Send the elements */
+	values = HASHSET_NAME(extract_sorted_elements)(set);
+
+	for (i = 0; i < set->nelements; i++)
+		HASHSET_SEND_ELEMENT(&buf, values[i]);
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+#ifdef HASHSET_LEGACY_FORMAT
+/*
+ * recv_legacy
+ *		Receive a set in the binary format version 1 (release 0.0.1).
+ *
+ * That's the header fields of the stored set in the format version 0,
+ * followed by its raw data (bitmap and values). So we rebuild the stored
+ * set and convert it, just like sets stored in that format.
+ */
+static HASHSET_TYPE *
+HASHSET_NAME(recv_legacy)(StringInfo buf)
+{
+	int4hashset_legacy_t   *legacy;
+	HASHSET_TYPE		   *set;
+	int32					flags;
+	int32					capacity;
+	int32					nelements;
+	int32					hashfn_id;
+	float4					load_factor;
+	float4					growth_factor;
+	int32					ncollisions;
+	int32					max_collisions;
+	int32					hash;
+	bool					null_element;
+	int						data_size;
+
+	flags = pq_getmsgint(buf, 4);
+	capacity = pq_getmsgint(buf, 4);
+	nelements = pq_getmsgint(buf, 4);
+	hashfn_id = pq_getmsgint(buf, 4);
+	load_factor = pq_getmsgfloat4(buf);
+	growth_factor = pq_getmsgfloat4(buf);
+	ncollisions = pq_getmsgint(buf, 4);
+	max_collisions = pq_getmsgint(buf, 4);
+	hash = pq_getmsgint(buf, 4);
+	null_element = pq_getmsgbyte(buf) == 1;
+
+	data_size = buf->len - buf->cursor;
+
+	if (flags != 0 || capacity < 0 || capacity > MaxAllocSize / 8 ||
+		data_size != (capacity + 7) / 8 + capacity * sizeof(int32))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid hashset size")));
+
+	hashset_check_parameters(capacity, load_factor, growth_factor, hashfn_id);
+
+	legacy = palloc0(offsetof(int4hashset_legacy_t, data) + data_size);
+	SET_VARSIZE(legacy, offsetof(int4hashset_legacy_t, data) + data_size);
+
+	legacy->flags = 0;
+	legacy->capacity = capacity;
+	legacy->nelements = nelements;
+	legacy->hashfn_id = hashfn_id;
+	legacy->load_factor = load_factor;
+	legacy->growth_factor = growth_factor;
+	legacy->ncollisions = ncollisions;
+	legacy->max_collisions = max_collisions;
+	legacy->hash = hash;
+	legacy->null_element = null_element;
+	memcpy(legacy->data, pq_getmsgbytes(buf, data_size), data_size);
+
+	pq_getmsgend(buf);
+
+	/* Converted from the format version 0, as when reading it from disk */
+	set = HASHSET_NAME(datum_get_any)(PointerGetDatum(legacy));
+	pfree(legacy);
+
+	return set;
+}
+#endif
+
+Datum
+HASHSET_NAME(recv)(PG_FUNCTION_ARGS)
+{
+	StringInfo		buf = (StringInfo) PG_GETARG_POINTER(0);
+	int				i;
+	int				version;
+	int32			capacity;
+	int32			nelements;
+	int32			hashfn_id;
+	float4			load_factor;
+	float4			growth_factor;
+	bool			null_element;
+	HASHSET_ELEMENT_TYPE		   *values;
+
+	version = pq_getmsgint(buf, 1);
+
+#ifdef HASHSET_LEGACY_FORMAT
+	/* The binary format of release 0.0.1 (the raw hash table) */
+	if (version == 1)
+		PG_RETURN_POINTER(HASHSET_NAME(recv_legacy)(buf));
+#endif
+
+	if (version != 2)
+		elog(ERROR, "unsupported hashset version number %d", version);
+
+	/* Read fields from buffer */
+	capacity = pq_getmsgint(buf, 4);
+	nelements = pq_getmsgint(buf, 4);
+	hashfn_id = pq_getmsgint(buf, 4);
+	load_factor = pq_getmsgfloat4(buf);
+	growth_factor = pq_getmsgfloat4(buf);
+	null_element = pq_getmsgbyte(buf) == 1;
+
+	if (capacity < 0 || nelements < 0 ||
+		nelements > (buf->len - buf->cursor) / sizeof(HASHSET_ELEMENT_TYPE))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid hashset size")));
+
+	hashset_check_parameters(capacity, load_factor, growth_factor, hashfn_id);
+
+	/* Read the elements */
+	values = (HASHSET_ELEMENT_TYPE *) palloc(Max(nelements, 1) * sizeof(HASHSET_ELEMENT_TYPE));
+
+	for (i = 0; i < nelements; i++)
+		values[i] = HASHSET_RECV_ELEMENT(buf);
+
+	/* Make sure that there is no extra data left in the message */
+	pq_getmsgend(buf);
+
+	/*
+	 * Build the compact hashset. This also sorts the elements and removes
+	 * duplicates, so we don't need to trust the sender with that.
+	 */
+	PG_RETURN_POINTER(HASHSET_NAME(compact_values)(
+		values,
+		nelements,
+		capacity,
+		load_factor,
+		growth_factor,
+		hashfn_id,
+		null_element
+	));
+}
+
+Datum
+HASHSET_NAME(add)(PG_FUNCTION_ARGS)
+{
+	HASHSET_EXPANDED *eh;
+
+	/* If there's no hashset allocated, create it now */
+	if (PG_ARGISNULL(0))
+	{
+		eh = HASHSET_NAME(expanded_allocate)(
+				DEFAULT_INITIAL_CAPACITY,
+				DEFAULT_LOAD_FACTOR,
+				DEFAULT_GROWTH_FACTOR,
+				DEFAULT_HASHFN_ID,
+				CurrentMemoryContext
+		);
+	}
+	else
+	{
+		/*
+		 * Modify the set in place if we got a read/write expanded hashset,
+		 * otherwise this makes a private (expanded) copy.
+		 */
+		eh = PG_GETARG_HASHSET_EXPANDED(0);
+	}
+
+	if (PG_ARGISNULL(1))
+	{
+		eh->set->null_element = true;
+	}
+	else
+	{
+		HASHSET_ELEMENT_TYPE element = HASHSET_GETARG_ELEMENT(1);
+		eh->set = HASHSET_NAME(add_element)(eh->set, element);
+	}
+
+	PG_RETURN_HASHSET_EXPANDED(eh);
+}
+
+/*
+ * remove
+ *		Remove an element from the hashset.
+ *
+ * Just like hashset_add, a NULL element refers to the NULL element of the
+ * set. Removing an element not in the set does not change the set.
+ */
+Datum
+HASHSET_NAME(remove)(PG_FUNCTION_ARGS)
+{
+	HASHSET_EXPANDED *eh;
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	/* Modify the set in place if possible, see the add function */
+	eh = PG_GETARG_HASHSET_EXPANDED(0);
+
+	if (PG_ARGISNULL(1))
+		eh->set->null_element = false;
+	else
+		eh->set = HASHSET_NAME(remove_element)(eh->set, HASHSET_GETARG_ELEMENT(1));
+
+	PG_RETURN_HASHSET_EXPANDED(eh);
+}
+
+/*
+ * remove_array
+ *		Remove all elements of an array from the hashset.
+ *
+ * NULL elements of the array remove the NULL element of the set.
+ */
+Datum
+HASHSET_NAME(remove_array)(PG_FUNCTION_ARGS)
+{
+	HASHSET_EXPANDED *eh = PG_GETARG_HASHSET_EXPANDED(0);
+	ArrayType			   *array = PG_GETARG_ARRAYTYPE_P(1);
+	HASHSET_ELEMENT_TYPE				   *values;
+	int						nvalues;
+	bool					has_null;
+
+	values = HASHSET_NAME(array_values)(array, &nvalues, &has_null);
+
+	eh->set = HASHSET_NAME(remove_values)(eh->set, values, nvalues);
+
+	if (has_null)
+		eh->set->null_element = false;
+
+	PG_RETURN_HASHSET_EXPANDED(eh);
+}
+
+/*
+ * shrink_to_fit
+ *		Rebuild the hash table with the smallest capacity for its elements.
+ *
+ * This also gets rid of the tombstones left behind by removed elements.
+ */
+Datum
+HASHSET_NAME(shrink_to_fit)(PG_FUNCTION_ARGS)
+{
+	HASHSET_EXPANDED *eh = PG_GETARG_HASHSET_EXPANDED(0);
+
+	eh->set = HASHSET_NAME(shrink)(eh->set, 0);
+
+	PG_RETURN_HASHSET_EXPANDED(eh);
+}
+
+Datum
+HASHSET_NAME(contains)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *set;
+	HASHSET_ELEMENT_TYPE			value;
+	bool			result;
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	set = PG_GETARG_HASHSET_CACHED(0);
+
+	if (set->nelements == 0 && !set->null_element)
+		PG_RETURN_BOOL(false);
+
+	if (PG_ARGISNULL(1))
+		PG_RETURN_NULL();
+
+	value = HASHSET_GETARG_ELEMENT(1);
+	result = HASHSET_NAME(contains_element)(set, value);
+
+	if (!result && set->null_element)
+		PG_RETURN_NULL();
+
+	PG_RETURN_BOOL(result);
+}
+
+Datum
+HASHSET_NAME(cardinality)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE	*set = PG_GETARG_HASHSET_ANY(0);
+	int64			 cardinality = set->nelements + (set->null_element ? 1 : 0);
+
+	PG_RETURN_INT64(cardinality);
+}
+
+Datum
+HASHSET_NAME(union)(PG_FUNCTION_ARGS)
+{
+	HASHSET_EXPANDED *eh;
+	HASHSET_TYPE		   *seta;
+	HASHSET_TYPE		   *setb = PG_GETARG_HASHSET_ANY(1);
+
+	/*
+	 * Unless we can modify seta in place, we have to make a copy of one of
+	 * the sets anyway - so copy the larger one and add the smaller one to
+	 * it. Only when that makes no difference for the result, though.
+	 */
+	if (!VARATT_IS_EXTERNAL_EXPANDED_RW(DatumGetPointer(PG_GETARG_DATUM(0))))
+	{
+		seta = PG_GETARG_HASHSET_ANY(0);
+
+		if (seta->nelements < setb->nelements &&
+			hashset_same_parameters(seta, setb))
+		{
+			eh = HASHSET_NAME(datum_get_expanded)(PG_GETARG_DATUM(1));
+			eh->set = HASHSET_NAME(merge)(eh->set, seta);
+
+			PG_RETURN_HASHSET_EXPANDED(eh);
+		}
+	}
+
+	eh = PG_GETARG_HASHSET_EXPANDED(0);
+
+	/* Union with itself, nothing to add (and setb might get freed) */
+	if (eh->set == setb)
+		PG_RETURN_HASHSET_EXPANDED(eh);
+
+	eh->set = HASHSET_NAME(merge)(eh->set, setb);
+
+	PG_RETURN_HASHSET_EXPANDED(eh);
+}
+
+Datum
+HASHSET_NAME(init)(PG_FUNCTION_ARGS)
+{
+	HASHSET_EXPANDED *eh;
+	int32			initial_capacity = PG_GETARG_INT32(0);
+	float4			load_factor = PG_GETARG_FLOAT4(1);
+	float4			growth_factor = PG_GETARG_FLOAT4(2);
+	int32			hashfn_id = PG_GETARG_INT32(3);
+
+	hashset_check_parameters(initial_capacity, load_factor, growth_factor,
+							 hashfn_id);
+
+	eh = HASHSET_NAME(expanded_allocate)(
+		initial_capacity,
+		load_factor,
+		growth_factor,
+		hashfn_id,
+		CurrentMemoryContext
+	);
+
+	PG_RETURN_HASHSET_EXPANDED(eh);
+}
+
+Datum
+HASHSET_NAME(capacity)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *set = PG_GETARG_HASHSET_ANY(0);
+
+	PG_RETURN_INT64(set->capacity);
+}
+
+Datum
+HASHSET_NAME(collisions)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *set = PG_GETARG_HASHSET(0);
+
+	PG_RETURN_INT64(set->ncollisions);
+}
+
+Datum
+HASHSET_NAME(max_collisions)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *set = PG_GETARG_HASHSET(0);
+
+	PG_RETURN_INT64(set->max_collisions);
+}
+
+Datum
+HASHSET_NAME(agg_add)(PG_FUNCTION_ARGS)
+{
+	MemoryContext	aggcontext;
+	MemoryContext	oldcontext;
+	HASHSET_TYPE  *state;
+
+	/* cannot be called directly because of internal-type argument */
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_add_add called in non-aggregate context");
+
+	/*
+	 * We want to skip NULL values altogether - we return either the existing
+	 * hashset (if it already exists) or NULL.
+	 */
+	if (PG_ARGISNULL(1))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		/* if there already is a state accumulated, don't forget it */
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+	}
+
+	/* if there's no hashset allocated, create it now (sized up front) */
+	if (PG_ARGISNULL(0))
+	{
+		oldcontext = MemoryContextSwitchTo(aggcontext);
+		state = hashset_agg_init_state(fcinfo);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	else
+		state = (HASHSET_TYPE *) PG_GETARG_POINTER(0);
+
+	oldcontext = MemoryContextSwitchTo(aggcontext);
+
+	if (unlikely(state->capacity == HASHSET_GROUP_SIZE))
+		state = HASHSET_NAME(reserve)(state,
+									hashset_agg_resize_estimate(fcinfo, state->capacity,
+																state->nelements + state->ndeleted,
+																state->load_factor,
+																state->growth_factor));
+
+	state = HASHSET_NAME(add_element)(state, HASHSET_GETARG_ELEMENT(1));
+	MemoryContextSwitchTo(oldcontext);
+
+	PG_RETURN_POINTER(state);
+}
+
+Datum
+HASHSET_NAME(agg_add_set)(PG_FUNCTION_ARGS)
+{
+	MemoryContext   aggcontext;
+	MemoryContext	oldcontext;
+	HASHSET_TYPE  *state;
+	HASHSET_TYPE  *src;
+	bool			null_element;
+
+	/* cannot be called directly because of internal-type argument */
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_add_add called in non-aggregate context");
+
+	/*
+	 * We want to skip NULL values altogether - we return either the existing
+	 * hashset (if it already exists) or NULL.
+	 */
+	if (PG_ARGISNULL(1))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		/* if there already is a state accumulated, don't forget it */
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+	}
+
+	/* if there's no hashset allocated, create it now */
+	if (PG_ARGISNULL(0))
+	{
+		oldcontext = MemoryContextSwitchTo(aggcontext);
+		state = HASHSET_NAME(allocate)(
+			DEFAULT_INITIAL_CAPACITY,
+			DEFAULT_LOAD_FACTOR,
+			DEFAULT_GROWTH_FACTOR,
+			DEFAULT_HASHFN_ID
+		);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	else
+		state = (HASHSET_TYPE *) PG_GETARG_POINTER(0);
+
+	src = PG_GETARG_HASHSET_ANY(1);
+	null_element = state->null_element;
+
+	oldcontext = MemoryContextSwitchTo(aggcontext);
+
+	/*
+	 * If the new set is larger than the state, make a copy of it (which is
+	 * cheaper than adding it element by element), and add the state to it.
+	 */
+	if (src->nelements > state->nelements &&
+		hashset_same_parameters(state, src))
+	{
+		HASHSET_TYPE  *old = state;
+
+		if (HASHSET_IS_COMPACT(src))
+			state = HASHSET_NAME(rebuild)(src);
+		else
+			state = HASHSET_NAME(copy)(src);
+
+		state = HASHSET_NAME(merge)(state, old);
+		pfree(old);
+	}
+	else
+		state = HASHSET_NAME(merge)(state, src);
+
+	/* NULL elements of the sets are skipped, just like NULL values */
+	state->null_element = null_element;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * The state lives in the aggregate context and may be shared by multiple
+ * final function calls, so return an expanded copy of it. It gets stored
+ * in the compact format, like all other hashsets.
+ */
+Datum
+HASHSET_NAME(agg_final)(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DATUM(HASHSET_NAME(expand)(PG_GETARG_DATUM(0),
+									   CurrentMemoryContext));
+}
+
+Datum
+HASHSET_NAME(agg_combine)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *src;
+	HASHSET_TYPE  *dst;
+	MemoryContext	aggcontext;
+	MemoryContext	oldcontext;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_agg_combine called in non-aggregate context");
+
+	/* if no "merged" state yet, try creating it */
+	if (PG_ARGISNULL(0))
+	{
+		/* nope, the second argument is NULL to, so return NULL */
+		if (PG_ARGISNULL(1))
+			PG_RETURN_NULL();
+
+		/* the second argument is not NULL, so copy it */
+		src = (HASHSET_TYPE *) PG_GETARG_POINTER(1);
+
+		/* copy the hashset into the right long-lived memory context */
+		oldcontext = MemoryContextSwitchTo(aggcontext);
+		src = HASHSET_NAME(copy)(src);
+		MemoryContextSwitchTo(oldcontext);
+
+		PG_RETURN_POINTER(src);
+	}
+
+	/*
+	 * If the second argument is NULL, just return the first one (we know
+	 * it's not NULL at this point).
+	 */
+	if (PG_ARGISNULL(1))
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+
+	/* Now we know neither argument is NULL, so merge them. */
+	src = (HASHSET_TYPE *) PG_GETARG_POINTER(1);
+	dst = (HASHSET_TYPE *) PG_GETARG_POINTER(0);
+
+	/*
+	 * Merge the smaller state into the larger one. The src state may not be
+	 * in the aggregate context, so we have to copy it, but that's still much
+	 * cheaper than inserting all its elements into dst.
+	 */
+	if (src->nelements > dst->nelements &&
+		hashset_same_parameters(dst, src))
+	{
+		HASHSET_TYPE  *old = dst;
+
+		oldcontext = MemoryContextSwitchTo(aggcontext);
+		dst = HASHSET_NAME(copy)(src);
+		MemoryContextSwitchTo(oldcontext);
+
+		dst = HASHSET_NAME(merge)(dst, old);
+		pfree(old);
+	}
+	else
+		dst = HASHSET_NAME(merge)(dst, src);
+
+	PG_RETURN_POINTER(dst);
+}
+
+/*
+ * agg_serial
+ *		Serialize the aggregate state, so that it can be passed between
+ *		parallel workers.
+ *
+ * We only send the parameters of the hashset and a list of the elements,
+ * not the whole (mostly empty) hash table.
+ */
+Datum
+HASHSET_NAME(agg_serial)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE		   *state;
+	StringInfoData			buf;
+	HASHSET_ITERATOR	iter;
+	HASHSET_ELEMENT_TYPE					value;
+
+	/* cannot be called directly because of internal-type argument */
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "hashset_agg_serial called in non-aggregate context");
+
+	state = (HASHSET_TYPE *) PG_GETARG_POINTER(0);
+
+	pq_begintypsend(&buf);
+
+	pq_sendint32(&buf, state->nelements);
+	pq_sendint32(&buf, state->hashfn_id);
+	pq_sendfloat4(&buf, state->load_factor);
+	pq_sendfloat4(&buf, state->growth_factor);
+	pq_sendbyte(&buf, state->null_element ? 1 : 0);
+
+	HASHSET_NAME(iterator_init)(&iter, state);
+	while (HASHSET_NAME(iterator_next)(&iter, &value))
+		HASHSET_SEND_ELEMENT(&buf, value);
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/*
+ * agg_deserial
+ *		Rebuild the aggregate state from the serialized element list.
+ *
+ * The hashset is sized for the number of elements right away, so that
+ * adding the elements does not need to resize it.
+ */
+Datum
+HASHSET_NAME(agg_deserial)(PG_FUNCTION_ARGS)
+{
+	int				i;
+	bytea		   *sstate;
+	StringInfoData	buf;
+	HASHSET_TYPE  *state;
+	int32			nelements;
+	int32			hashfn_id;
+	float4			load_factor;
+	float4			growth_factor;
+	bool			null_element;
+	HASHSET_ELEMENT_TYPE		   *values;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "hashset_agg_deserial called in non-aggregate context");
+
+	sstate = PG_GETARG_BYTEA_PP(0);
+
+	/*
+	 * Copy the bytea into a StringInfo so that we can "receive" it using the
+	 * standard recv-function infrastructure.
+	 */
+	initStringInfo(&buf);
+	appendBinaryStringInfo(&buf,
+						   VARDATA_ANY(sstate), VARSIZE_ANY_EXHDR(sstate));
+
+	nelements = pq_getmsgint(&buf, 4);
+	hashfn_id = pq_getmsgint(&buf, 4);
+	load_factor = pq_getmsgfloat4(&buf);
+	growth_factor = pq_getmsgfloat4(&buf);
+	null_element = pq_getmsgbyte(&buf) == 1;
+
+	state = HASHSET_NAME(allocate)(
+		(int) (nelements / load_factor) + 1,
+		load_factor,
+		growth_factor,
+		hashfn_id
+	);
+
+	values = (HASHSET_ELEMENT_TYPE *) palloc(Max(nelements, 1) * sizeof(HASHSET_ELEMENT_TYPE));
+
+	for (i = 0; i < nelements; i++)
+		values[i] = HASHSET_RECV_ELEMENT(&buf);
+
+	state = HASHSET_NAME(add_values)(state, values, nelements);
+
+	state->null_element = null_element;
+
+	pq_getmsgend(&buf);
+	pfree(buf.data);
+
+	PG_RETURN_POINTER(state);
+}
+
+Datum
+HASHSET_NAME(to_array)(PG_FUNCTION_ARGS)
+{
+	int						idx;
+	HASHSET_TYPE		   *set = PG_GETARG_HASHSET_ANY(0);
+	HASHSET_ELEMENT_TYPE				   *values;
+	int						nvalues;
+	HASHSET_ITERATOR	iter;
+
+	/* if hashset is empty and does not contain null, return an empty array */
+	if(set->nelements == 0 && !set->null_element)
+		PG_RETURN_ARRAYTYPE_P(construct_empty_array(HASHSET_ELEMENT_OID));
+
+	/* number of values to store in the array */
+	nvalues = set->nelements;
+	values = (HASHSET_ELEMENT_TYPE *) palloc(sizeof(HASHSET_ELEMENT_TYPE) * Max(nvalues, 1));
+
+	idx = 0;
+	HASHSET_NAME(iterator_init)(&iter, set);
+	while (HASHSET_NAME(iterator_next)(&iter, &values[idx]))
+		idx++;
+
+	Assert(idx == nvalues);
+
+	return HASHSET_NAME(values_to_array)(fcinfo, values, nvalues, set->null_element);
+}
+
+Datum
+HASHSET_NAME(to_sorted_array)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE	   *set;
+	HASHSET_ELEMENT_TYPE			   *values;
+	int					nvalues;
+
+	set = PG_GETARG_HASHSET_ANY(0);
+
+	/* if hashset is empty and does not contain null, return an empty array */
+	if(set->nelements == 0 && !set->null_element)
+		PG_RETURN_ARRAYTYPE_P(construct_empty_array(HASHSET_ELEMENT_OID));
+
+	/* extract the sorted elements from the hashset */
+	values = HASHSET_NAME(extract_sorted_elements)(set);
+
+	/* number of values to store in the array */
+	nvalues = set->nelements;
+
+	return HASHSET_NAME(values_to_array)(fcinfo, values, nvalues, set->null_element);
+}
+
+/*
+ * elements
+ *		Return the elements of the hashset as a set of rows.
+ *
+ * The elements are returned one per call, straight from the hash table (or
+ * decoded from the compact format), with an iterator kept in the function
+ * context - so there's no intermediate array. Like hashset_to_array(), the
+ * NULL element (if any) is returned last.
+ */
+Datum
+HASHSET_NAME(elements)(PG_FUNCTION_ARGS)
+{
+	FuncCallContext		   *funcctx;
+	HASHSET_ITERATOR *iter;
+	HASHSET_ELEMENT_TYPE					value;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext	oldcontext;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		/* the detoasted set and the iterator have to survive across calls */
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		iter = (HASHSET_ITERATOR *) palloc(sizeof(HASHSET_ITERATOR));
+		HASHSET_NAME(iterator_init)(iter, PG_GETARG_HASHSET_ANY(0));
+		funcctx->user_fctx = iter;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	iter = (HASHSET_ITERATOR *) funcctx->user_fctx;
+
+	if (HASHSET_NAME(iterator_next)(iter, &value))
+		SRF_RETURN_NEXT(funcctx, HASHSET_ELEMENT_GET_DATUM(value));
+
+	if (iter->set->null_element && funcctx->call_cntr == iter->set->nelements)
+		SRF_RETURN_NEXT_NULL(funcctx);
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+Datum
+HASHSET_NAME(eq)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE		   *a = PG_GETARG_HASHSET_ANY(0);
+	HASHSET_TYPE		   *b = PG_GETARG_HASHSET_ANY(1);
+	HASHSET_ITERATOR	iter;
+	HASHSET_ELEMENT_TYPE					value;
+
+	/*
+	 * Check if the number of elements is the same
+	 */
+	if (a->nelements != b->nelements)
+		PG_RETURN_BOOL(false);
+
+	if (a->null_element != b->null_element)
+		PG_RETURN_BOOL(false);
+
+	/*
+	 * The compact encoding of a set of elements is unique, so two compact
+	 * sets are equal exactly when the encoding and the encoded data are.
+	 */
+	if (HASHSET_IS_COMPACT(a) && HASHSET_IS_COMPACT(b))
+	{
+		Size	len = VARSIZE(a) - offsetof(HASHSET_TYPE, data);
+
+		PG_RETURN_BOOL(HASHSET_IS_CONTAINERS(a) == HASHSET_IS_CONTAINERS(b) &&
+					   VARSIZE(a) == VARSIZE(b) &&
+					   memcmp(a->data, b->data, len) == 0);
+	}
+
+	/* Make sure we probe a hash table, not a compact set */
+	if (HASHSET_IS_COMPACT(b))
+	{
+		HASHSET_TYPE  *tmp = a;
+
+		a = b;
+		b = tmp;
+	}
+
+	/*
+	 * Check if every element in a is also in b
+	 */
+	HASHSET_NAME(iterator_init)(&iter, a);
+	while (HASHSET_NAME(iterator_next)(&iter, &value))
+	{
+		if (!HASHSET_NAME(contains_element)(b, value))
+			PG_RETURN_BOOL(false);
+	}
+
+	/*
+	 * All elements in a are in b and the number of elements is the same,
+	 * so the sets must be equal.
+	 */
+	PG_RETURN_BOOL(true);
+}
+
+
+Datum
+HASHSET_NAME(ne)(PG_FUNCTION_ARGS)
+{
+	Datum	eq = HASHSET_NAME(eq)(fcinfo);
+
+	PG_RETURN_BOOL(!DatumGetBool(eq));
+}
+
+
+Datum HASHSET_NAME(hash)(PG_FUNCTION_ARGS)
+{
+    HASHSET_TYPE *set = PG_GETARG_HASHSET_ANY(0);
+
+    PG_RETURN_INT32((int32) HASHSET_NAME(canonical_hash)(set, 0));
+}
+
+
+Datum
+HASHSET_NAME(hash_extended)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *set = PG_GETARG_HASHSET_ANY(0);
+
+	PG_RETURN_INT64((int64) HASHSET_NAME(canonical_hash)(set, PG_GETARG_INT64(1)));
+}
+
+
+Datum
+HASHSET_NAME(lt)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *a = PG_GETARG_HASHSET_ANY(0);
+	HASHSET_TYPE  *b = PG_GETARG_HASHSET_ANY(1);
+
+	PG_RETURN_BOOL(HASHSET_NAME(compare)(a, b) < 0);
+}
+
+
+Datum
+HASHSET_NAME(le)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *a = PG_GETARG_HASHSET_ANY(0);
+	HASHSET_TYPE  *b = PG_GETARG_HASHSET_ANY(1);
+
+	PG_RETURN_BOOL(HASHSET_NAME(compare)(a, b) <= 0);
+}
+
+
+Datum
+HASHSET_NAME(gt)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *a = PG_GETARG_HASHSET_ANY(0);
+	HASHSET_TYPE  *b = PG_GETARG_HASHSET_ANY(1);
+
+	PG_RETURN_BOOL(HASHSET_NAME(compare)(a, b) > 0);
+}
+
+
+Datum
+HASHSET_NAME(ge)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *a = PG_GETARG_HASHSET_ANY(0);
+	HASHSET_TYPE  *b = PG_GETARG_HASHSET_ANY(1);
+
+	PG_RETURN_BOOL(HASHSET_NAME(compare)(a, b) >= 0);
+}
+
+Datum
+HASHSET_NAME(cmp)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *a = PG_GETARG_HASHSET_ANY(0);
+	HASHSET_TYPE  *b = PG_GETARG_HASHSET_ANY(1);
+
+	PG_RETURN_INT32(HASHSET_NAME(compare)(a, b));
+}
+
+/*
+ * sortsupport
+ *		Sort support for the btree opclass.
+ *
+ * The comparator skips the fmgr overhead, and the abbreviated keys combine
+ * the canonical hash with the number of elements, i.e. the first two keys
+ * of the compare function. So most comparisons in a sort are done on the
+ * abbreviated keys, and the elements are compared only for sets that have
+ * the same hash and size (which mostly means equal sets). Both keys come
+ * from the header, so neither the abbreviation nor the full comparison has
+ * to hash the elements. When most sets are equal, the abbreviation gets
+ * aborted (see hashset_abbrev_abort).
+ */
+Datum
+HASHSET_NAME(sortsupport)(PG_FUNCTION_ARGS)
+{
+	SortSupport	ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+	ssup->comparator = hashset_fastcmp;
+
+	if (ssup->abbreviate)
+	{
+		hashset_sortsupport_t  *state;
+		MemoryContext			oldcontext;
+
+		oldcontext = MemoryContextSwitchTo(ssup->ssup_cxt);
+
+		state = palloc(sizeof(hashset_sortsupport_t));
+		state->input_count = 0;
+		state->estimating = true;
+		initHyperLogLog(&state->abbr_card, 10);
+
+		MemoryContextSwitchTo(oldcontext);
+
+		ssup->ssup_extra = state;
+		ssup->comparator = hashset_abbrev_cmp;
+		ssup->abbrev_converter = hashset_abbrev_convert;
+		ssup->abbrev_abort = hashset_abbrev_abort;
+		ssup->abbrev_full_comparator = hashset_fastcmp;
+	}
+
+	PG_RETURN_VOID();
+}
+
+static int
+hashset_fastcmp(Datum x, Datum y, SortSupport ssup)
+{
+	HASHSET_TYPE  *a = HASHSET_NAME(datum_get_any)(x);
+	HASHSET_TYPE  *b = HASHSET_NAME(datum_get_any)(y);
+	int				result = HASHSET_NAME(compare)(a, b);
+
+	/* Sorts do many comparisons, so don't leak the detoasted copies */
+	hashset_free_detoasted(x, a);
+	hashset_free_detoasted(y, b);
+
+	return result;
+}
+
+static int
+hashset_abbrev_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	if (x < y)
+		return -1;
+	else if (x > y)
+		return 1;
+
+	return 0;
+}
+
+/*
+ * The abbreviated key is the 32-bit canonical hash in the upper half, and
+ * the number of elements in the lower half. With 4-byte Datums there's only
+ * room for the hash.
+ */
+static Datum
+hashset_abbrev_convert(Datum original, SortSupport ssup)
+{
+	hashset_sortsupport_t  *state = (hashset_sortsupport_t *) ssup->ssup_extra;
+	HASHSET_TYPE		   *set = HASHSET_NAME(datum_get_any)(original);
+	uint32					hash = (uint32) HASHSET_NAME(canonical_hash)(set, 0);
+	Datum					result;
+
+	/* The hash includes the number of elements, and it's random enough */
+	state->input_count++;
+	if (state->estimating)
+		addHyperLogLog(&state->abbr_card, hash);
+
+#if SIZEOF_DATUM == 8
+	result = (Datum) (((uint64) hash << 32) | (uint32) set->nelements);
+#else
+	result = (Datum) hash;
+#endif
+
+	hashset_free_detoasted(original, set);
+
+	return result;
+}
+
+/*
+ * Abort the abbreviation when the keys turn out to be mostly duplicates
+ * (i.e. the sets are mostly equal), using the same heuristics as numeric.
+ * The full comparisons would have to look at the elements anyway, so the
+ * abbreviated keys would only add overhead.
+ */
+static bool
+hashset_abbrev_abort(int memtupcount, SortSupport ssup)
+{
+	hashset_sortsupport_t  *state = (hashset_sortsupport_t *) ssup->ssup_extra;
+	double					abbr_card;
+
+	if (memtupcount < 10000 || state->input_count < 10000 || !state->estimating)
+		return false;
+
+	abbr_card = estimateHyperLogLog(&state->abbr_card);
+
+	/*
+	 * With enough distinct keys we're unlikely to abort later, so stop
+	 * paying for the estimation.
+	 */
+	if (abbr_card > 100000.0)
+	{
+		state->estimating = false;
+		return false;
+	}
+
+	/* Abort when there's fewer than one distinct key per 10000 inputs */
+	if (abbr_card < state->input_count / 10000.0 + 0.5)
+		return true;
+
+	return false;
+}
+
+/*
+ * Free the set if it's a detoasted copy of the datum (not the datum itself,
+ * and not a set owned by an expanded object).
+ */
+static void
+hashset_free_detoasted(Datum datum, HASHSET_TYPE *set)
+{
+	if ((Pointer) set != DatumGetPointer(datum) &&
+		!VARATT_IS_EXTERNAL_EXPANDED(DatumGetPointer(datum)))
+		pfree(set);
+}
+
+/*
+ * intersection
+ *		Compute the intersection of two hashsets.
+ *
+ * We scan the smaller set and look up its elements in the larger one, so
+ * intersecting a tiny set with a huge one is cheap. When both sets are
+ * hash tables using the same hash function, the hits are copied into the
+ * result (as large as the smaller set) without rehashing. Otherwise the
+ * hits are collected first, and the result is sized for them.
+ */
+Datum
+HASHSET_NAME(intersection)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE		   *seta = PG_GETARG_HASHSET_ANY(0);
+	HASHSET_TYPE		   *setb = PG_GETARG_HASHSET_ANY(1);
+	HASHSET_TYPE		   *small = seta;
+	HASHSET_TYPE		   *large = setb;
+	HASHSET_EXPANDED *intersection;
+	HASHSET_ELEMENT_TYPE				   *values;
+	int						nvalues;
+
+	if (seta->nelements > setb->nelements)
+	{
+		small = setb;
+		large = seta;
+	}
+
+	if (HASHSET_NAME(is_aligned)(large, small))
+	{
+		intersection = HASHSET_NAME(expanded_allocate)(
+			small->capacity,
+			small->load_factor,
+			small->growth_factor,
+			small->hashfn_id,
+			CurrentMemoryContext
+		);
+
+		intersection->set = HASHSET_NAME(filter_aligned)(intersection->set,
+													   large, small, true);
+	}
+	else
+	{
+		/* Elements of the smaller set that are also in the larger one */
+		values = (HASHSET_ELEMENT_TYPE *) palloc(Max(small->nelements, 1) * sizeof(HASHSET_ELEMENT_TYPE));
+		nvalues = HASHSET_NAME(filter)(large, small, true, values);
+
+		intersection = hashset_expanded_from_values(values, nvalues);
+	}
+
+	if (seta->null_element && setb->null_element)
+		intersection->set->null_element = true;
+
+	PG_RETURN_HASHSET_EXPANDED(intersection);
+}
+
+/*
+ * difference
+ *		Compute the difference of two hashsets.
+ *
+ * Same as the intersection, except that we always have to scan the
+ * first set and keep the elements not found in the second one.
+ */
+Datum
+HASHSET_NAME(difference)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE		   *seta = PG_GETARG_HASHSET_ANY(0);
+	HASHSET_TYPE		   *setb = PG_GETARG_HASHSET_ANY(1);
+	HASHSET_EXPANDED *difference;
+	HASHSET_ELEMENT_TYPE				   *values;
+	int						nvalues;
+
+	if (HASHSET_NAME(is_aligned)(setb, seta))
+	{
+		difference = HASHSET_NAME(expanded_allocate)(
+			seta->capacity,
+			seta->load_factor,
+			seta->growth_factor,
+			seta->hashfn_id,
+			CurrentMemoryContext
+		);
+
+		difference->set = HASHSET_NAME(filter_aligned)(difference->set,
+													 setb, seta, false);
+	}
+	else
+	{
+		/* Elements of seta that are not in setb */
+		values = (HASHSET_ELEMENT_TYPE *) palloc(Max(seta->nelements, 1) * sizeof(HASHSET_ELEMENT_TYPE));
+		nvalues = HASHSET_NAME(filter)(setb, seta, false, values);
+
+		difference = hashset_expanded_from_values(values, nvalues);
+	}
+
+	if (seta->null_element && !setb->null_element)
+		difference->set->null_element = true;
+
+	PG_RETURN_HASHSET_EXPANDED(difference);
+}
+
+/*
+ * symmetric_difference
+ *		Compute the symmetric difference of two hashsets.
+ *
+ * Done as two differences. With aligned hash tables the first one is
+ * copied without rehashing (and the second one added to it), otherwise
+ * we collect both and size the result for them.
+ */
+Datum
+HASHSET_NAME(symmetric_difference)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE		   *seta = PG_GETARG_HASHSET_ANY(0);
+	HASHSET_TYPE		   *setb = PG_GETARG_HASHSET_ANY(1);
+	HASHSET_EXPANDED *result;
+	HASHSET_ELEMENT_TYPE				   *values;
+	int						nvalues;
+
+	if (HASHSET_NAME(is_aligned)(setb, seta))
+	{
+		result = HASHSET_NAME(expanded_allocate)(
+			seta->capacity,
+			seta->load_factor,
+			seta->growth_factor,
+			seta->hashfn_id,
+			CurrentMemoryContext
+		);
+
+		/* Add elements that are in seta but not in setb */
+		result->set = HASHSET_NAME(filter_aligned)(result->set,
+												 setb, seta, false);
+
+		/* Add elements that are in setb but not in seta */
+		values = (HASHSET_ELEMENT_TYPE *) palloc(Max(setb->nelements, 1) * sizeof(HASHSET_ELEMENT_TYPE));
+		nvalues = HASHSET_NAME(filter)(seta, setb, false, values);
+
+		result->set = HASHSET_NAME(add_values)(result->set, values, nvalues);
+	}
+	else
+	{
+		values = (HASHSET_ELEMENT_TYPE *) palloc(Max(seta->nelements + setb->nelements, 1) *
+								  sizeof(HASHSET_ELEMENT_TYPE));
+
+		/* Add elements that are in seta but not in setb */
+		nvalues = HASHSET_NAME(filter)(setb, seta, false, values);
+
+		/* Add elements that are in setb but not in seta */
+		nvalues += HASHSET_NAME(filter)(seta, setb, false, values + nvalues);
+
+		result = hashset_expanded_from_values(values, nvalues);
+	}
+
+	if (seta->null_element ^ setb->null_element)
+		result->set->null_element = true;
+
+	PG_RETURN_HASHSET_EXPANDED(result);
+}
+
+/*
+ * from_array
+ *		Build a hashset from an array.
+ *
+ * The hashset is sized for the number of array elements right away, and
+ * the elements are added in batches (see the add_values function). NULL
+ * elements are kept as the NULL element of the set.
+ */
+Datum
+HASHSET_NAME(from_array)(PG_FUNCTION_ARGS)
+{
+	ArrayType			   *array = PG_GETARG_ARRAYTYPE_P(0);
+	HASHSET_EXPANDED *eh;
+	HASHSET_ELEMENT_TYPE				   *values;
+	int						nvalues;
+	bool					has_null;
+
+	values = HASHSET_NAME(array_values)(array, &nvalues, &has_null);
+
+	eh = hashset_expanded_from_values(values, nvalues);
+	eh->set->null_element = has_null;
+
+	PG_RETURN_HASHSET_EXPANDED(eh);
+}
+
+/*
+ * agg_add_array
+ *		Add all elements of an array to the aggregate state.
+ *
+ * Same as hashset_agg(unnest(array)), so NULL arrays and NULL elements
+ * are skipped, without passing the elements through the executor.
+ */
+Datum
+HASHSET_NAME(agg_add_array)(PG_FUNCTION_ARGS)
+{
+	MemoryContext	aggcontext;
+	MemoryContext	oldcontext;
+	HASHSET_TYPE  *state;
+	ArrayType	   *array;
+	HASHSET_ELEMENT_TYPE		   *values;
+	int				nvalues;
+	bool			has_null;
+
+	/* cannot be called directly because of internal-type argument */
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hashset_agg_add_array called in non-aggregate context");
+
+	/*
+	 * We want to skip NULL values altogether - we return either the existing
+	 * hashset (if it already exists) or NULL.
+	 */
+	if (PG_ARGISNULL(1))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		/* if there already is a state accumulated, don't forget it */
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+	}
+
+	array = PG_GETARG_ARRAYTYPE_P(1);
+	values = HASHSET_NAME(array_values)(array, &nvalues, &has_null);
+
+	/* if there's no hashset allocated, create it now (sized for the array) */
+	if (PG_ARGISNULL(0))
+	{
+		oldcontext = MemoryContextSwitchTo(aggcontext);
+		state = HASHSET_NAME(allocate)(
+			(nvalues > 0) ? (int) (nvalues / DEFAULT_LOAD_FACTOR) + 1 : 0,
+			DEFAULT_LOAD_FACTOR,
+			DEFAULT_GROWTH_FACTOR,
+			DEFAULT_HASHFN_ID
+		);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	else
+		state = (HASHSET_TYPE *) PG_GETARG_POINTER(0);
+
+	oldcontext = MemoryContextSwitchTo(aggcontext);
+	state = HASHSET_NAME(add_values)(state, values, nvalues);
+	MemoryContextSwitchTo(oldcontext);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * contains_any
+ *		Check if the hashset contains any of the array elements.
+ *
+ * Same as "hashset_contains(set, x)" OR-ed over the array elements, so the
+ * result is NULL if none of the elements is found but some of the results
+ * are NULL (NULL elements, or the set contains NULL).
+ */
+Datum
+HASHSET_NAME(contains_any)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *set = PG_GETARG_HASHSET_TABLE(0);
+	ArrayType	   *array = PG_GETARG_ARRAYTYPE_P(1);
+	HASHSET_ELEMENT_TYPE		   *values;
+	int				nvalues;
+	bool			has_null;
+	bool		   *found;
+	int				i;
+
+	if (set->nelements == 0 && !set->null_element)
+		PG_RETURN_BOOL(false);
+
+	values = HASHSET_NAME(array_values)(array, &nvalues, &has_null);
+	found = hashset_array_lookup(set, values, nvalues);
+
+	for (i = 0; i < nvalues; i++)
+	{
+		if (found[i])
+			PG_RETURN_BOOL(true);
+	}
+
+	if (has_null || (nvalues > 0 && set->null_element))
+		PG_RETURN_NULL();
+
+	PG_RETURN_BOOL(false);
+}
+
+/*
+ * contains_all
+ *		Check if the hashset contains all of the array elements.
+ *
+ * Same as "hashset_contains(set, x)" AND-ed over the array elements, so the
+ * result is NULL if no element is missing for sure but some of the results
+ * are NULL. An empty array is contained in every set.
+ */
+Datum
+HASHSET_NAME(contains_all)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *set = PG_GETARG_HASHSET_TABLE(0);
+	ArrayType	   *array = PG_GETARG_ARRAYTYPE_P(1);
+	HASHSET_ELEMENT_TYPE		   *values;
+	int				nvalues;
+	bool			has_null;
+	bool		   *found;
+	int				i;
+
+	values = HASHSET_NAME(array_values)(array, &nvalues, &has_null);
+
+	if (set->nelements == 0 && !set->null_element)
+		PG_RETURN_BOOL(nvalues == 0 && !has_null);
+
+	found = hashset_array_lookup(set, values, nvalues);
+
+	for (i = 0; i < nvalues; i++)
+	{
+		if (found[i])
+			continue;
+
+		/* a missing element is unknown if the set contains NULL */
+		if (!set->null_element)
+			PG_RETURN_BOOL(false);
+
+		has_null = true;
+	}
+
+	if (has_null)
+		PG_RETURN_NULL();
+
+	PG_RETURN_BOOL(true);
+}
+
+/*
+ * contains_each
+ *		Check which of the array elements the hashset contains.
+ *
+ * Returns a boolean array of the same shape as the input array, with the
+ * result of "hashset_contains(set, x)" for each element.
+ */
+Datum
+HASHSET_NAME(contains_each)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *set = PG_GETARG_HASHSET_TABLE(0);
+	ArrayType	   *array = PG_GETARG_ARRAYTYPE_P(1);
+	HASHSET_ELEMENT_TYPE		   *values;
+	int				nvalues;
+	bool			has_null;
+	bool		   *found;
+	int				nitems;
+	Datum		   *datums;
+	bool		   *nulls;
+	bits8		   *bitmap;
+	bool			empty;
+	int				i,
+					j;
+
+	nitems = ArrayGetNItems(ARR_NDIM(array), ARR_DIMS(array));
+	if (nitems == 0)
+		PG_RETURN_ARRAYTYPE_P(construct_empty_array(BOOLOID));
+
+	values = HASHSET_NAME(array_values)(array, &nvalues, &has_null);
+	found = hashset_array_lookup(set, values, nvalues);
+	empty = (set->nelements == 0 && !set->null_element);
+
+	datums = (Datum *) palloc(nitems * sizeof(Datum));
+	nulls = (bool *) palloc(nitems * sizeof(bool));
+	bitmap = ARR_NULLBITMAP(array);
+
+	/* found[] has results only for the non-NULL elements */
+	for (i = 0, j = 0; i < nitems; i++)
+	{
+		bool	isnull = (bitmap != NULL && !(bitmap[i / 8] & (1 << (i % 8))));
+
+		if (empty)
+		{
+			datums[i] = BoolGetDatum(false);
+			nulls[i] = false;
+		}
+		else if (isnull)
+		{
+			datums[i] = (Datum) 0;
+			nulls[i] = true;
+		}
+		else
+		{
+			datums[i] = BoolGetDatum(found[j]);
+			nulls[i] = (!found[j] && set->null_element);
+		}
+
+		if (!isnull)
+			j++;
+	}
+
+	PG_RETURN_ARRAYTYPE_P(construct_md_array(datums, nulls,
+											 ARR_NDIM(array),
+											 ARR_DIMS(array),
+											 ARR_LBOUND(array),
+											 BOOLOID, 1, true, TYPALIGN_CHAR));
+}
+
+/*
+ * filter_array
+ *		Return the array elements contained in the hashset.
+ *
+ * The elements are returned in the array order, including duplicates, as
+ * a one-dimensional array. NULL elements are never returned.
+ */
+Datum
+HASHSET_NAME(filter_array)(PG_FUNCTION_ARGS)
+{
+	ArrayType	   *array = PG_GETARG_ARRAYTYPE_P(0);
+	HASHSET_TYPE  *set = PG_GETARG_HASHSET_TABLE(1);
+	HASHSET_ELEMENT_TYPE		   *values;
+	HASHSET_ELEMENT_TYPE		   *result;
+	int				nvalues;
+	int				nresult = 0;
+	bool			has_null;
+	bool		   *found;
+	int				i;
+
+	values = HASHSET_NAME(array_values)(array, &nvalues, &has_null);
+	found = hashset_array_lookup(set, values, nvalues);
+
+	result = (HASHSET_ELEMENT_TYPE *) palloc(Max(nvalues, 1) * sizeof(HASHSET_ELEMENT_TYPE));
+	for (i = 0; i < nvalues; i++)
+	{
+		if (found[i])
+			result[nresult++] = values[i];
+	}
+
+	if (nresult == 0)
+		PG_RETURN_ARRAYTYPE_P(construct_empty_array(HASHSET_ELEMENT_OID));
+
+	return HASHSET_NAME(values_to_array)(fcinfo, result, nresult, false);
+}
+
+/*
+ * is_superset
+ *		Check if the first hashset contains all elements of the second one.
+ *
+ * Backs the @> operator (and <@ with the arguments swapped). As in the set
+ * operations, the NULL element is treated as a regular element. The sets
+ * are used in the format we get them (hash tables are only rebuilt for
+ * constants, once per query), see the contains_set function.
+ */
+Datum
+HASHSET_NAME(is_superset)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *a = PG_GETARG_HASHSET_CACHED(0);
+	HASHSET_TYPE  *b = PG_GETARG_HASHSET_CACHED(1);
+
+	PG_RETURN_BOOL(HASHSET_NAME(contains_set)(a, b));
+}
+
+Datum
+HASHSET_NAME(is_subset)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *a = PG_GETARG_HASHSET_CACHED(0);
+	HASHSET_TYPE  *b = PG_GETARG_HASHSET_CACHED(1);
+
+	PG_RETURN_BOOL(HASHSET_NAME(contains_set)(b, a));
+}
+
+/*
+ * overlaps
+ *		Check if the hashsets have any element in common (the && operator).
+ */
+Datum
+HASHSET_NAME(overlaps)(PG_FUNCTION_ARGS)
+{
+	HASHSET_TYPE  *a = PG_GETARG_HASHSET_CACHED(0);
+	HASHSET_TYPE  *b = PG_GETARG_HASHSET_CACHED(1);
+
+	PG_RETURN_BOOL(HASHSET_NAME(intersects)(a, b));
+}
+
+/*
+ * hashset_array_lookup
+ *		Look up the values in the hash table, in batches.
+ *
+ * Returns an array of flags, with true for values contained in the set.
+ */
+static bool *
+hashset_array_lookup(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE *values, int nvalues)
+{
+	bool   *found = (bool *) palloc(Max(nvalues, 1) * sizeof(bool));
+
+	HASHSET_NAME(contains_values)(set, values, nvalues, found);
+
+	return found;
+}
+
+/*
+ * hashset_agg_init_state
+ *		Allocate the state of hashset_agg(int) in the current memory context.
+ *
+ * The optional aggregate arguments (expected number of elements, load
+ * factor and hash function) follow the value. The state is sized for the
+ * expected number of elements right away, so that it does not need to go
+ * through all the resizes. Without the hint the state starts with a single
+ * group of slots, and only the first resize uses the planner estimate of
+ * the group size (see hashset_agg_resize_estimate).
+ */
+static HASHSET_TYPE *
+hashset_agg_init_state(FunctionCallInfo fcinfo)
+{
+	int64	expected;
+	int64	capacity = 0;
+	float4	load_factor = DEFAULT_LOAD_FACTOR;
+	int32	hashfn_id = DEFAULT_HASHFN_ID;
+
+	if (PG_NARGS() > 4)
+	{
+		if (!PG_ARGISNULL(3))
+			load_factor = PG_GETARG_FLOAT4(3);
+
+		if (!PG_ARGISNULL(4))
+			hashfn_id = PG_GETARG_INT32(4);
+	}
+
+	if (PG_NARGS() > 2 && !PG_ARGISNULL(2))
+	{
+		expected = PG_GETARG_INT32(2);
+
+		if (expected < 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("expected count cannot be negative")));
+
+		if (expected > 0)
+			capacity = Min((int64) (expected / load_factor) + 1, PG_INT32_MAX);
+	}
+	else
+		capacity = HASHSET_GROUP_SIZE;
+
+	hashset_check_parameters((int32) capacity, load_factor,
+							 DEFAULT_GROWTH_FACTOR, hashfn_id);
+
+	return HASHSET_NAME(allocate)(
+		(int32) capacity,
+		load_factor,
+		DEFAULT_GROWTH_FACTOR,
+		hashfn_id
+	);
+}
+
+/*
+ * hashset_same_parameters
+ *		Check if the hashsets were created with the same parameters.
+ *
+ * When merging two such sets, it does not matter which of them the other
+ * one gets added to - the result is the same (except for the capacity).
+ */
+static bool
+hashset_same_parameters(HASHSET_TYPE *a, HASHSET_TYPE *b)
+{
+	return (a->hashfn_id == b->hashfn_id &&
+			a->load_factor == b->load_factor &&
+			a->growth_factor == b->growth_factor);
+}
+
+/*
+ * hashset_expanded_from_values
+ *		Build an expanded hashset with the given values.
+ *
+ * The hashset is sized for the number of values right away, so it does not
+ * need to be resized while adding them.
+ */
+static HASHSET_EXPANDED *
+hashset_expanded_from_values(HASHSET_ELEMENT_TYPE *values, int nvalues)
+{
+	HASHSET_EXPANDED *eh;
+
+	eh = HASHSET_NAME(expanded_allocate)(
+		(nvalues > 0) ? (int) (nvalues / DEFAULT_LOAD_FACTOR) + 1 : 0,
+		DEFAULT_LOAD_FACTOR,
+		DEFAULT_GROWTH_FACTOR,
+		DEFAULT_HASHFN_ID,
+		CurrentMemoryContext
+	);
+
+	eh->set = HASHSET_NAME(add_values)(eh->set, values, nvalues);
+
+	return eh;
+}
+
+/*
+ * array_values
+ *		Get the non-NULL elements of an array as a C array.
+ *
+ * Multi-dimensional arrays are treated as a flat list of elements. Sets
+ * has_null if there are any NULL elements. Without NULLs the array data
+ * is returned directly, without copying.
+ */
+HASHSET_ELEMENT_TYPE *
+HASHSET_NAME(array_values)(ArrayType *array, int *nvalues, bool *has_null)
+{
+	int		i;
+	int		nitems;
+	HASHSET_ELEMENT_TYPE  *data;
+	HASHSET_ELEMENT_TYPE  *values;
+	bits8  *bitmap;
+
+	if (ARR_ELEMTYPE(array) != HASHSET_ELEMENT_OID)
+		elog(ERROR, "expected %s[] array", HASHSET_ELEMENT_NAME);
+
+	nitems = ArrayGetNItems(ARR_NDIM(array), ARR_DIMS(array));
+	data = (HASHSET_ELEMENT_TYPE *) ARR_DATA_PTR(array);
+
+	*has_null = false;
+
+	if (!ARR_HASNULL(array))
+	{
+		*nvalues = nitems;
+		return data;
+	}
+
+	/* The data contain only the non-NULL elements */
+	bitmap = ARR_NULLBITMAP(array);
+	values = (HASHSET_ELEMENT_TYPE *) palloc(Max(nitems, 1) * sizeof(HASHSET_ELEMENT_TYPE));
+
+	*nvalues = 0;
+	for (i = 0; i < nitems; i++)
+	{
+		if (bitmap[i / 8] & (1 << (i % 8)))
+			values[(*nvalues)++] = *data++;
+		else
+			*has_null = true;
+	}
+
+	return values;
+}
+
+/*
+ * values_to_array
+ *		Construct an SQL array from a C array of elements, with the NULL
+ *		element (if any) at the end.
+ */
+Datum
+HASHSET_NAME(values_to_array)(FunctionCallInfo fcinfo,
+							  HASHSET_ELEMENT_TYPE *values, int nvalues,
+							  bool null_element)
+{
+	ArrayBuildState *astate = NULL;
+	int		 i;
+
+	for (i = 0; i < nvalues; i++)
+	{
+		/* Stash away this field */
+		astate = accumArrayResult(astate,
+								  HASHSET_ELEMENT_GET_DATUM(values[i]),
+								  false,
+								  HASHSET_ELEMENT_OID,
+								  CurrentMemoryContext);
+	}
+
+	if (null_element)
+	{
+		astate = accumArrayResult(astate,
+								  (Datum) 0,
+								  true,
+								  HASHSET_ELEMENT_OID,
+								  CurrentMemoryContext);
+	}
+
+	PG_RETURN_DATUM(makeArrayResult(astate,
+					CurrentMemoryContext));
+}
+
+/*
+ * The GIN support, the selectivity estimators and the typanalyze function
+ * are shared by all the hashset types (the keys and statistics are
+ * elements of the element type), these just pass the element type.
+ */
+Datum
+HASHSET_NAME(gin_extract_value)(PG_FUNCTION_ARGS)
+{
+	return hashset_gin_extract_value(fcinfo, HASHSET_ELEMENT_OID);
+}
+
+Datum
+HASHSET_NAME(gin_extract_query)(PG_FUNCTION_ARGS)
+{
+	return hashset_gin_extract_query(fcinfo, HASHSET_ELEMENT_OID);
+}
+
+Datum
+HASHSET_NAME(sel)(PG_FUNCTION_ARGS)
+{
+	return hashset_sel(fcinfo, HASHSET_ELEMENT_OID);
+}
+
+Datum
+HASHSET_NAME(joinsel)(PG_FUNCTION_ARGS)
+{
+	return hashset_joinsel(fcinfo, HASHSET_ELEMENT_OID);
+}
+
+Datum
+HASHSET_NAME(typanalyze)(PG_FUNCTION_ARGS)
+{
+	return hashset_typanalyze(fcinfo, HASHSET_ELEMENT_OID);
+}
+
+#undef HASHSET_PREFIX
+#undef HASHSET_ELEMENT_TYPE
+#undef HASHSET_ELEMENT_OID
+#undef HASHSET_ELEMENT_NAME
+#undef HASHSET_ELEMENT_MIN
+#undef HASHSET_ELEMENT_MAX
+#undef HASHSET_GETARG_ELEMENT
+#undef HASHSET_ELEMENT_GET_DATUM
+#undef HASHSET_SEND_ELEMENT
+#undef HASHSET_RECV_ELEMENT
+#undef HASHSET_LEGACY_FORMAT
+#undef HASHSET_MAKE_NAME_
+#undef HASHSET_MAKE_NAME
+#undef HASHSET_NAME
+#undef HASHSET_TYPE
+#undef HASHSET_EXPANDED
+#undef HASHSET_ITERATOR
+#undef PG_GETARG_HASHSET
+#undef PG_GETARG_HASHSET_ANY
+#undef PG_GETARG_HASHSET_CACHED
+#undef PG_GETARG_HASHSET_TABLE
+#undef PG_GETARG_HASHSET_EXPANDED
+#undef PG_RETURN_HASHSET_EXPANDED
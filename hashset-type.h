@@ -0,0 +1,1843 @@
+/*
+ * hashset-type.h
+ *
+ * Template for the hashset core, generating the hash table and the compact
+ * format for one integer element type (in the style of lib/simplehash.h).
+ * The int2hashset, int4hashset and int8hashset types are all generated
+ * from this, so they share the hash table kernels (hashset-kernels.h), the
+ * compact format, the expanded representation and so on.
+ *
+ * Parameters (all of them are undefined at the end):
+ *
+ *	HASHSET_PREFIX - prefix of the type and function names (int4hashset)
+ *	HASHSET_ELEMENT_TYPE - C type of the elements (int32)
+ *	HASHSET_ELEMENT_MIN - smallest value of the element type (PG_INT32_MIN)
+ *	HASHSET_USE_CONTAINERS - defined if compact sets may use the container
+ *		encoding (see hashset-containers.c, works for 32-bit elements only)
+ *	HASHSET_LEGACY_FORMAT - defined if sets in the format version 0 (the
+ *		int4hashset layout of release 0.0.1, int4hashset_legacy_t) get
+ *		converted when read
+ *	HASHSET_DECLARE - declare the types, functions and the iterator
+ *	HASHSET_DEFINE - define the functions (hashset.c)
+ *	HASHSET_EXPANDED_MAGIC - ID of the expanded objects (for DEFINE)
+ *
+ * The generated names are <prefix>_t for the set, <prefix>_expanded_t for
+ * the expanded object, <prefix>_iterator_t for the iterator, and <prefix>_
+ * followed by the operation for the functions (int4hashset_add_element).
+ *
+ * Elements are hashed folded into 32 bits, so that values of the smaller
+ * types hash the same way in all the types. The values of the hash table
+ * follow the control bytes, aligned for the element type.
+ */
+
+#define HASHSET_MAKE_NAME_(prefix, name) prefix##_##name
+#define HASHSET_MAKE_NAME(prefix, name) HASHSET_MAKE_NAME_(prefix, name)
+#define HASHSET_NAME(name) HASHSET_MAKE_NAME(HASHSET_PREFIX, name)
+
+#define HASHSET_TYPE		HASHSET_NAME(t)
+#define HASHSET_EXPANDED	HASHSET_NAME(expanded_t)
+#define HASHSET_ITERATOR	HASHSET_NAME(iterator_t)
+
+/* The values of the hash table, after the control bytes */
+#define HASHSET_VALUES_OFFSET(capacity) \
+	TYPEALIGN(sizeof(HASHSET_ELEMENT_TYPE), offsetof(HASHSET_TYPE, data) + (capacity))
+#define HASHSET_GET_VALUES(set) \
+	((HASHSET_ELEMENT_TYPE *) ((char *) (set) + HASHSET_VALUES_OFFSET((set)->capacity)))
+
+/* The element folded into 32 bits, for the hash functions */
+#define HASHSET_ELEMENT_FOLD(value) \
+	((sizeof(HASHSET_ELEMENT_TYPE) > sizeof(uint32)) ? \
+	 (uint32) (value) ^ (uint32) ((uint64) (value) >> 32) : \
+	 (uint32) (int32) (value))
+
+/*
+ * Elements are mapped to uint64 in an order-preserving way (for the compact
+ * format), so that the deltas between sorted elements are never negative.
+ */
+#define HASHSET_ELEMENT_BIAS(value) \
+	((uint64) (value) - (uint64) (HASHSET_ELEMENT_MIN))
+#define HASHSET_ELEMENT_UNBIAS(value) \
+	((HASHSET_ELEMENT_TYPE) ((value) + (uint64) (HASHSET_ELEMENT_MIN)))
+
+#ifdef HASHSET_DECLARE
+
+typedef struct HASHSET_TYPE {
+	int32		vl_len_;		/* Varlena header (do not touch directly!) */
+	int32		flags;			/* Format version and flags (see hashset.h) */
+	int32		capacity;		/* Max number of element we have space for */
+	int32		nelements;		/* Number of items added to the hashset */
+	int32		hashfn_id;		/* ID of the hash function used */
+	float4		load_factor;	/* Load factor before triggering resize */
+	float4		growth_factor;	/* Growth factor when resizing the hashset */
+	int32		ncollisions;	/* Number of collisions */
+	int32		max_collisions;	/* Maximum collisions for a single element */
+	int32		ndeleted;		/* Number of tombstones (hash table only) */
+	uint32		hash;			/* Sum of HASHSET_ELEMENT_HASH of elements */
+	bool		null_element;	/* Indicates if null is present in hashset */
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} HASHSET_TYPE;
+
+/*
+ * Expanded (read/write) representation of the hashset.
+ *
+ * The expanded object simply wraps a regular hashset, allocated in the
+ * object's own memory context. This allows functions like hashset_add()
+ * to modify the set in place when they receive a read/write pointer,
+ * instead of copying the whole set on every call. The set gets flattened
+ * only when it needs to be stored (or sent somewhere).
+ */
+typedef struct HASHSET_EXPANDED {
+	ExpandedObjectHeader hdr;	/* Standard header, must be first */
+	int				magic;		/* HASHSET_EXPANDED_MAGIC */
+	HASHSET_TYPE   *set;		/* The hashset, in the object's context */
+	HASHSET_TYPE   *flat;		/* Compact image, between get_flat_size and
+								 * flatten_into (NULL otherwise) */
+} HASHSET_EXPANDED;
+
+/*
+ * Iterator over the elements of a hashset, in either format. Elements of
+ * a compact hashset are returned in ascending order, elements of a hash
+ * table in the order of slots (a group at a time, skipping empty slots
+ * using the bitmask of occupied slots).
+ */
+typedef struct HASHSET_ITERATOR {
+	HASHSET_TYPE   *set;
+	int32			position;	/* First slot of the next group (hash table) */
+	int32			group;		/* First slot of the current group (hash table) */
+	uint32			match;		/* Occupied slots of the current group not
+								 * returned yet (hash table) */
+	int32			nremaining;	/* Elements left to decode (compact) */
+	uint64			prev;		/* Last decoded value, biased (compact) */
+	const char	   *ptr;		/* Next byte to decode (compact) */
+#ifdef HASHSET_USE_CONTAINERS
+	uint32			nchunks;	/* Number of chunks (containers) */
+	uint32			chunkno;	/* Next chunk to load (containers) */
+	hashset_chunk_t	chunk;		/* Current chunk (containers) */
+	uint32			index;		/* Next array element, run or bitmap word of
+								 * the current chunk (containers) */
+	uint32			offset;		/* Offset in the current run (containers) */
+	uint64			word;		/* Bits of the current bitmap word not
+								 * returned yet (containers) */
+#endif
+} HASHSET_ITERATOR;
+
+HASHSET_TYPE *HASHSET_NAME(allocate)(int capacity, float4 load_factor, float4 growth_factor, int hashfn_id);
+HASHSET_TYPE *HASHSET_NAME(resize)(HASHSET_TYPE *set);
+HASHSET_TYPE *HASHSET_NAME(add_element)(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE value);
+HASHSET_TYPE *HASHSET_NAME(add_set)(HASHSET_TYPE *set, HASHSET_TYPE *src);
+HASHSET_TYPE *HASHSET_NAME(reserve)(HASHSET_TYPE *set, int64 nelements);
+HASHSET_TYPE *HASHSET_NAME(merge)(HASHSET_TYPE *set, HASHSET_TYPE *src);
+HASHSET_TYPE *HASHSET_NAME(add_values)(HASHSET_TYPE *set, const HASHSET_ELEMENT_TYPE *values, int nvalues);
+HASHSET_TYPE *HASHSET_NAME(remove_element)(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE value);
+HASHSET_TYPE *HASHSET_NAME(remove_values)(HASHSET_TYPE *set, const HASHSET_ELEMENT_TYPE *values, int nvalues);
+HASHSET_TYPE *HASHSET_NAME(shrink)(HASHSET_TYPE *set, int64 nelements);
+int HASHSET_NAME(filter)(HASHSET_TYPE *set, HASHSET_TYPE *src, bool found, HASHSET_ELEMENT_TYPE *result);
+HASHSET_TYPE *HASHSET_NAME(filter_aligned)(HASHSET_TYPE *result, HASHSET_TYPE *set, HASHSET_TYPE *src, bool found);
+bool HASHSET_NAME(is_aligned)(HASHSET_TYPE *set, HASHSET_TYPE *src);
+bool HASHSET_NAME(contains_element)(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE value);
+bool HASHSET_NAME(contains_set)(HASHSET_TYPE *set, HASHSET_TYPE *sub);
+bool HASHSET_NAME(intersects)(HASHSET_TYPE *a, HASHSET_TYPE *b);
+void HASHSET_NAME(contains_values)(HASHSET_TYPE *set, const HASHSET_ELEMENT_TYPE *values, int nvalues, bool *result);
+HASHSET_ELEMENT_TYPE *HASHSET_NAME(extract_sorted_elements)(HASHSET_TYPE *set);
+uint64 HASHSET_NAME(canonical_hash)(HASHSET_TYPE *set, uint64 seed);
+int HASHSET_NAME(compare)(HASHSET_TYPE *a, HASHSET_TYPE *b);
+HASHSET_TYPE *HASHSET_NAME(copy)(HASHSET_TYPE *src);
+uint32 HASHSET_NAME(hash_element)(int hashfn_id, HASHSET_ELEMENT_TYPE value);
+HASHSET_TYPE *HASHSET_NAME(compact)(HASHSET_TYPE *set);
+HASHSET_TYPE *HASHSET_NAME(compact_values)(HASHSET_ELEMENT_TYPE *values, int nvalues, int capacity, float4 load_factor, float4 growth_factor, int hashfn_id, bool null_element);
+HASHSET_TYPE *HASHSET_NAME(rebuild)(HASHSET_TYPE *set);
+HASHSET_TYPE *HASHSET_NAME(getarg_cached)(FunctionCallInfo fcinfo, int argno);
+HASHSET_TYPE *HASHSET_NAME(getarg_table)(FunctionCallInfo fcinfo, int argno);
+
+HASHSET_EXPANDED *HASHSET_NAME(expanded_allocate)(int capacity, float4 load_factor, float4 growth_factor, int hashfn_id, MemoryContext parentcontext);
+Datum HASHSET_NAME(expand)(Datum datum, MemoryContext parentcontext);
+HASHSET_EXPANDED *HASHSET_NAME(datum_get_expanded)(Datum d);
+HASHSET_TYPE *HASHSET_NAME(datum_get)(Datum d);
+HASHSET_TYPE *HASHSET_NAME(datum_get_any)(Datum d);
+
+/* Defined with the SQL functions (hashset-type-api.h) */
+HASHSET_ELEMENT_TYPE *HASHSET_NAME(array_values)(ArrayType *array, int *nvalues, bool *has_null);
+Datum HASHSET_NAME(values_to_array)(FunctionCallInfo fcinfo, HASHSET_ELEMENT_TYPE *values, int nvalues, bool null_element);
+
+static inline void
+HASHSET_NAME(iterator_init)(HASHSET_ITERATOR *iter, HASHSET_TYPE *set)
+{
+	iter->set = set;
+	iter->position = 0;
+	iter->group = 0;
+	iter->match = 0;
+	iter->nremaining = set->nelements;
+	iter->prev = 0;
+	iter->ptr = set->data;
+
+#ifdef HASHSET_USE_CONTAINERS
+	if (HASHSET_IS_CONTAINERS(set))
+	{
+		iter->nchunks = hashset_get_nchunks(set->data);
+		iter->chunkno = 0;
+		iter->ptr = HASHSET_CONTAINERS(set, iter->nchunks);
+
+		/* an empty chunk, so that the first call loads the first one */
+		memset(&iter->chunk, 0, sizeof(hashset_chunk_t));
+		iter->chunk.type = HASHSET_CONTAINER_ARRAY;
+		iter->index = 0;
+		iter->offset = 0;
+		iter->word = 0;
+	}
+#endif
+}
+
+#ifdef HASHSET_USE_CONTAINERS
+/*
+ * Decode the next low 16 bits from the current chunk of the container
+ * encoding, moving to the next chunk when this one is exhausted.
+ */
+static inline void
+HASHSET_NAME(iterator_next_low)(HASHSET_ITERATOR *iter, uint32 *low)
+{
+	for (;;)
+	{
+		const char *container = iter->ptr + iter->chunk.offset;
+
+		switch (iter->chunk.type)
+		{
+			case HASHSET_CONTAINER_ARRAY:
+				if (iter->index < iter->chunk.count)
+				{
+					*low = hashset_get_uint16(container, iter->index++);
+					return;
+				}
+				break;
+
+			case HASHSET_CONTAINER_RUNS:
+				while (iter->index < iter->chunk.count)
+				{
+					uint32	start = hashset_get_uint16(container, 2 * iter->index);
+					uint32	length = hashset_get_uint16(container, 2 * iter->index + 1);
+
+					if (iter->offset <= length)
+					{
+						*low = start + iter->offset++;
+						return;
+					}
+
+					iter->index++;
+					iter->offset = 0;
+				}
+				break;
+
+			case HASHSET_CONTAINER_BITMAP:
+				while (iter->word == 0 && iter->index < HASHSET_BITMAP_WORDS)
+					iter->word = hashset_get_word(container, iter->index++);
+
+				if (iter->word != 0)
+				{
+					*low = (iter->index - 1) * 64 +
+						pg_rightmost_one_pos64(iter->word);
+					iter->word &= (iter->word - 1);
+					return;
+				}
+				break;
+		}
+
+		/* the chunk is exhausted, there has to be another one */
+		Assert(iter->chunkno < iter->nchunks);
+
+		hashset_get_chunk(iter->set->data, iter->chunkno++, &iter->chunk);
+		iter->index = 0;
+		iter->offset = 0;
+		iter->word = 0;
+	}
+}
+#endif
+
+static inline bool
+HASHSET_NAME(iterator_next)(HASHSET_ITERATOR *iter, HASHSET_ELEMENT_TYPE *value)
+{
+	HASHSET_TYPE   *set = iter->set;
+
+	if (HASHSET_IS_COMPACT(set))
+	{
+		uint64	delta;
+
+		if (iter->nremaining == 0)
+			return false;
+
+		iter->nremaining--;
+
+#ifdef HASHSET_USE_CONTAINERS
+		if (HASHSET_IS_CONTAINERS(set))
+		{
+			uint32	low;
+
+			HASHSET_NAME(iterator_next_low)(iter, &low);
+
+			*value = HASHSET_UNBIAS(((uint32) iter->chunk.key << 16) | low);
+			return true;
+		}
+#endif
+
+		iter->ptr = hashset_varint_decode(iter->ptr, &delta);
+		iter->prev += delta;
+
+		*value = HASHSET_ELEMENT_UNBIAS(iter->prev);
+		return true;
+	}
+	else
+	{
+		int		i;
+
+		while (iter->match == 0)
+		{
+			if (iter->position >= set->capacity)
+				return false;
+
+			iter->group = iter->position;
+			iter->match = hashset_group_match_full(HASHSET_GET_CTRL(set) +
+												   iter->position);
+			iter->position += HASHSET_GROUP_SIZE;
+		}
+
+		i = pg_rightmost_one_pos32(iter->match);
+		iter->match &= (iter->match - 1);
+
+		*value = HASHSET_GET_VALUES(set)[iter->group + i];
+		return true;
+	}
+}
+
+#endif							/* HASHSET_DECLARE */
+
+#ifdef HASHSET_DEFINE
+
+static HASHSET_TYPE *HASHSET_NAME(resize_to)(HASHSET_TYPE *set, int capacity);
+static HASHSET_TYPE *HASHSET_NAME(maybe_shrink)(HASHSET_TYPE *set);
+static HASHSET_TYPE *HASHSET_NAME(getarg)(FunctionCallInfo fcinfo, int argno, bool rebuild);
+static HASHSET_TYPE *HASHSET_NAME(compact_encode)(HASHSET_TYPE *header, const HASHSET_ELEMENT_TYPE *values, int nvalues);
+static int HASHSET_NAME(filter_merge)(HASHSET_TYPE *set, const HASHSET_ELEMENT_TYPE *values, int nvalues, bool found, HASHSET_ELEMENT_TYPE *result);
+static bool HASHSET_NAME(probe_any)(HASHSET_TYPE *set, HASHSET_TYPE *src, bool found);
+static int HASHSET_NAME(element_cmp)(const void *a, const void *b);
+static Size HASHSET_NAME(get_flat_size)(ExpandedObjectHeader *eohptr);
+static void HASHSET_NAME(flatten_into)(ExpandedObjectHeader *eohptr,
+									   void *result, Size allocated_size);
+
+static const ExpandedObjectMethods HASHSET_NAME(expanded_methods) =
+{
+	HASHSET_NAME(get_flat_size),
+	HASHSET_NAME(flatten_into)
+};
+
+/* Insert / lookup kernels for each of the hash functions */
+#define HASHSET_KERNEL_SUFFIX jenkins
+#define HASHSET_KERNEL_HASH(value) HASHSET_HASH_JENKINS(HASHSET_ELEMENT_FOLD(value))
+#include "hashset-kernels.h"
+
+#define HASHSET_KERNEL_SUFFIX murmur
+#define HASHSET_KERNEL_HASH(value) HASHSET_HASH_MURMUR(HASHSET_ELEMENT_FOLD(value))
+#include "hashset-kernels.h"
+
+#define HASHSET_KERNEL_SUFFIX naive
+#define HASHSET_KERNEL_HASH(value) HASHSET_HASH_NAIVE(HASHSET_ELEMENT_FOLD(value))
+#include "hashset-kernels.h"
+
+HASHSET_TYPE *
+HASHSET_NAME(allocate)(
+	int capacity,
+	float4 load_factor,
+	float4 growth_factor,
+	int hashfn_id
+)
+{
+	Size			len;
+	HASHSET_TYPE   *set;
+	char		   *ptr;
+
+	capacity = hashset_round_capacity(capacity, sizeof(HASHSET_ELEMENT_TYPE));
+
+	/* control bytes, then the (aligned) values */
+	len = HASHSET_VALUES_OFFSET(capacity);
+	len += capacity * sizeof(HASHSET_ELEMENT_TYPE);
+
+	ptr = palloc0(len);
+	SET_VARSIZE(ptr, len);
+
+	set = (HASHSET_TYPE *) ptr;
+
+	set->flags = HASHSET_FORMAT_FLAGS;
+	set->capacity = capacity;
+	set->nelements = 0;
+	set->hashfn_id = hashfn_id;
+	set->load_factor = load_factor;
+	set->growth_factor = growth_factor;
+	set->ncollisions = 0;
+	set->max_collisions = 0;
+	set->ndeleted = 0;
+	set->hash = 0;
+	set->null_element = false; /* No null element initially */
+
+	memset(HASHSET_GET_CTRL(set), HASHSET_CTRL_EMPTY, capacity);
+
+	return set;
+}
+
+HASHSET_TYPE *
+HASHSET_NAME(resize)(HASHSET_TYPE * set)
+{
+	int				new_capacity;
+
+	/*
+	 * If most of the used slots are tombstones, just rebuild the table with
+	 * the same capacity - there's enough space for the live elements.
+	 */
+	if (set->ndeleted > 0 &&
+		set->nelements < set->capacity * set->load_factor / 2)
+		return HASHSET_NAME(resize_to)(set, set->capacity);
+
+	new_capacity = (int)(set->capacity * set->growth_factor);
+
+	/*
+	 * If growth factor is too small, new capacity might remain the same as
+	 * the old capacity. This can lead to an infinite loop in resizing.
+	 * To prevent this, we manually increment the capacity by 1 if new capacity
+	 * equals the old capacity.
+	 */
+	if (new_capacity == set->capacity)
+		new_capacity = set->capacity + 1;
+
+	return HASHSET_NAME(resize_to)(set, new_capacity);
+}
+
+/*
+ * reserve
+ *		Make sure the hash table can hold nelements without resizing.
+ *
+ * Operations adding many elements at once (with a known upper bound on the
+ * final number of elements) use this to resize the table at most once,
+ * instead of growing it step by step while inserting.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(reserve)(HASHSET_TYPE *set, int64 nelements)
+{
+	int64	capacity;
+
+	/* The last insert happens with nelements-1 elements in the table */
+	if (nelements == 0 || nelements - 1 < set->capacity * set->load_factor)
+		return set;
+
+	capacity = (int64) (nelements / set->load_factor) + 1;
+
+	return HASHSET_NAME(resize_to)(set, (int) Min(capacity, PG_INT32_MAX));
+}
+
+/*
+ * merge
+ *		Add all elements of src (in any format) to the hash table.
+ *
+ * Unlike add_set, this resizes the table only once (for the combined
+ * number of elements), and merges the NULL element too.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(merge)(HASHSET_TYPE *set, HASHSET_TYPE *src)
+{
+	set = HASHSET_NAME(reserve)(set, (int64) set->nelements + src->nelements);
+	set = HASHSET_NAME(add_set)(set, src);
+
+	if (src->null_element)
+		set->null_element = true;
+
+	return set;
+}
+
+/*
+ * resize_to
+ *		Move the elements to a new hash table with (at least) the capacity.
+ */
+static HASHSET_TYPE *
+HASHSET_NAME(resize_to)(HASHSET_TYPE *set, int new_capacity)
+{
+	HASHSET_TYPE   *new;
+	MemoryContext	oldcontext;
+
+	/* (allocate rounds this up to a power of two) */
+
+	/*
+	 * Allocate the new hashset in the same memory context as the current
+	 * one, so that a set owned by an expanded object (or an aggregate state)
+	 * stays in its context. This also allows us to free the old set.
+	 */
+	oldcontext = MemoryContextSwitchTo(GetMemoryChunkContext(set));
+
+	new = HASHSET_NAME(allocate)(
+		new_capacity,
+		set->load_factor,
+		set->growth_factor,
+		set->hashfn_id
+	);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	new = HASHSET_NAME(add_set)(new, set);
+
+	new->null_element = set->null_element;
+
+	pfree(set);
+
+	return new;
+}
+
+/*
+ * add_element
+ *		Add the value to the hashset (resizing it if needed).
+ *
+ * The following functions only dispatch to the kernel for the hash function
+ * of the set, see hashset-kernels.h.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(add_element)(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE value)
+{
+	switch (set->hashfn_id)
+	{
+		case JENKINS_LOOKUP3_HASHFN_ID:
+			return HASHSET_NAME(insert_jenkins)(set, value);
+		case MURMURHASH32_HASHFN_ID:
+			return HASHSET_NAME(insert_murmur)(set, value);
+		case NAIVE_HASHFN_ID:
+			return HASHSET_NAME(insert_naive)(set, value);
+	}
+
+	hashset_invalid_hashfn(set->hashfn_id);
+	pg_unreachable();
+}
+
+/*
+ * add_set
+ *		Add all elements of src (in any format) to the hashset.
+ *
+ * Does not merge the NULL element, callers handle that.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(add_set)(HASHSET_TYPE *set, HASHSET_TYPE *src)
+{
+	switch (set->hashfn_id)
+	{
+		case JENKINS_LOOKUP3_HASHFN_ID:
+			return HASHSET_NAME(add_set_jenkins)(set, src);
+		case MURMURHASH32_HASHFN_ID:
+			return HASHSET_NAME(add_set_murmur)(set, src);
+		case NAIVE_HASHFN_ID:
+			return HASHSET_NAME(add_set_naive)(set, src);
+	}
+
+	hashset_invalid_hashfn(set->hashfn_id);
+	pg_unreachable();
+}
+
+/*
+ * add_values
+ *		Add an array of values to the hashset.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(add_values)(HASHSET_TYPE *set, const HASHSET_ELEMENT_TYPE *values,
+						 int nvalues)
+{
+	switch (set->hashfn_id)
+	{
+		case JENKINS_LOOKUP3_HASHFN_ID:
+			return HASHSET_NAME(add_values_jenkins)(set, values, nvalues);
+		case MURMURHASH32_HASHFN_ID:
+			return HASHSET_NAME(add_values_murmur)(set, values, nvalues);
+		case NAIVE_HASHFN_ID:
+			return HASHSET_NAME(add_values_naive)(set, values, nvalues);
+	}
+
+	hashset_invalid_hashfn(set->hashfn_id);
+	pg_unreachable();
+}
+
+/*
+ * remove_element
+ *		Remove the value from the hashset (shrinking it if needed).
+ */
+HASHSET_TYPE *
+HASHSET_NAME(remove_element)(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE value)
+{
+	bool	removed = false;
+	uint32	folded = HASHSET_ELEMENT_FOLD(value);
+
+	switch (set->hashfn_id)
+	{
+		case JENKINS_LOOKUP3_HASHFN_ID:
+			removed = HASHSET_NAME(remove_hash_jenkins)(set, value,
+														HASHSET_HASH_JENKINS(folded));
+			break;
+		case MURMURHASH32_HASHFN_ID:
+			removed = HASHSET_NAME(remove_hash_murmur)(set, value,
+													   HASHSET_HASH_MURMUR(folded));
+			break;
+		case NAIVE_HASHFN_ID:
+			removed = HASHSET_NAME(remove_hash_naive)(set, value,
+													  HASHSET_HASH_NAIVE(folded));
+			break;
+		default:
+			hashset_invalid_hashfn(set->hashfn_id);
+	}
+
+	return removed ? HASHSET_NAME(maybe_shrink)(set) : set;
+}
+
+/*
+ * remove_values
+ *		Remove an array of values from the hashset (shrinking it if needed).
+ *
+ * The table is shrunk only once, after removing all the values.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(remove_values)(HASHSET_TYPE *set, const HASHSET_ELEMENT_TYPE *values,
+							int nvalues)
+{
+	int		nremoved = 0;
+
+	switch (set->hashfn_id)
+	{
+		case JENKINS_LOOKUP3_HASHFN_ID:
+			nremoved = HASHSET_NAME(remove_values_jenkins)(set, values, nvalues);
+			break;
+		case MURMURHASH32_HASHFN_ID:
+			nremoved = HASHSET_NAME(remove_values_murmur)(set, values, nvalues);
+			break;
+		case NAIVE_HASHFN_ID:
+			nremoved = HASHSET_NAME(remove_values_naive)(set, values, nvalues);
+			break;
+		default:
+			hashset_invalid_hashfn(set->hashfn_id);
+	}
+
+	return (nremoved > 0) ? HASHSET_NAME(maybe_shrink)(set) : set;
+}
+
+/*
+ * maybe_shrink
+ *		Shrink the hash table after removals, if it's mostly empty.
+ *
+ * The table is shrunk once the elements take less than a quarter of the
+ * space allowed by the load factor, to a capacity for twice the elements.
+ * That leaves room for new elements, so that alternating removals and
+ * inserts don't keep resizing the table back and forth.
+ */
+static HASHSET_TYPE *
+HASHSET_NAME(maybe_shrink)(HASHSET_TYPE *set)
+{
+	if (set->capacity > HASHSET_GROUP_SIZE &&
+		set->nelements < set->capacity * set->load_factor / 4)
+		return HASHSET_NAME(shrink)(set, (int64) set->nelements * 2);
+
+	return set;
+}
+
+/*
+ * shrink
+ *		Rebuild the hash table with the smallest capacity for nelements.
+ *
+ * The table gets rebuilt (dropping the tombstones) unless that would not
+ * make it any smaller and there are no tombstones. Never drops below the
+ * current number of elements.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(shrink)(HASHSET_TYPE *set, int64 nelements)
+{
+	int		capacity;
+
+	Assert(!HASHSET_IS_COMPACT(set));
+
+	nelements = Max(nelements, set->nelements);
+
+	capacity = (nelements > 0) ? (int) (nelements / set->load_factor) + 1 : 0;
+	capacity = hashset_round_capacity(capacity, sizeof(HASHSET_ELEMENT_TYPE));
+
+	if (capacity >= set->capacity && set->ndeleted == 0)
+		return set;
+
+	return HASHSET_NAME(resize_to)(set, Min(capacity, set->capacity));
+}
+
+/*
+ * filter
+ *		Collect elements of src that are (found = true) or are not (found =
+ *		false) contained in the hashset.
+ *
+ * Both sets may be in any format. The result array needs space for all
+ * elements of src, returns the number of elements written to it.
+ *
+ * When the hashset is compact, we don't rebuild the hash table if we can
+ * get the elements of src sorted cheaply (it's compact too, or not larger
+ * than the hashset) - a merge of the two sorted lists is cheaper then. The
+ * container encoding is never rebuilt, the lookups use the containers.
+ */
+int
+HASHSET_NAME(filter)(HASHSET_TYPE *set, HASHSET_TYPE *src, bool found,
+					 HASHSET_ELEMENT_TYPE *result)
+{
+#ifdef HASHSET_USE_CONTAINERS
+	/* the containers can be probed directly */
+	if (HASHSET_IS_CONTAINERS(set))
+		return hashset_containers_filter(set, src, found, result);
+#endif
+
+	if (HASHSET_IS_COMPACT(set))
+	{
+		HASHSET_TYPE		   *table;
+		HASHSET_ELEMENT_TYPE   *values;
+		int						nresult;
+
+		if (HASHSET_IS_COMPACT(src) || src->nelements <= set->nelements)
+		{
+			values = HASHSET_NAME(extract_sorted_elements)(src);
+			nresult = HASHSET_NAME(filter_merge)(set, values, src->nelements,
+												 found, result);
+			pfree(values);
+
+			return nresult;
+		}
+
+		table = HASHSET_NAME(rebuild)(set);
+		nresult = HASHSET_NAME(filter)(table, src, found, result);
+		pfree(table);
+
+		return nresult;
+	}
+
+	switch (set->hashfn_id)
+	{
+		case JENKINS_LOOKUP3_HASHFN_ID:
+			return HASHSET_NAME(filter_jenkins)(set, src, found, result);
+		case MURMURHASH32_HASHFN_ID:
+			return HASHSET_NAME(filter_murmur)(set, src, found, result);
+		case NAIVE_HASHFN_ID:
+			return HASHSET_NAME(filter_naive)(set, src, found, result);
+	}
+
+	hashset_invalid_hashfn(set->hashfn_id);
+	pg_unreachable();
+}
+
+/*
+ * filter_merge
+ *		Filter sorted values using a compact hashset.
+ *
+ * The elements of a compact hashset are sorted, so we walk them along with
+ * the values instead of looking up each value.
+ */
+static int
+HASHSET_NAME(filter_merge)(HASHSET_TYPE *set, const HASHSET_ELEMENT_TYPE *values,
+						   int nvalues, bool found, HASHSET_ELEMENT_TYPE *result)
+{
+	HASHSET_ITERATOR		iter;
+	HASHSET_ELEMENT_TYPE	element = 0;
+	bool					more;
+	int						nresult = 0;
+	int						i;
+
+	HASHSET_NAME(iterator_init)(&iter, set);
+	more = HASHSET_NAME(iterator_next)(&iter, &element);
+
+	for (i = 0; i < nvalues; i++)
+	{
+		while (more && element < values[i])
+			more = HASHSET_NAME(iterator_next)(&iter, &element);
+
+		/* No elements left, so none of the remaining values can match */
+		if (!more && found)
+			break;
+
+		if ((more && element == values[i]) == found)
+			result[nresult++] = values[i];
+	}
+
+	return nresult;
+}
+
+/*
+ * is_aligned
+ *		Check if filter_aligned() can be used for the hashsets.
+ *
+ * Both have to be hash tables using the same hash function, so that the
+ * hash calculated for src can be used to look up the element in set, and
+ * then to place it in the result (with the same capacity as src).
+ */
+bool
+HASHSET_NAME(is_aligned)(HASHSET_TYPE *set, HASHSET_TYPE *src)
+{
+	return (!HASHSET_IS_COMPACT(set) && !HASHSET_IS_COMPACT(src) &&
+			src->capacity > 0 &&
+			set->hashfn_id == src->hashfn_id);
+}
+
+/*
+ * filter_aligned
+ *		Copy elements of src that are (found = true) or are not (found =
+ *		false) contained in the hashset into result.
+ *
+ * The result has to be an empty hash table with the same capacity and hash
+ * function as src, and the hashsets have to be aligned (see is_aligned).
+ */
+HASHSET_TYPE *
+HASHSET_NAME(filter_aligned)(HASHSET_TYPE *result, HASHSET_TYPE *set,
+							 HASHSET_TYPE *src, bool found)
+{
+	Assert(HASHSET_NAME(is_aligned)(set, src));
+
+	switch (src->hashfn_id)
+	{
+		case JENKINS_LOOKUP3_HASHFN_ID:
+			return HASHSET_NAME(filter_aligned_jenkins)(result, set, src, found);
+		case MURMURHASH32_HASHFN_ID:
+			return HASHSET_NAME(filter_aligned_murmur)(result, set, src, found);
+		case NAIVE_HASHFN_ID:
+			return HASHSET_NAME(filter_aligned_naive)(result, set, src, found);
+	}
+
+	hashset_invalid_hashfn(src->hashfn_id);
+	pg_unreachable();
+}
+
+/*
+ * contains_values
+ *		Check which of the values the hashset contains.
+ *
+ * Sets result[i] to true if the hashset contains values[i]. The lookups
+ * are done in batches, with prefetching. Compact hashsets are scanned for
+ * each value, so callers should rebuild the hash table first (except for
+ * the container encoding, which is searched directly).
+ */
+void
+HASHSET_NAME(contains_values)(HASHSET_TYPE *set, const HASHSET_ELEMENT_TYPE *values,
+							  int nvalues, bool *result)
+{
+	int		i;
+
+	if (HASHSET_IS_COMPACT(set))
+	{
+		for (i = 0; i < nvalues; i++)
+			result[i] = HASHSET_NAME(contains_element)(set, values[i]);
+
+		return;
+	}
+
+	switch (set->hashfn_id)
+	{
+		case JENKINS_LOOKUP3_HASHFN_ID:
+			HASHSET_NAME(lookup_values_jenkins)(set, values, nvalues, result);
+			return;
+		case MURMURHASH32_HASHFN_ID:
+			HASHSET_NAME(lookup_values_murmur)(set, values, nvalues, result);
+			return;
+		case NAIVE_HASHFN_ID:
+			HASHSET_NAME(lookup_values_naive)(set, values, nvalues, result);
+			return;
+	}
+
+	hashset_invalid_hashfn(set->hashfn_id);
+}
+
+/*
+ * contains_element
+ *		Check if the hashset contains the value.
+ *
+ * Compact hashsets are simply scanned. The elements are sorted, so we can
+ * stop at the first larger element. That's fine for a single lookup, but
+ * callers doing many lookups should rebuild the hash table first. The
+ * container encoding is searched directly (see hashset-containers.c).
+ */
+bool
+HASHSET_NAME(contains_element)(HASHSET_TYPE *set, HASHSET_ELEMENT_TYPE value)
+{
+#ifdef HASHSET_USE_CONTAINERS
+	if (HASHSET_IS_CONTAINERS(set))
+		return hashset_containers_contains(set, value);
+#endif
+
+	if (HASHSET_IS_COMPACT(set))
+	{
+		HASHSET_ITERATOR		iter;
+		HASHSET_ELEMENT_TYPE	element;
+
+		HASHSET_NAME(iterator_init)(&iter, set);
+		while (HASHSET_NAME(iterator_next)(&iter, &element))
+		{
+			if (element >= value)
+				return (element == value);
+		}
+
+		return false;
+	}
+
+	switch (set->hashfn_id)
+	{
+		case JENKINS_LOOKUP3_HASHFN_ID:
+			return HASHSET_NAME(lookup_jenkins)(set, value);
+		case MURMURHASH32_HASHFN_ID:
+			return HASHSET_NAME(lookup_murmur)(set, value);
+		case NAIVE_HASHFN_ID:
+			return HASHSET_NAME(lookup_naive)(set, value);
+	}
+
+	hashset_invalid_hashfn(set->hashfn_id);
+	pg_unreachable();
+}
+
+/*
+ * sorted_t
+ *		Elements of a hashset (in any format) in ascending order.
+ *
+ * Compact sets are decoded on the fly, hash tables are sorted up front.
+ */
+typedef struct HASHSET_NAME(sorted_t)
+{
+	HASHSET_ITERATOR		iter;
+	HASHSET_ELEMENT_TYPE   *values;		/* Sorted elements (hash table) */
+	int32					next;		/* Next element to return (hash table) */
+} HASHSET_NAME(sorted_t);
+
+static void
+HASHSET_NAME(sorted_init)(HASHSET_NAME(sorted_t) *sorted, HASHSET_TYPE *set)
+{
+	HASHSET_NAME(iterator_init)(&sorted->iter, set);
+	sorted->values = NULL;
+	sorted->next = 0;
+
+	if (!HASHSET_IS_COMPACT(set))
+		sorted->values = HASHSET_NAME(extract_sorted_elements)(set);
+}
+
+static inline bool
+HASHSET_NAME(sorted_next)(HASHSET_NAME(sorted_t) *sorted, HASHSET_ELEMENT_TYPE *value)
+{
+	if (sorted->values == NULL)
+		return HASHSET_NAME(iterator_next)(&sorted->iter, value);
+
+	if (sorted->next >= sorted->iter.set->nelements)
+		return false;
+
+	*value = sorted->values[sorted->next++];
+	return true;
+}
+
+static void
+HASHSET_NAME(sorted_free)(HASHSET_NAME(sorted_t) *sorted)
+{
+	if (sorted->values)
+		pfree(sorted->values);
+}
+
+/*
+ * probe_any
+ *		Look up elements of src in the hash table, until some element is
+ *		(found = true) or is not (found = false) in the table.
+ *
+ * The elements are looked up in batches, using the batched lookup kernels,
+ * so we stop at the end of the first batch with such an element.
+ */
+static bool
+HASHSET_NAME(probe_any)(HASHSET_TYPE *set, HASHSET_TYPE *src, bool found)
+{
+	HASHSET_ITERATOR		iter;
+	HASHSET_ELEMENT_TYPE	values[HASHSET_BATCH_SIZE];
+	bool					result[HASHSET_BATCH_SIZE];
+	int						nvalues;
+
+	Assert(!HASHSET_IS_COMPACT(set));
+
+	HASHSET_NAME(iterator_init)(&iter, src);
+
+	do
+	{
+		nvalues = 0;
+		while (nvalues < HASHSET_BATCH_SIZE &&
+			   HASHSET_NAME(iterator_next)(&iter, &values[nvalues]))
+			nvalues++;
+
+		HASHSET_NAME(contains_values)(set, values, nvalues, result);
+
+		for (int i = 0; i < nvalues; i++)
+		{
+			if (result[i] == found)
+				return true;
+		}
+	} while (nvalues == HASHSET_BATCH_SIZE);
+
+	return false;
+}
+
+/*
+ * contains_set
+ *		Check that all elements of "sub" are in the hashset.
+ *
+ * The NULL element is treated as a regular element, the same way as in the
+ * set operations. Both sets may be in any format. If "set" is a hash table,
+ * we look up the elements of "sub" and stop at the first one missing. If
+ * it's a compact set, both sets are walked in ascending order instead (so
+ * we never rebuild the hash table just to answer a single question).
+ */
+bool
+HASHSET_NAME(contains_set)(HASHSET_TYPE *set, HASHSET_TYPE *sub)
+{
+	HASHSET_NAME(sorted_t)	a;
+	HASHSET_NAME(sorted_t)	b;
+	HASHSET_ELEMENT_TYPE	va = 0;
+	HASHSET_ELEMENT_TYPE	vb;
+	bool					result = true;
+
+	if (sub->null_element && !set->null_element)
+		return false;
+
+	/* a larger set can't be a subset, and an empty set is always one */
+	if (sub->nelements > set->nelements)
+		return false;
+
+	if (sub->nelements == 0)
+		return true;
+
+	if (!HASHSET_IS_COMPACT(set))
+		return !HASHSET_NAME(probe_any)(set, sub, false);
+
+	HASHSET_NAME(sorted_init)(&a, set);
+	HASHSET_NAME(sorted_init)(&b, sub);
+
+	while (result && HASHSET_NAME(sorted_next)(&b, &vb))
+	{
+		bool	found;
+
+		/* skip the smaller elements of the (super)set */
+		while ((found = HASHSET_NAME(sorted_next)(&a, &va)) && va < vb)
+			;
+
+		result = (found && va == vb);
+	}
+
+	HASHSET_NAME(sorted_free)(&a);
+	HASHSET_NAME(sorted_free)(&b);
+
+	return result;
+}
+
+/*
+ * intersects
+ *		Check if the sets have an element (possibly the NULL one) in common.
+ *
+ * Both sets may be in any format. We look up elements in a hash table if
+ * there is one (the larger of the two, if both are hash tables), and stop
+ * at the first common element. Two compact sets are merged in ascending
+ * order instead.
+ */
+bool
+HASHSET_NAME(intersects)(HASHSET_TYPE *a, HASHSET_TYPE *b)
+{
+	HASHSET_NAME(sorted_t)	sa;
+	HASHSET_NAME(sorted_t)	sb;
+	HASHSET_ELEMENT_TYPE	va;
+	HASHSET_ELEMENT_TYPE	vb;
+	bool					has_a;
+	bool					has_b;
+	bool					result = false;
+
+	if (a->null_element && b->null_element)
+		return true;
+
+	if (a->nelements == 0 || b->nelements == 0)
+		return false;
+
+	/* make sure "b" is the hash table we probe (if there is one) */
+	if (!HASHSET_IS_COMPACT(a) &&
+		(HASHSET_IS_COMPACT(b) || a->nelements > b->nelements))
+	{
+		HASHSET_TYPE   *tmp = a;
+
+		a = b;
+		b = tmp;
+	}
+
+	if (!HASHSET_IS_COMPACT(b))
+		return HASHSET_NAME(probe_any)(b, a, true);
+
+	HASHSET_NAME(sorted_init)(&sa, a);
+	HASHSET_NAME(sorted_init)(&sb, b);
+
+	has_a = HASHSET_NAME(sorted_next)(&sa, &va);
+	has_b = HASHSET_NAME(sorted_next)(&sb, &vb);
+
+	while (has_a && has_b)
+	{
+		if (va == vb)
+		{
+			result = true;
+			break;
+		}
+
+		if (va < vb)
+			has_a = HASHSET_NAME(sorted_next)(&sa, &va);
+		else
+			has_b = HASHSET_NAME(sorted_next)(&sb, &vb);
+	}
+
+	HASHSET_NAME(sorted_free)(&sa);
+	HASHSET_NAME(sorted_free)(&sb);
+
+	return result;
+}
+
+HASHSET_ELEMENT_TYPE *
+HASHSET_NAME(extract_sorted_elements)(HASHSET_TYPE *set)
+{
+	HASHSET_ELEMENT_TYPE   *elements;
+	int32					nextracted = 0;
+	HASHSET_ITERATOR		iter;
+	HASHSET_ELEMENT_TYPE	value;
+
+	elements = palloc(set->nelements * sizeof(HASHSET_ELEMENT_TYPE));
+
+	/* Iterate through all elements */
+	HASHSET_NAME(iterator_init)(&iter, set);
+	while (HASHSET_NAME(iterator_next)(&iter, &value))
+		elements[nextracted++] = value;
+
+	/* Make sure we extracted the correct number of elements */
+	Assert(nextracted == set->nelements);
+
+	/* Sort the elements array, elements of compact sets are sorted already */
+	if (!HASHSET_IS_COMPACT(set))
+		qsort(elements, nextracted, sizeof(HASHSET_ELEMENT_TYPE),
+			  HASHSET_NAME(element_cmp));
+
+	/* Return the sorted elements array */
+	return elements;
+}
+
+/*
+ * copy
+ *		Make a copy of the hashset in the current memory context.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(copy)(HASHSET_TYPE *src)
+{
+	HASHSET_TYPE   *dst = (HASHSET_TYPE *) palloc(VARSIZE(src));
+
+	memcpy(dst, src, VARSIZE(src));
+
+	return dst;
+}
+
+/*
+ * hash_element
+ *		Calculate hash of a value, using the given hash function.
+ */
+uint32
+HASHSET_NAME(hash_element)(int hashfn_id, HASHSET_ELEMENT_TYPE value)
+{
+	uint32	folded = HASHSET_ELEMENT_FOLD(value);
+
+	switch (hashfn_id)
+	{
+		case JENKINS_LOOKUP3_HASHFN_ID:
+			return HASHSET_HASH_JENKINS(folded);
+		case MURMURHASH32_HASHFN_ID:
+			return HASHSET_HASH_MURMUR(folded);
+		case NAIVE_HASHFN_ID:
+			return HASHSET_HASH_NAIVE(folded);
+	}
+
+	hashset_invalid_hashfn(hashfn_id);
+	pg_unreachable();
+}
+
+/*
+ * compact
+ *		Build the compact representation of a hashset (in any format).
+ *
+ * The compact format stores only the elements, sorted and delta-encoded as
+ * varints (or using the container encoding, if that's smaller), so it's
+ * much smaller than the hash table with all the empty slots. The header is
+ * the same, so that the capacity, hash function and other parameters
+ * survive a store/load cycle.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(compact)(HASHSET_TYPE *set)
+{
+	HASHSET_ELEMENT_TYPE   *values;
+	HASHSET_TYPE		   *result;
+
+	if (HASHSET_IS_COMPACT(set))
+		return HASHSET_NAME(copy)(set);
+
+	values = HASHSET_NAME(extract_sorted_elements)(set);
+
+	result = HASHSET_NAME(compact_encode)(set, values, set->nelements);
+
+	pfree(values);
+
+	return result;
+}
+
+/*
+ * compact_encode
+ *		Build a compact hashset from sorted (and distinct) values, with the
+ *		header copied from the given hashset.
+ *
+ * Picks the smaller of the two encodings (when the element type has the
+ * container encoding). The choice depends only on the elements, so the
+ * compact format is still unique for a set of elements.
+ */
+static HASHSET_TYPE *
+HASHSET_NAME(compact_encode)(HASHSET_TYPE *header,
+							 const HASHSET_ELEMENT_TYPE *values, int nvalues)
+{
+	Size			varints_len = 0;
+	Size			len;
+#ifdef HASHSET_USE_CONTAINERS
+	bool			use_containers = false;
+#endif
+	HASHSET_TYPE   *result;
+	char		   *ptr;
+	uint64			prev;
+	uint32			hash = 0;
+	int				i;
+
+	prev = 0;
+	for (i = 0; i < nvalues; i++)
+	{
+		varints_len += hashset_varint_length(HASHSET_ELEMENT_BIAS(values[i]) - prev);
+		prev = HASHSET_ELEMENT_BIAS(values[i]);
+		hash += HASHSET_ELEMENT_HASH(values[i]);
+	}
+
+	len = varints_len;
+
+#ifdef HASHSET_USE_CONTAINERS
+	{
+		Size	containers_len = hashset_containers_length(values, nvalues);
+
+		if (containers_len < varints_len)
+		{
+			use_containers = true;
+			len = containers_len;
+		}
+	}
+#endif
+
+	len += offsetof(HASHSET_TYPE, data);
+	result = (HASHSET_TYPE *) palloc(len);
+
+	/* Same header, except for the flags */
+	memcpy(result, header, offsetof(HASHSET_TYPE, data));
+	SET_VARSIZE(result, len);
+	result->nelements = nvalues;
+	result->ndeleted = 0;
+	result->hash = hash;
+	result->flags |= HASHSET_FLAG_COMPACT;
+	result->flags &= ~HASHSET_FLAG_CONTAINERS;
+
+#ifdef HASHSET_USE_CONTAINERS
+	if (use_containers)
+	{
+		result->flags |= HASHSET_FLAG_CONTAINERS;
+		hashset_containers_encode(result->data, values, nvalues);
+
+		return result;
+	}
+#endif
+
+	ptr = result->data;
+	prev = 0;
+	for (i = 0; i < nvalues; i++)
+	{
+		ptr = hashset_varint_encode(ptr, HASHSET_ELEMENT_BIAS(values[i]) - prev);
+		prev = HASHSET_ELEMENT_BIAS(values[i]);
+	}
+
+	Assert(ptr == (char *) result + len);
+
+	return result;
+}
+
+/*
+ * canonical_hash
+ *		Calculate a 64-bit hash of the hashset contents.
+ *
+ * The hash depends only on the elements (and the NULL element), not on the
+ * hash function or the layout of the set, so equal sets always have equal
+ * hashes. It's derived from the sum of element hashes, which is stored in
+ * the header and maintained by every operation adding or removing elements
+ * (the sum does not depend on the order of elements, and unlike XOR,
+ * different elements can't cancel out each other). So this is cheap, no
+ * matter how large the set is.
+ *
+ * The low 32 bits with seed 0 are the 32-bit hash, as required for hash
+ * opclasses.
+ */
+uint64
+HASHSET_NAME(canonical_hash)(HASHSET_TYPE *set, uint64 seed)
+{
+	uint32	extra;
+	uint32	lo;
+	uint64	hi;
+
+	extra = ((uint32) set->nelements << 1) | (set->null_element ? 1 : 0);
+
+	hi = hashset_mix64((((uint64) extra << 32) | set->hash) + seed);
+
+	if (seed == 0)
+		lo = murmurhash32(set->hash ^ murmurhash32(extra));
+	else
+		lo = (uint32) hi;
+
+	return (hi & UINT64CONST(0xFFFFFFFF00000000)) | lo;
+}
+
+/*
+ * compare
+ *		Compare two hashsets, defining the btree ordering.
+ *
+ * The sets are ordered by the (unsigned) 32-bit canonical hash, then by the
+ * number of elements, then by the sorted elements and finally by the NULL
+ * element. The first two keys come from the header, so sets with different
+ * elements are usually ordered without looking at the elements at all.
+ * They're also what the abbreviated sort keys use, see the sortsupport
+ * function in hashset-type-api.h.
+ *
+ * The compact format is the canonical ordered form of the set, so compact
+ * sets are compared by decoding both in lockstep, without allocating or
+ * sorting anything. Only hash tables need to be sorted first.
+ */
+int
+HASHSET_NAME(compare)(HASHSET_TYPE *a, HASHSET_TYPE *b)
+{
+	uint32					hash_a = (uint32) HASHSET_NAME(canonical_hash)(a, 0);
+	uint32					hash_b = (uint32) HASHSET_NAME(canonical_hash)(b, 0);
+	HASHSET_ELEMENT_TYPE   *elements_a = NULL;
+	HASHSET_ELEMENT_TYPE   *elements_b = NULL;
+	HASHSET_ITERATOR		iter_a;
+	HASHSET_ITERATOR		iter_b;
+	int						result = 0;
+
+	if (hash_a != hash_b)
+		return (hash_a < hash_b) ? -1 : 1;
+
+	if (a->nelements != b->nelements)
+		return (a->nelements < b->nelements) ? -1 : 1;
+
+	/* Identical encodings mean identical elements, no need to decode */
+	if (HASHSET_IS_COMPACT(a) && HASHSET_IS_COMPACT(b) &&
+		HASHSET_IS_CONTAINERS(a) == HASHSET_IS_CONTAINERS(b) &&
+		VARSIZE(a) == VARSIZE(b) &&
+		memcmp(a->data, b->data, VARSIZE(a) - offsetof(HASHSET_TYPE, data)) == 0)
+		return (int) a->null_element - (int) b->null_element;
+
+	if (HASHSET_IS_COMPACT(a))
+		HASHSET_NAME(iterator_init)(&iter_a, a);
+	else
+		elements_a = HASHSET_NAME(extract_sorted_elements)(a);
+
+	if (HASHSET_IS_COMPACT(b))
+		HASHSET_NAME(iterator_init)(&iter_b, b);
+	else
+		elements_b = HASHSET_NAME(extract_sorted_elements)(b);
+
+	for (int32 i = 0; i < a->nelements; i++)
+	{
+		HASHSET_ELEMENT_TYPE	value_a;
+		HASHSET_ELEMENT_TYPE	value_b;
+
+		if (elements_a)
+			value_a = elements_a[i];
+		else
+			HASHSET_NAME(iterator_next)(&iter_a, &value_a);
+
+		if (elements_b)
+			value_b = elements_b[i];
+		else
+			HASHSET_NAME(iterator_next)(&iter_b, &value_b);
+
+		if (value_a != value_b)
+		{
+			result = (value_a < value_b) ? -1 : 1;
+			break;
+		}
+	}
+
+	if (result == 0)
+		result = (int) a->null_element - (int) b->null_element;
+
+	if (elements_a)
+		pfree(elements_a);
+	if (elements_b)
+		pfree(elements_b);
+
+	return result;
+}
+
+/*
+ * compact_values
+ *		Build a compact hashset directly from an array of values.
+ *
+ * The values may be in arbitrary order and contain duplicates. The array
+ * gets sorted in place. This is much cheaper than building the hash table
+ * first, and it's what the input functions use.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(compact_values)(
+	HASHSET_ELEMENT_TYPE *values,
+	int nvalues,
+	int capacity,
+	float4 load_factor,
+	float4 growth_factor,
+	int hashfn_id,
+	bool null_element
+)
+{
+	int				i;
+	int				nelements;
+	HASHSET_TYPE	header;
+
+	if (nvalues > 1)
+		qsort(values, nvalues, sizeof(HASHSET_ELEMENT_TYPE),
+			  HASHSET_NAME(element_cmp));
+
+	/* Remove duplicates */
+	nelements = 0;
+	for (i = 0; i < nvalues; i++)
+	{
+		if (nelements > 0 && values[i] == values[nelements - 1])
+			continue;
+
+		values[nelements++] = values[i];
+	}
+
+	/* Make sure the hash table will have enough space for the elements */
+	if (nelements > 0)
+		capacity = Max(capacity, (int) (nelements / load_factor) + 1);
+
+	capacity = hashset_round_capacity(capacity, sizeof(HASHSET_ELEMENT_TYPE));
+
+	memset(&header, 0, sizeof(HASHSET_TYPE));
+
+	header.flags = HASHSET_FORMAT_FLAGS | HASHSET_FLAG_COMPACT;
+	header.capacity = capacity;
+	header.nelements = nelements;
+	header.hashfn_id = hashfn_id;
+	header.load_factor = load_factor;
+	header.growth_factor = growth_factor;
+	header.ncollisions = 0;
+	header.max_collisions = 0;
+	header.ndeleted = 0;
+	header.hash = 0;			/* calculated by compact_encode */
+	header.null_element = null_element;
+
+	return HASHSET_NAME(compact_encode)(&header, values, nelements);
+}
+
+/*
+ * rebuild
+ *		Rebuild the hash table from a compact hashset.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(rebuild)(HASHSET_TYPE *set)
+{
+	HASHSET_TYPE   *result;
+
+	Assert(HASHSET_IS_COMPACT(set));
+
+	result = HASHSET_NAME(allocate)(
+		Max(set->capacity, (int) (set->nelements / set->load_factor) + 1),
+		set->load_factor,
+		set->growth_factor,
+		set->hashfn_id
+	);
+
+	result = HASHSET_NAME(add_set)(result, set);
+
+	result->null_element = set->null_element;
+
+	return result;
+}
+
+/*
+ * getarg_cached
+ *		Get a hashset argument for functions doing a single lookup, caching
+ *		the rebuilt hash table for constant arguments.
+ *
+ * Rebuilding the hash table from a compact hashset is not free, and doing
+ * it for each call of hashset_contains(const, x) would be quite expensive.
+ * So if the argument is a Const, we keep the table in fn_extra. We don't do
+ * that for other arguments (e.g. Params), as we can't be sure the value did
+ * not change between calls - those are returned in the compact format, and
+ * contains_element() simply scans them. Functions using fn_extra for other
+ * purposes must not use this.
+ *
+ * getarg_table is the variant for functions doing many lookups per call,
+ * which always get a hash table (rebuilt for each call, unless the argument
+ * is a Const).
+ */
+typedef struct HASHSET_NAME(arg_cache_t) {
+	Pointer			source[2];	/* Datum the table was built from */
+	HASHSET_TYPE   *set[2];		/* The rebuilt hash table */
+} HASHSET_NAME(arg_cache_t);
+
+HASHSET_TYPE *
+HASHSET_NAME(getarg_cached)(FunctionCallInfo fcinfo, int argno)
+{
+	return HASHSET_NAME(getarg)(fcinfo, argno, false);
+}
+
+HASHSET_TYPE *
+HASHSET_NAME(getarg_table)(FunctionCallInfo fcinfo, int argno)
+{
+	return HASHSET_NAME(getarg)(fcinfo, argno, true);
+}
+
+static HASHSET_TYPE *
+HASHSET_NAME(getarg)(FunctionCallInfo fcinfo, int argno, bool rebuild)
+{
+	Datum						d = PG_GETARG_DATUM(argno);
+	HASHSET_TYPE			   *set = HASHSET_NAME(datum_get_any)(d);
+	HASHSET_NAME(arg_cache_t)  *cache;
+	MemoryContext				oldcontext;
+
+	/* Expanded sets and hash tables need no rebuilding */
+	if (!HASHSET_IS_COMPACT(set))
+		return set;
+
+	/*
+	 * For a single lookup, scanning the compact set is cheaper than building
+	 * the hash table, so just return the compact set.
+	 */
+	if (argno >= lengthof(cache->source) ||
+		!hashset_arg_is_const(fcinfo->flinfo, argno))
+		return rebuild ? HASHSET_NAME(rebuild)(set) : set;
+
+	cache = (HASHSET_NAME(arg_cache_t) *) fcinfo->flinfo->fn_extra;
+	if (cache == NULL)
+	{
+		cache = MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt,
+									   sizeof(HASHSET_NAME(arg_cache_t)));
+		fcinfo->flinfo->fn_extra = cache;
+	}
+
+	if (cache->source[argno] != DatumGetPointer(d))
+	{
+		if (cache->set[argno] != NULL)
+			pfree(cache->set[argno]);
+
+		oldcontext = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+		cache->set[argno] = HASHSET_NAME(rebuild)(set);
+		MemoryContextSwitchTo(oldcontext);
+
+		cache->source[argno] = DatumGetPointer(d);
+	}
+
+	return cache->set[argno];
+}
+
+/*
+ * expanded_allocate
+ *		Create a new (empty) expanded hashset in a child of parentcontext.
+ */
+HASHSET_EXPANDED *
+HASHSET_NAME(expanded_allocate)(
+	int capacity,
+	float4 load_factor,
+	float4 growth_factor,
+	int hashfn_id,
+	MemoryContext parentcontext
+)
+{
+	HASHSET_EXPANDED   *eh;
+	MemoryContext		objcxt;
+	MemoryContext		oldcxt;
+
+	/*
+	 * Allocate private context for expanded object. The hashset itself may
+	 * get quite large, but we start small as most sets are tiny.
+	 */
+	objcxt = AllocSetContextCreate(parentcontext,
+								   "expanded hashset",
+								   ALLOCSET_START_SMALL_SIZES);
+
+	eh = (HASHSET_EXPANDED *)
+		MemoryContextAlloc(objcxt, sizeof(HASHSET_EXPANDED));
+
+	EOH_init_header(&eh->hdr, &HASHSET_NAME(expanded_methods), objcxt);
+	eh->magic = HASHSET_EXPANDED_MAGIC;
+	eh->flat = NULL;
+
+	oldcxt = MemoryContextSwitchTo(objcxt);
+	eh->set = HASHSET_NAME(allocate)(capacity, load_factor, growth_factor,
+									 hashfn_id);
+	MemoryContextSwitchTo(oldcxt);
+
+	return eh;
+}
+
+/*
+ * expand
+ *		Convert a hashset datum into an expanded hashset, in a child of
+ *		parentcontext. The input datum is not modified.
+ */
+Datum
+HASHSET_NAME(expand)(Datum datum, MemoryContext parentcontext)
+{
+	HASHSET_EXPANDED   *eh;
+	HASHSET_TYPE	   *set;
+	MemoryContext		objcxt;
+	MemoryContext		oldcxt;
+
+	objcxt = AllocSetContextCreate(parentcontext,
+								   "expanded hashset",
+								   ALLOCSET_START_SMALL_SIZES);
+
+	eh = (HASHSET_EXPANDED *)
+		MemoryContextAlloc(objcxt, sizeof(HASHSET_EXPANDED));
+
+	EOH_init_header(&eh->hdr, &HASHSET_NAME(expanded_methods), objcxt);
+	eh->magic = HASHSET_EXPANDED_MAGIC;
+	eh->flat = NULL;
+
+	/*
+	 * Build the hash table (for compact sets) or copy it into the object's
+	 * context. Expanded input is used directly, without flattening it.
+	 */
+	set = HASHSET_NAME(datum_get_any)(datum);
+
+	oldcxt = MemoryContextSwitchTo(objcxt);
+	if (HASHSET_IS_COMPACT(set))
+		eh->set = HASHSET_NAME(rebuild)(set);
+	else
+		eh->set = HASHSET_NAME(copy)(set);
+	MemoryContextSwitchTo(oldcxt);
+
+	return EOHPGetRWDatum(&eh->hdr);
+}
+
+/*
+ * datum_get_expanded
+ *		Get a writable expanded hashset from an input argument.
+ *
+ * If the datum is a read/write pointer to an expanded hashset, we simply
+ * return it and the caller is free to modify it in place. Otherwise we
+ * expand it into a new object in the current memory context.
+ */
+HASHSET_EXPANDED *
+HASHSET_NAME(datum_get_expanded)(Datum d)
+{
+	HASHSET_EXPANDED   *eh;
+
+	if (VARATT_IS_EXTERNAL_EXPANDED_RW(DatumGetPointer(d)))
+	{
+		eh = (HASHSET_EXPANDED *) DatumGetEOHP(d);
+		Assert(eh->magic == HASHSET_EXPANDED_MAGIC);
+
+		/* The caller is going to modify the set, so forget the flat image */
+		if (eh->flat != NULL)
+		{
+			pfree(eh->flat);
+			eh->flat = NULL;
+		}
+
+		return eh;
+	}
+
+	d = HASHSET_NAME(expand)(d, CurrentMemoryContext);
+
+	return (HASHSET_EXPANDED *) DatumGetEOHP(d);
+}
+
+/*
+ * convert_format
+ *		Convert a (detoasted) set stored in an older format.
+ *
+ * The result is a compact set with the same parameters. The detoasted copy
+ * of the datum is freed, so the result is the only thing left to free.
+ */
+static HASHSET_TYPE *
+HASHSET_NAME(convert_format)(Datum d, HASHSET_TYPE *set)
+{
+#ifdef HASHSET_LEGACY_FORMAT
+	if (HASHSET_GET_FORMAT(set) == 0)
+	{
+		int4hashset_legacy_t   *legacy = (int4hashset_legacy_t *) set;
+		HASHSET_TYPE		   *result;
+		HASHSET_ELEMENT_TYPE   *values;
+		char				   *bitmap;
+		char				   *slots;
+		int						nvalues = 0;
+		int						i;
+
+		if (legacy->capacity < 0 ||
+			VARSIZE(legacy) < offsetof(int4hashset_legacy_t, data) +
+			(Size) (legacy->capacity + 7) / 8 +
+			(Size) legacy->capacity * sizeof(int32))
+			elog(ERROR, "invalid hashset in format version 0");
+
+		bitmap = legacy->data;
+		slots = legacy->data + (legacy->capacity + 7) / 8;
+
+		values = palloc(Max(legacy->capacity, 1) * sizeof(HASHSET_ELEMENT_TYPE));
+
+		for (i = 0; i < legacy->capacity; i++)
+		{
+			int32	value;
+
+			if ((bitmap[i / 8] & (0x01 << (i % 8))) == 0)
+				continue;
+
+			memcpy(&value, slots + i * sizeof(int32), sizeof(int32));
+			values[nvalues++] = value;
+		}
+
+		result = HASHSET_NAME(compact_values)(values, nvalues,
+											  legacy->capacity,
+											  legacy->load_factor,
+											  legacy->growth_factor,
+											  legacy->hashfn_id,
+											  legacy->null_element);
+
+		pfree(values);
+		if ((Pointer) set != DatumGetPointer(d))
+			pfree(set);
+
+		return result;
+	}
+#endif
+
+	elog(ERROR, "unsupported hashset format version %d",
+		 HASHSET_GET_FORMAT(set));
+
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * datum_get_any
+ *		Get a read-only pointer to the hashset stored in a datum.
+ *
+ * For expanded hashsets (read/write or read-only pointers) this returns the
+ * set owned by the expanded object, without flattening it. Otherwise the
+ * value is detoasted in the usual way, and it may be in either the compact
+ * or the hash table format (sets in an older format are converted to the
+ * compact one). The result must not be modified.
+ */
+HASHSET_TYPE *
+HASHSET_NAME(datum_get_any)(Datum d)
+{
+	HASHSET_TYPE   *set;
+
+	if (VARATT_IS_EXTERNAL_EXPANDED(DatumGetPointer(d)))
+	{
+		HASHSET_EXPANDED   *eh;
+
+		eh = (HASHSET_EXPANDED *) DatumGetEOHP(d);
+		Assert(eh->magic == HASHSET_EXPANDED_MAGIC);
+
+		return eh->set;
+	}
+
+	set = (HASHSET_TYPE *) PG_DETOAST_DATUM(d);
+
+	/* Sets stored by older releases need to be converted first */
+	if (HASHSET_GET_FORMAT(set) != HASHSET_FORMAT_VERSION)
+		set = HASHSET_NAME(convert_format)(d, set);
+
+	return set;
+}
+
+/*
+ * datum_get
+ *		Get a read-only hash table for the hashset stored in a datum.
+ *
+ * Same as datum_get_any, except that compact hashsets get the hash table
+ * rebuilt (in the current memory context).
+ */
+HASHSET_TYPE *
+HASHSET_NAME(datum_get)(Datum d)
+{
+	HASHSET_TYPE   *set = HASHSET_NAME(datum_get_any)(d);
+
+	if (HASHSET_IS_COMPACT(set))
+		set = HASHSET_NAME(rebuild)(set);
+
+	return set;
+}
+
+/*
+ * get_flat_size method for expanded hashsets
+ *
+ * The flat form of a hashset is the compact one. Building it requires
+ * sorting the elements, so we keep it until flatten_into gets called.
+ */
+static Size
+HASHSET_NAME(get_flat_size)(ExpandedObjectHeader *eohptr)
+{
+	HASHSET_EXPANDED   *eh = (HASHSET_EXPANDED *) eohptr;
+	MemoryContext		oldcxt;
+
+	Assert(eh->magic == HASHSET_EXPANDED_MAGIC);
+
+	if (eh->flat == NULL)
+	{
+		oldcxt = MemoryContextSwitchTo(eh->hdr.eoh_context);
+		eh->flat = HASHSET_NAME(compact)(eh->set);
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	return VARSIZE(eh->flat);
+}
+
+/*
+ * flatten_into method for expanded hashsets
+ */
+static void
+HASHSET_NAME(flatten_into)(ExpandedObjectHeader *eohptr,
+						   void *result, Size allocated_size)
+{
+	HASHSET_EXPANDED   *eh = (HASHSET_EXPANDED *) eohptr;
+
+	Assert(eh->magic == HASHSET_EXPANDED_MAGIC);
+
+	/* Should have been built by get_flat_size, but be careful */
+	if (eh->flat == NULL)
+		(void) HASHSET_NAME(get_flat_size)(eohptr);
+
+	Assert(allocated_size == VARSIZE(eh->flat));
+
+	memcpy(result, eh->flat, allocated_size);
+}
+
+static int
+HASHSET_NAME(element_cmp)(const void *a, const void *b)
+{
+	HASHSET_ELEMENT_TYPE arg1 = *(const HASHSET_ELEMENT_TYPE *) a;
+	HASHSET_ELEMENT_TYPE arg2 = *(const HASHSET_ELEMENT_TYPE *) b;
+
+	if (arg1 < arg2) return -1;
+	if (arg1 > arg2) return 1;
+	return 0;
+}
+
+#endif							/* HASHSET_DEFINE */
+
+#undef HASHSET_PREFIX
+#undef HASHSET_ELEMENT_TYPE
+#undef HASHSET_ELEMENT_MIN
+#undef HASHSET_USE_CONTAINERS
+#undef HASHSET_LEGACY_FORMAT
+#undef HASHSET_DECLARE
+#undef HASHSET_DEFINE
+#undef HASHSET_EXPANDED_MAGIC
+#undef HASHSET_MAKE_NAME_
+#undef HASHSET_MAKE_NAME
+#undef HASHSET_NAME
+#undef HASHSET_TYPE
+#undef HASHSET_EXPANDED
+#undef HASHSET_ITERATOR
+#undef HASHSET_VALUES_OFFSET
+#undef HASHSET_GET_VALUES
+#undef HASHSET_ELEMENT_FOLD
+#undef HASHSET_ELEMENT_BIAS
+#undef HASHSET_ELEMENT_UNBIAS
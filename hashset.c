@@ -6,259 +6,212 @@
 
 #include "hashset.h"
 
-static int int32_cmp(const void *a, const void *b);
+#include "nodes/primnodes.h"
+#include "utils/typcache.h"
 
-int4hashset_t *
-int4hashset_allocate(
-	int capacity,
-	float4 load_factor,
-	float4 growth_factor,
-	int hashfn_id
-)
-{
-	Size			len;
-	int4hashset_t  *set;
-	char		   *ptr;
-
-	/*
-	 * Ensure that capacity is not divisible by HASHSET_STEP;
-	 * i.e. the step size used in hashset_add_element()
-	 * and hashset_contains_element().
-	 */
-	while (capacity % HASHSET_STEP == 0)
-		capacity++;
-
-	len = offsetof(int4hashset_t, data);
-	len += CEIL_DIV(capacity, 8);
-	len += capacity * sizeof(int32);
+static int hashset_round_capacity(int capacity, Size elemsize);
+static void hashset_invalid_hashfn(int hashfn_id);
 
-	ptr = palloc0(len);
-	SET_VARSIZE(ptr, len);
+/*
+ * hashset_round_capacity
+ *		Round the requested capacity to a valid hash table size.
+ *
+ * The capacity has to be a power of two, so that we can use a mask instead
+ * of modulo, and at least one full group (unless it's zero). The control
+ * byte and the value of all the slots have to fit into a single chunk.
+ */
+static int
+hashset_round_capacity(int capacity, Size elemsize)
+{
+	uint64	rounded;
 
-	set = (int4hashset_t *) ptr;
+	if (capacity == 0)
+		return 0;
 
-	set->flags = 0;
-	set->capacity = capacity;
-	set->nelements = 0;
-	set->hashfn_id = hashfn_id;
-	set->load_factor = load_factor;
-	set->growth_factor = growth_factor;
-	set->ncollisions = 0;
-	set->max_collisions = 0;
-	set->hash = 0; /* Initial hash value */
-	set->null_element = false; /* No null element initially */
+	/* check the rounded capacity, that's what gets allocated */
+	rounded = (capacity < 0) ? PG_UINT64_MAX :
+		Max(HASHSET_GROUP_SIZE, pg_nextpower2_64((uint64) capacity));
 
-	set->flags |= 0;
+	if (rounded > MaxAllocSize / (elemsize + 1))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("hashset capacity %d is too large", capacity)));
 
-	return set;
+	return (int) rounded;
 }
 
-int4hashset_t *
-int4hashset_resize(int4hashset_t * set)
+static void
+hashset_invalid_hashfn(int hashfn_id)
 {
-	int				i;
-	int4hashset_t  *new;
-	char		   *bitmap = HASHSET_GET_BITMAP(set);
-	int32		   *values = HASHSET_GET_VALUES(set);
-	int				new_capacity;
+	ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			errmsg("invalid hash function ID: \"%d\"", hashfn_id)));
+}
 
-	new_capacity = (int)(set->capacity * set->growth_factor);
+/*
+ * The hashset core (hash table, compact format, expanded objects) for each
+ * of the element types, see hashset-type.h.
+ */
+#define HASHSET_PREFIX int2hashset
+#define HASHSET_ELEMENT_TYPE int16
+#define HASHSET_ELEMENT_MIN PG_INT16_MIN
+#define HASHSET_EXPANDED_MAGIC INT2HASHSET_EXPANDED_MAGIC
+#define HASHSET_DEFINE
+#include "hashset-type.h"
+
+#define HASHSET_PREFIX int4hashset
+#define HASHSET_ELEMENT_TYPE int32
+#define HASHSET_ELEMENT_MIN PG_INT32_MIN
+#define HASHSET_EXPANDED_MAGIC INT4HASHSET_EXPANDED_MAGIC
+#define HASHSET_USE_CONTAINERS
+#define HASHSET_LEGACY_FORMAT
+#define HASHSET_DEFINE
+#include "hashset-type.h"
+
+#define HASHSET_PREFIX int8hashset
+#define HASHSET_ELEMENT_TYPE int64
+#define HASHSET_ELEMENT_MIN PG_INT64_MIN
+#define HASHSET_EXPANDED_MAGIC INT8HASHSET_EXPANDED_MAGIC
+#define HASHSET_DEFINE
+#include "hashset-type.h"
 
-	/*
-	 * If growth factor is too small, new capacity might remain the same as
-	 * the old capacity. This can lead to an infinite loop in resizing.
-	 * To prevent this, we manually increment the capacity by 1 if new capacity
-	 * equals the old capacity.
-	 */
-	if (new_capacity == set->capacity)
-		new_capacity = set->capacity + 1;
+/*
+ * Sorted elements of the hashset (of the given type), widened to int64.
+ * The detoasted copy of the set (if any) is freed.
+ */
+#define HASHSET_DATUM_ELEMENTS(prefix, type) \
+	do { \
+		prefix##_t *set = prefix##_datum_get_any(d); \
+		type	   *values = prefix##_extract_sorted_elements(set); \
+		\
+		result = (int64 *) palloc(Max(set->nelements, 1) * sizeof(int64)); \
+		for (i = 0; i < set->nelements; i++) \
+			result[i] = values[i]; \
+		\
+		*nelements = set->nelements; \
+		*null_element = set->null_element; \
+		\
+		pfree(values); \
+		if (!VARATT_IS_EXTERNAL_EXPANDED(DatumGetPointer(d)) && \
+			(Pointer) set != DatumGetPointer(d)) \
+			pfree(set); \
+	} while (0)
 
-	new = int4hashset_allocate(
-		new_capacity,
-		set->load_factor,
-		set->growth_factor,
-		set->hashfn_id
-	);
+/*
+ * hashset_datum_elements
+ *		Get the elements of a hashset of any of the types, in ascending
+ *		order and widened to int64.
+ *
+ * elemtype is the OID of the element type of the hashset (e.g. INT4OID).
+ */
+int64 *
+hashset_datum_elements(Datum d, Oid elemtype, int *nelements,
+					   bool *null_element)
+{
+	int64  *result = NULL;
+	int		i;
 
-	for (i = 0; i < set->capacity; i++)
+	switch (elemtype)
 	{
-		int	byte = (i / 8);
-		int	bit = (i % 8);
-
-		if (bitmap[byte] & (0x01 << bit))
-			int4hashset_add_element(new, values[i]);
+		case INT2OID:
+			HASHSET_DATUM_ELEMENTS(int2hashset, int16);
+			break;
+		case INT4OID:
+			HASHSET_DATUM_ELEMENTS(int4hashset, int32);
+			break;
+		case INT8OID:
+			HASHSET_DATUM_ELEMENTS(int8hashset, int64);
+			break;
+		default:
+			elog(ERROR, "unexpected hashset element type %u", elemtype);
 	}
 
-	return new;
+	return result;
 }
 
-int4hashset_t *
-int4hashset_add_element(int4hashset_t *set, int32 value)
+/*
+ * hashset_datum_element
+ *		Get an element (e.g. a Const compared to the hashset) as int64.
+ */
+int64
+hashset_datum_element(Datum d, Oid elemtype)
 {
-	int		byte;
-	int		bit;
-	uint32	hash;
-	uint32	position;
-	char   *bitmap;
-	int32  *values;
-	int32	current_collisions = 0;
-
-	if (set->nelements > set->capacity * set->load_factor)
-		set = int4hashset_resize(set);
-
-	if (set->hashfn_id == JENKINS_LOOKUP3_HASHFN_ID)
+	switch (elemtype)
 	{
-		hash = hash_bytes_uint32((uint32) value);
+		case INT2OID:
+			return DatumGetInt16(d);
+		case INT4OID:
+			return DatumGetInt32(d);
+		case INT8OID:
+			return DatumGetInt64(d);
 	}
-	else if (set->hashfn_id == MURMURHASH32_HASHFN_ID)
-	{
-		hash = murmurhash32((uint32) value);
-	}
-	else if (set->hashfn_id == NAIVE_HASHFN_ID)
-	{
-		hash = ((uint32) value * 7691 + 4201);
-	}
-	else
-	{
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-				errmsg("invalid hash function ID: \"%d\"", set->hashfn_id)));
-	}
-
-    position = hash % set->capacity;
-
-	bitmap = HASHSET_GET_BITMAP(set);
-	values = HASHSET_GET_VALUES(set);
-
-	while (true)
-	{
-		byte = (position / 8);
-		bit = (position % 8);
-
-		/* The item is already used - maybe it's the same value? */
-		if (bitmap[byte] & (0x01 << bit))
-		{
-			/* Same value, we're done */
-			if (values[position] == value)
-				break;
 
-			/* Increment the collision counter */
-			set->ncollisions++;
-			current_collisions++;
-
-			if (current_collisions > set->max_collisions)
-				set->max_collisions = current_collisions;
-
-			position = (position + HASHSET_STEP) % set->capacity;
-			continue;
-		}
-
-		/* Found an empty spot, before hitting the value first */
-		bitmap[byte] |= (0x01 << bit);
-		values[position] = value;
-
-		set->hash ^= hash;
-
-		set->nelements++;
-
-		break;
-	}
-
-	return set;
+	elog(ERROR, "unexpected hashset element type %u", elemtype);
+	pg_unreachable();
 }
 
-bool
-int4hashset_contains_element(int4hashset_t *set, int32 value)
+/*
+ * hashset_element_datum
+ *		Build a datum of the element type from an int64 value.
+ */
+Datum
+hashset_element_datum(int64 value, Oid elemtype)
 {
-	int     byte;
-	int     bit;
-	uint32  hash;
-	uint32	position;
-	char   *bitmap = HASHSET_GET_BITMAP(set);
-	int32  *values = HASHSET_GET_VALUES(set);
-	int     num_probes = 0; /* Counter for the number of probes */
-
-	if (set->hashfn_id == JENKINS_LOOKUP3_HASHFN_ID)
-	{
-		hash = hash_bytes_uint32((uint32) value);
-	}
-	else if (set->hashfn_id == MURMURHASH32_HASHFN_ID)
-	{
-		hash = murmurhash32((uint32) value);
-	}
-	else if (set->hashfn_id == NAIVE_HASHFN_ID)
+	switch (elemtype)
 	{
-		hash = ((uint32) value * NAIVE_HASHFN_MULTIPLIER + NAIVE_HASHFN_INCREMENT);
+		case INT2OID:
+			return Int16GetDatum((int16) value);
+		case INT4OID:
+			return Int32GetDatum((int32) value);
+		case INT8OID:
+			return Int64GetDatum(value);
 	}
-	else
-	{
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-				errmsg("invalid hash function ID: \"%d\"", set->hashfn_id)));
-	}
-
-	position = hash % set->capacity;
 
-	while (true)
-	{
-		byte = (position / 8);
-		bit = (position % 8);
-
-		/* Found an empty slot, value is not there */
-		if ((bitmap[byte] & (0x01 << bit)) == 0)
-			return false;
-
-		/* Is it the same value? */
-		if (values[position] == value)
-			return true;
+	elog(ERROR, "unexpected hashset element type %u", elemtype);
+	pg_unreachable();
+}
 
-		/* Move to the next element */
-		position = (position + HASHSET_STEP) % set->capacity;
+/*
+ * hashset_element_eq_operator
+ *		The equality operator of the element type (e.g. int4 = int4), for
+ *		the planner support and the element statistics.
+ */
+Oid
+hashset_element_eq_operator(Oid elemtype)
+{
+	TypeCacheEntry *typentry = lookup_type_cache(elemtype, TYPECACHE_EQ_OPR);
 
-		num_probes++; /* Increment the number of probes */
+	if (!OidIsValid(typentry->eq_opr))
+		elog(ERROR, "could not find equality operator for type %u", elemtype);
 
-		/* Check if we have probed all slots */
-		if (num_probes >= set->capacity)
-			return false; /* Avoid infinite loop */
-	}
+	return typentry->eq_opr;
 }
 
-int32 *
-int4hashset_extract_sorted_elements(int4hashset_t *set)
+/*
+ * Is the argument of the function call a Const?
+ */
+bool
+hashset_arg_is_const(FmgrInfo *flinfo, int argno)
 {
-	int32  *elements = palloc(set->nelements * sizeof(int32));
-	char   *bitmap = HASHSET_GET_BITMAP(set);
-	int32  *values = HASHSET_GET_VALUES(set);
-	int32	nextracted = 0;
-
-	/* Iterate through all elements */
-	for (int32 i = 0; i < set->capacity; i++)
-	{
-		int byte = i / 8;
-		int bit = i % 8;
+	Node   *expr;
+	List   *args;
 
-		/* Check if the current position is occupied */
-		if (bitmap[byte] & (0x01 << bit))
-		{
-			/* Add the value to the elements array */
-			elements[nextracted++] = values[i];
-		}
-	}
+	if (flinfo == NULL || flinfo->fn_expr == NULL)
+		return false;
 
-	/* Make sure we extracted the correct number of elements */
-	Assert(nextracted == set->nelements);
+	expr = flinfo->fn_expr;
 
-	/* Sort the elements array */
-	qsort(elements, nextracted, sizeof(int32), int32_cmp);
+	if (IsA(expr, FuncExpr))
+		args = ((FuncExpr *) expr)->args;
+	else if (IsA(expr, OpExpr))
+		args = ((OpExpr *) expr)->args;
+	else
+		return false;
 
-	/* Return the sorted elements array */
-	return elements;
-}
+	if (argno < 0 || argno >= list_length(args))
+		return false;
 
-int4hashset_t *
-int4hashset_copy(int4hashset_t *src)
-{
-	return src;
+	return IsA(list_nth(args, argno), Const);
 }
 
 /*
@@ -282,46 +235,3 @@ hashset_isspace(char ch)
 		return true;
 	return false;
 }
-
-/*
- * Construct an SQL array from a simple C double array
- */
-Datum
-int32_to_array(FunctionCallInfo fcinfo, int32 *d, int len, bool null_element)
-{
-	ArrayBuildState *astate = NULL;
-	int		 i;
-
-	for (i = 0; i < len; i++)
-	{
-		/* Stash away this field */
-		astate = accumArrayResult(astate,
-								  Int32GetDatum(d[i]),
-								  false,
-								  INT4OID,
-								  CurrentMemoryContext);
-	}
-
-	if (null_element)
-	{
-		astate = accumArrayResult(astate,
-								  (Datum) 0,
-								  true,
-								  INT4OID,
-								  CurrentMemoryContext);
-	}
-
-	PG_RETURN_DATUM(makeArrayResult(astate,
-					CurrentMemoryContext));
-}
-
-static int
-int32_cmp(const void *a, const void *b)
-{
-	int32 arg1 = *(const int32 *)a;
-	int32 arg2 = *(const int32 *)b;
-
-	if (arg1 < arg2) return -1;
-	if (arg1 > arg2) return 1;
-	return 0;
-}
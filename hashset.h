@@ -4,23 +4,186 @@
 #include "postgres.h"
 #include "libpq/pqformat.h"
 #include "nodes/memnodes.h"
+#include "nodes/pathnodes.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "catalog/pg_type.h"
 #include "common/hashfn.h"
+#include "utils/expandeddatum.h"
+#include "port/pg_bitutils.h"
+#include "port/pg_bswap.h"
 
-#define CEIL_DIV(a, b) (((a) + (b) - 1) / (b))
-#define HASHSET_GET_BITMAP(set) ((set)->data)
-#define HASHSET_GET_VALUES(set) ((int32 *) ((set)->data + CEIL_DIV((set)->capacity, 8)))
-#define HASHSET_STEP 13
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define HASHSET_GET_CTRL(set) ((uint8 *) (set)->data)
 #define JENKINS_LOOKUP3_HASHFN_ID 1
 #define MURMURHASH32_HASHFN_ID 2
 #define NAIVE_HASHFN_ID 3
 #define NAIVE_HASHFN_MULTIPLIER 7691
 #define NAIVE_HASHFN_INCREMENT 4201
 
+/* The hash functions, identified by hashfn_id */
+#define HASHSET_HASH_JENKINS(value) hash_bytes_uint32((uint32) (value))
+#define HASHSET_HASH_MURMUR(value) murmurhash32((uint32) (value))
+#define HASHSET_HASH_NAIVE(value) \
+	((uint32) (value) * NAIVE_HASHFN_MULTIPLIER + NAIVE_HASHFN_INCREMENT)
+
+/*
+ * The hash table is split into groups of HASHSET_GROUP_SIZE slots, and the
+ * capacity is always a power of two (and a multiple of the group size), or
+ * zero. Each slot has a control byte, either HASHSET_CTRL_EMPTY or the low
+ * 7 bits of the hash of the element stored in the slot (the "tag"). The
+ * control bytes of a group are compared with the tag all at once (using
+ * SSE2 when available), so that we only look at values with a matching
+ * tag. The remaining bits of the hash select the first group to probe.
+ *
+ * Removed elements leave a tombstone (HASHSET_CTRL_DELETED) in the slot,
+ * unless the group has an empty slot (and so no probe ever continued past
+ * it). Lookups skip tombstones and only stop at empty slots, inserts may
+ * reuse them. Both empty and deleted slots have the high bit set.
+ */
+#define HASHSET_GROUP_SIZE 16
+#define HASHSET_CTRL_EMPTY 0x80
+#define HASHSET_CTRL_DELETED 0xFE
+#define HASHSET_CTRL_IS_FULL(ctrl) (((ctrl) & 0x80) == 0)
+#define HASHSET_HASH_TAG(hash) ((uint8) ((hash) & 0x7F))
+#define HASHSET_HASH_GROUP(hash) ((hash) >> 7)
+
+/*
+ * Fixed 64-bit mixer (the splitmix64 finalizer), used where the hash must
+ * not depend on the hash function of the set.
+ */
+static inline uint64
+hashset_mix64(uint64 x)
+{
+	x ^= x >> 30;
+	x *= UINT64CONST(0xbf58476d1ce4e5b9);
+	x ^= x >> 27;
+	x *= UINT64CONST(0x94d049bb133111eb);
+	x ^= x >> 31;
+
+	return x;
+}
+
+/*
+ * Hash of an element, as summed into the hash field of the set. Uses the
+ * fixed mixer, so that the sum does not depend on the hash function of the
+ * set. The smaller types hash the same way as int4.
+ */
+#define HASHSET_ELEMENT_HASH(value) \
+	((uint32) hashset_mix64((sizeof(value) > sizeof(uint32)) ? \
+							(uint64) (value) : (uint64) (uint32) (value)))
+
+/* Strategy numbers of the GIN operator class (int4hashset_gin_ops) */
+#define HASHSET_GIN_OVERLAP_STRATEGY		1
+#define HASHSET_GIN_CONTAINS_STRATEGY		2
+#define HASHSET_GIN_CONTAINED_STRATEGY		3
+#define HASHSET_GIN_EQUAL_STRATEGY			4
+#define HASHSET_GIN_CONTAINS_ELEM_STRATEGY	5
+
+/*
+ * Number of values hashed (and prefetched) at once by the bulk operations.
+ */
+#define HASHSET_BATCH_SIZE 16
+
+#if defined(__GNUC__) || defined(__clang__)
+#define hashset_prefetch(addr) __builtin_prefetch(addr)
+#else
+#define hashset_prefetch(addr) ((void) 0)
+#endif
+
+/*
+ * Prefetch the control bytes and values of a group (HASHSET_GET_VALUES is
+ * defined by hashset-type.h, for the element type)
+ */
+#define hashset_prefetch_group(set, group) \
+	do { \
+		hashset_prefetch(HASHSET_GET_CTRL(set) + (group) * HASHSET_GROUP_SIZE); \
+		hashset_prefetch(HASHSET_GET_VALUES(set) + (group) * HASHSET_GROUP_SIZE); \
+	} while (0)
+
+/*
+ * Flags stored in the flags field of the set
+ *
+ * HASHSET_FLAG_COMPACT marks the compact (flattened) format, used when the
+ * hashset gets stored on disk. Instead of the hash table (control bytes and
+ * values), the data contains just the elements, sorted and delta-encoded
+ * as varints. The hash table gets rebuilt when the set is accessed, while
+ * the header fields (capacity, nelements, ...) remain valid in both formats.
+ */
+#define HASHSET_FLAG_COMPACT 0x01
+#define HASHSET_IS_COMPACT(set) (((set)->flags & HASHSET_FLAG_COMPACT) != 0)
+
+/*
+ * HASHSET_FLAG_CONTAINERS marks a compact hashset using the container
+ * encoding instead of the varints (the compact flag is set too), used when
+ * it's smaller - for dense or clustered elements.
+ *
+ * The (biased) 32-bit space is split into chunks of 65536 values, keyed by
+ * the high 16 bits. The low 16 bits of the elements of each chunk are kept
+ * in the smallest of three containers: a sorted array of uint16 values, a
+ * bitmap of 65536 bits (as uint64 words), or a sorted array of runs (uint16
+ * start and length - 1). The data is the number of chunks (uint32), the
+ * chunk directory (sorted by key) and the containers. Nothing is aligned,
+ * so all of it is accessed using memcpy.
+ */
+#define HASHSET_FLAG_CONTAINERS 0x02
+#define HASHSET_IS_CONTAINERS(set) (((set)->flags & HASHSET_FLAG_CONTAINERS) != 0)
+
+#define HASHSET_CONTAINER_ARRAY		1
+#define HASHSET_CONTAINER_BITMAP	2
+#define HASHSET_CONTAINER_RUNS		3
+
+#define HASHSET_CHUNK_KEY(value)	((uint16) (HASHSET_BIAS(value) >> 16))
+#define HASHSET_CHUNK_LOW(value)	((uint16) HASHSET_BIAS(value))
+#define HASHSET_BITMAP_WORDS		(65536 / 64)
+#define HASHSET_BITMAP_SIZE			(HASHSET_BITMAP_WORDS * sizeof(uint64))
+
+/*
+ * Elements are mapped to uint32 in an order-preserving way, so that the
+ * deltas between sorted elements are never negative.
+ */
+#define HASHSET_BIAS(value) ((uint32) (value) ^ 0x80000000)
+#define HASHSET_UNBIAS(value) ((int32) ((value) ^ 0x80000000))
+
+/*
+ * The high byte of the flags is the version of the on-disk format, so that
+ * a set stored by an older release can be recognized (and converted, see
+ * datum_get_any in hashset-type.h). Version 0 is the original int4hashset
+ * layout of the 0.0.1 release, with the flags always zero - a bitmap of the
+ * used slots followed by the values, no tombstones and no compact format.
+ * Bump HASHSET_FORMAT_VERSION whenever the stored layout changes.
+ */
+#define HASHSET_FORMAT_VERSION 1
+#define HASHSET_FORMAT_SHIFT 24
+#define HASHSET_FORMAT_FLAGS (HASHSET_FORMAT_VERSION << HASHSET_FORMAT_SHIFT)
+#define HASHSET_GET_FORMAT(set) ((int) (((uint32) (set)->flags) >> HASHSET_FORMAT_SHIFT))
+
+/*
+ * Header of the int4hashset in the format version 0. The header is followed
+ * by a bitmap of the used slots and by the values of the slots (int32, not
+ * aligned). The binary format version 1 (send/recv) is the same, except for
+ * the varlena header.
+ */
+typedef struct int4hashset_legacy_t {
+	int32		vl_len_;		/* Varlena header (do not touch directly!) */
+	int32		flags;			/* Always 0 */
+	int32		capacity;
+	int32		nelements;
+	int32		hashfn_id;
+	float4		load_factor;
+	float4		growth_factor;
+	int32		ncollisions;
+	int32		max_collisions;
+	int32		hash;
+	bool		null_element;
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} int4hashset_legacy_t;
+
 /*
  * These defaults should match the the SQL function int4hashset()
  */
@@ -29,28 +192,293 @@
 #define DEFAULT_GROWTH_FACTOR 2.0
 #define DEFAULT_HASHFN_ID JENKINS_LOOKUP3_HASHFN_ID
 
-typedef struct int4hashset_t {
-	int32		vl_len_;		/* Varlena header (do not touch directly!) */
-	int32		flags;			/* Reserved for future use (versioning, ...) */
-	int32		capacity;		/* Max number of element we have space for */
-	int32		nelements;		/* Number of items added to the hashset */
-	int32		hashfn_id;		/* ID of the hash function used */
-	float4		load_factor;	/* Load factor before triggering resize */
-	float4		growth_factor;	/* Growth factor when resizing the hashset */
-	int32		ncollisions;	/* Number of collisions */
-	int32		max_collisions;	/* Maximum collisions for a single element */
-	int32		hash;			/* Stored hash value of the hashset */
-	bool		null_element;	/* Indicates if null is present in hashset */
-	char		data[FLEXIBLE_ARRAY_MEMBER];
-} int4hashset_t;
-
-int4hashset_t *int4hashset_allocate(int capacity, float4 load_factor, float4 growth_factor, int hashfn_id);
-int4hashset_t *int4hashset_resize(int4hashset_t * set);
-int4hashset_t *int4hashset_add_element(int4hashset_t *set, int32 value);
-bool int4hashset_contains_element(int4hashset_t *set, int32 value);
-int32 *int4hashset_extract_sorted_elements(int4hashset_t *set);
-int4hashset_t *int4hashset_copy(int4hashset_t *src);
+/*
+ * Max number of elements hashset_agg sizes its state for, when using the
+ * planner estimate of the group size (number of rows, not distinct values).
+ */
+#define HASHSET_AGG_MAX_ESTIMATE 65536
+
+/*
+ * Variable-length (LEB128) encoding of uint64 values, used by the compact
+ * format. Each byte carries 7 bits, the high bit marks continuation. The
+ * deltas of int2 and int4 elements always fit into 5 bytes.
+ */
+#define HASHSET_VARINT_MAXLEN 10
+
+static inline int
+hashset_varint_length(uint64 value)
+{
+	int		len = 1;
+
+	while (value >= 0x80)
+	{
+		value >>= 7;
+		len++;
+	}
+
+	return len;
+}
+
+static inline char *
+hashset_varint_encode(char *ptr, uint64 value)
+{
+	while (value >= 0x80)
+	{
+		*ptr++ = (char) ((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+
+	*ptr++ = (char) value;
+
+	return ptr;
+}
+
+static inline const char *
+hashset_varint_decode(const char *ptr, uint64 *value)
+{
+	uint64	result = 0;
+	int		shift = 0;
+	uint8	byte;
+
+	do
+	{
+		byte = (uint8) *ptr++;
+		result |= (uint64) (byte & 0x7F) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	*value = result;
+
+	return ptr;
+}
+
+#ifndef __SSE2__
+/*
+ * hashset_high_bits_mask
+ *		Collect the high bits of the 8 bytes into a mask (bit i = byte i).
+ */
+static inline uint32
+hashset_high_bits_mask(uint64 word)
+{
+	word = (word >> 7) & UINT64CONST(0x0101010101010101);
+
+	return (uint32) ((word * UINT64CONST(0x0102040810204080)) >> 56);
+}
+#endif
+
+/*
+ * hashset_group_match
+ *		Bitmask of slots in the group with the given tag (bit i = slot i).
+ */
+static inline uint32
+hashset_group_match(const uint8 *group, uint8 tag)
+{
+#ifdef __SSE2__
+	__m128i		ctrl = _mm_loadu_si128((const __m128i *) group);
+
+	return (uint32) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl,
+													 _mm_set1_epi8((char) tag)));
+#else
+	uint32		result = 0;
+	int			i;
+
+	/* Same thing, 8 control bytes at a time */
+	for (i = 0; i < HASHSET_GROUP_SIZE; i += sizeof(uint64))
+	{
+		uint64		word;
+
+		memcpy(&word, group + i, sizeof(uint64));
+#ifdef WORDS_BIGENDIAN
+		word = pg_bswap64(word);
+#endif
+
+		/* bytes equal to the tag become zero, then set high bit of those */
+		word ^= UINT64CONST(0x0101010101010101) * tag;
+		word = ~(((word & UINT64CONST(0x7F7F7F7F7F7F7F7F)) +
+				  UINT64CONST(0x7F7F7F7F7F7F7F7F)) |
+				 word | UINT64CONST(0x7F7F7F7F7F7F7F7F));
+
+		result |= hashset_high_bits_mask(word) << i;
+	}
+
+	return result;
+#endif
+}
+
+/*
+ * hashset_group_match_empty
+ *		Bitmask of empty slots in the group (bit i = slot i).
+ */
+static inline uint32
+hashset_group_match_empty(const uint8 *group)
+{
+	return hashset_group_match(group, HASHSET_CTRL_EMPTY);
+}
+
+/*
+ * hashset_group_match_free
+ *		Bitmask of empty or deleted slots in the group (bit i = slot i).
+ */
+static inline uint32
+hashset_group_match_free(const uint8 *group)
+{
+#ifdef __SSE2__
+	/* only empty and deleted slots have the high bit set */
+	__m128i		ctrl = _mm_loadu_si128((const __m128i *) group);
+
+	return (uint32) _mm_movemask_epi8(ctrl);
+#else
+	uint32		result = 0;
+	int			i;
+
+	for (i = 0; i < HASHSET_GROUP_SIZE; i += sizeof(uint64))
+	{
+		uint64		word;
+
+		memcpy(&word, group + i, sizeof(uint64));
+#ifdef WORDS_BIGENDIAN
+		word = pg_bswap64(word);
+#endif
+
+		result |= hashset_high_bits_mask(word) << i;
+	}
+
+	return result;
+#endif
+}
+
+/*
+ * hashset_group_match_full
+ *		Bitmask of occupied slots in the group (bit i = slot i).
+ */
+static inline uint32
+hashset_group_match_full(const uint8 *group)
+{
+	return ~hashset_group_match_free(group) & ((1 << HASHSET_GROUP_SIZE) - 1);
+}
+
+/*
+ * Chunk directory entry of the container encoding
+ */
+typedef struct hashset_chunk_t {
+	uint16		key;			/* High 16 bits of the (biased) elements */
+	uint16		type;			/* HASHSET_CONTAINER_* */
+	uint32		count;			/* Number of elements (runs for RUNS) */
+	uint32		offset;			/* Start of the container data */
+} hashset_chunk_t;
+
+#define HASHSET_CHUNKS(set)		((set)->data + sizeof(uint32))
+#define HASHSET_CONTAINERS(set, nchunks) \
+	(HASHSET_CHUNKS(set) + (Size) (nchunks) * sizeof(hashset_chunk_t))
+
+/* The number of chunks and the chunk directory, given the data of a set */
+static inline uint32
+hashset_get_nchunks(const char *data)
+{
+	uint32	nchunks;
+
+	memcpy(&nchunks, data, sizeof(uint32));
+
+	return nchunks;
+}
+
+static inline void
+hashset_get_chunk(const char *data, uint32 i, hashset_chunk_t *chunk)
+{
+	memcpy(chunk, data + sizeof(uint32) + (Size) i * sizeof(hashset_chunk_t),
+		   sizeof(hashset_chunk_t));
+}
+
+static inline uint16
+hashset_get_uint16(const char *ptr, uint32 i)
+{
+	uint16	value;
+
+	memcpy(&value, ptr + (Size) i * sizeof(uint16), sizeof(uint16));
+
+	return value;
+}
+
+static inline uint64
+hashset_get_word(const char *ptr, uint32 i)
+{
+	uint64	word;
+
+	memcpy(&word, ptr + (Size) i * sizeof(uint64), sizeof(uint64));
+
+	return word;
+}
+
+/*
+ * The hashset types, one for each integer type, generated by hashset-type.h
+ * (the functions get defined in hashset.c). The container encoding is
+ * used by int4hashset only.
+ */
+#define HASHSET_PREFIX int2hashset
+#define HASHSET_ELEMENT_TYPE int16
+#define HASHSET_ELEMENT_MIN PG_INT16_MIN
+#define HASHSET_DECLARE
+#include "hashset-type.h"
+
+#define HASHSET_PREFIX int4hashset
+#define HASHSET_ELEMENT_TYPE int32
+#define HASHSET_ELEMENT_MIN PG_INT32_MIN
+#define HASHSET_USE_CONTAINERS
+#define HASHSET_DECLARE
+#include "hashset-type.h"
+
+#define HASHSET_PREFIX int8hashset
+#define HASHSET_ELEMENT_TYPE int64
+#define HASHSET_ELEMENT_MIN PG_INT64_MIN
+#define HASHSET_DECLARE
+#include "hashset-type.h"
+
+/* IDs of the expanded objects, for debugging crosschecks */
+#define INT2HASHSET_EXPANDED_MAGIC 0x48534532
+#define INT4HASHSET_EXPANDED_MAGIC 0x48534554
+#define INT8HASHSET_EXPANDED_MAGIC 0x48534538
+
+/*
+ * PG_GETARG_INT4HASHSET returns a hash table (compact sets get rebuilt),
+ * PG_GETARG_INT4HASHSET_ANY may return either format and is meant for
+ * functions that only look at the header or iterate over the elements.
+ * PG_GETARG_INT4HASHSET_CACHED keeps the table rebuilt from a constant
+ * argument across calls, and PG_GETARG_INT4HASHSET_TABLE does the same but
+ * always returns a hash table (for functions doing many lookups).
+ */
+#define PG_GETARG_INT4HASHSET(x)			int4hashset_datum_get(PG_GETARG_DATUM(x))
+#define PG_GETARG_INT4HASHSET_ANY(x)		int4hashset_datum_get_any(PG_GETARG_DATUM(x))
+#define PG_GETARG_INT4HASHSET_CACHED(x)		int4hashset_getarg_cached(fcinfo, (x))
+#define PG_GETARG_INT4HASHSET_TABLE(x)		int4hashset_getarg_table(fcinfo, (x))
+#define PG_GETARG_INT4HASHSET_EXPANDED(x)	int4hashset_datum_get_expanded(PG_GETARG_DATUM(x))
+#define PG_RETURN_INT4HASHSET_EXPANDED(x)	PG_RETURN_DATUM(EOHPGetRWDatum(&(x)->hdr))
+
 bool hashset_isspace(char ch);
-Datum int32_to_array(FunctionCallInfo fcinfo, int32 *d, int len, bool null_element);
+bool hashset_arg_is_const(FmgrInfo *flinfo, int argno);
+void hashset_check_parameters(int32 capacity, float4 load_factor, float4 growth_factor, int32 hashfn_id);
+int64 hashset_agg_group_size(FunctionCallInfo fcinfo);
+int64 hashset_agg_resize_estimate(FunctionCallInfo fcinfo, int32 capacity, int64 nelements, float4 load_factor, float4 growth_factor);
+
+/*
+ * Access to hashsets of any of the integer types (identified by the OID of
+ * the element type), for the code shared by all of them - the planner
+ * support, statistics and GIN. The elements are widened to int64.
+ */
+int64 *hashset_datum_elements(Datum d, Oid elemtype, int *nelements, bool *null_element);
+int64 hashset_datum_element(Datum d, Oid elemtype);
+Datum hashset_element_datum(int64 value, Oid elemtype);
+Oid hashset_element_eq_operator(Oid elemtype);
+
+Size hashset_containers_length(const int32 *values, int nvalues);
+void hashset_containers_encode(char *data, const int32 *values, int nvalues);
+bool hashset_containers_contains(int4hashset_t *set, int32 value);
+int hashset_containers_filter(int4hashset_t *set, int4hashset_t *src, bool found, int32 *result);
+
+Datum hashset_gin_extract_value(FunctionCallInfo fcinfo, Oid elemtype);
+Datum hashset_gin_extract_query(FunctionCallInfo fcinfo, Oid elemtype);
+Datum hashset_sel(FunctionCallInfo fcinfo, Oid elemtype);
+Datum hashset_joinsel(FunctionCallInfo fcinfo, Oid elemtype);
+Datum hashset_typanalyze(FunctionCallInfo fcinfo, Oid elemtype);
+Selectivity hashset_contains_sel(PlannerInfo *root, List *args, int varRelid, bool is_join, SpecialJoinInfo *sjinfo, Oid elemtype);
 
 #endif /* HASHSET_H */
@@ -0,0 +1,27 @@
+/*
+ * hashset_agg with the expected number of elements
+ */
+SELECT hashset_cardinality(hashset_agg(i, 1000)), hashset_capacity(hashset_agg(i, 1000))
+FROM generate_series(1,10) AS i;
+
+SELECT hashset_agg(i, 1000, 0.5, 2) = hashset_agg(i),
+       hashset_capacity(hashset_agg(i, 1000, 0.5, 2))
+FROM generate_series(1,1500) AS i;
+
+SELECT hashset_agg(i, NULL) FROM generate_series(1,5) AS i;
+
+SELECT i % 2 AS g, hashset_agg(i, 10) FROM generate_series(1,6) AS i GROUP BY 1 ORDER BY 1;
+
+SELECT hashset_agg(i, -1) FROM generate_series(1,5) AS i;
+SELECT hashset_agg(i, 10, 1.5, 1) FROM generate_series(1,5) AS i;
+SELECT hashset_agg(i, 10, 0.75, 4) FROM generate_series(1,5) AS i;
+
+/*
+ * Without the hint, the state starts with a single group of slots, and the
+ * first resize jumps to the planner estimate of the group size
+ */
+SELECT hashset_cardinality(hashset_agg(i % 10)), hashset_capacity(hashset_agg(i % 10))
+FROM generate_series(1,1000) AS i;
+
+SELECT hashset_cardinality(hashset_agg(i % 100)), hashset_capacity(hashset_agg(i % 100))
+FROM generate_series(1,1000) AS i;
@@ -0,0 +1,117 @@
+/*
+ * approxhashset (exact up to the threshold, HyperLogLog sketch beyond it)
+ */
+SELECT hashset_cardinality(hashset_approx_agg(i)),
+       hashset_is_approximate(hashset_approx_agg(i))
+FROM generate_series(1,100) s(i);
+
+SELECT hashset_cardinality(hashset_approx_agg(i % 10)),
+       hashset_cardinality(hashset_approx_agg('k' || (i % 20))),
+       hashset_cardinality(hashset_approx_agg(i::bigint))
+FROM generate_series(1,100) s(i);
+
+-- NULL values are skipped
+SELECT hashset_cardinality(hashset_approx_agg(v))
+FROM (VALUES (1), (NULL), (1), (2)) t(v);
+
+-- the threshold
+SELECT hashset_cardinality(hashset_approx_agg(i, 1000)),
+       hashset_is_approximate(hashset_approx_agg(i, 1000)),
+       hashset_is_approximate(hashset_approx_agg(i, 999)),
+       hashset_is_approximate(hashset_approx_agg(i, 0))
+FROM generate_series(1,1000) s(i);
+
+SELECT hashset_approx_agg(i, -1) FROM generate_series(1,10) s(i);
+SELECT hashset_approx_agg(i, 10000000) FROM generate_series(1,10) s(i);
+
+-- past the threshold, the estimate should be within a few percent
+SELECT hashset_is_approximate(hashset_approx_agg(i)),
+       abs(hashset_cardinality(hashset_approx_agg(i)) - 100000) < 10000
+FROM generate_series(1,100000) s(i);
+
+SELECT abs(hashset_cardinality(hashset_approx_agg(i % 20000)) - 20000) < 2000
+FROM generate_series(1,100000) s(i);
+
+/*
+ * Unions
+ */
+SELECT hashset_cardinality(hashset_union(a, b)),
+       hashset_is_approximate(hashset_union(a, b))
+FROM (SELECT hashset_approx_agg(i) FROM generate_series(1,10) s(i)) x(a),
+     (SELECT hashset_approx_agg(i) FROM generate_series(5,15) s(i)) y(b);
+
+SELECT abs(hashset_cardinality(hashset_union(a, b)) - 100000) < 10000,
+       abs(hashset_cardinality(hashset_union(a, c)) - 60010) < 6000
+FROM (SELECT hashset_approx_agg(i) FROM generate_series(1,60000) s(i)) x(a),
+     (SELECT hashset_approx_agg(i) FROM generate_series(40001,100000) s(i)) y(b),
+     (SELECT hashset_approx_agg(i) FROM generate_series(1,10) s(i)) z(c);
+
+-- the union keeps the lower threshold
+SELECT hashset_is_approximate(hashset_union(a, b))
+FROM (SELECT hashset_approx_agg(i, 10) FROM generate_series(1,5) s(i)) x(a),
+     (SELECT hashset_approx_agg(i) FROM generate_series(6,15) s(i)) y(b);
+
+CREATE TABLE approxhashset_test (id int, s approxhashset);
+INSERT INTO approxhashset_test
+SELECT i % 10, hashset_approx_agg(i) FROM generate_series(1,50000) s(i) GROUP BY i % 10;
+
+SELECT count(*), bool_and(hashset_is_approximate(s)),
+       bool_and(abs(hashset_cardinality(s) - 5000) < 500)
+FROM approxhashset_test;
+
+SELECT abs(hashset_cardinality(hashset_approx_agg(s)) - 50000) < 5000
+FROM approxhashset_test;
+
+/*
+ * Text and binary I/O
+ */
+SELECT hashset_cardinality(s::text::approxhashset) = hashset_cardinality(s)
+FROM approxhashset_test WHERE id = 1;
+
+SELECT hashset_cardinality(a::text::approxhashset),
+       hashset_is_approximate(a::text::approxhashset)
+FROM (SELECT hashset_approx_agg(i) FROM generate_series(1,100) s(i)) x(a);
+
+SELECT '\x03'::approxhashset;
+
+-- sets in the version 1 format (without the type) merge with any type
+SELECT hashset_cardinality(hashset_union('\x01000000006400000001000000000000002a'::approxhashset,
+                                         hashset_approx_agg(i)))
+FROM generate_series(1,10) s(i);
+
+/*
+ * Sets of different types can't be merged
+ */
+SELECT hashset_union(hashset_approx_agg(i), hashset_approx_agg(i::bigint))
+FROM generate_series(1,10) s(i);
+
+SELECT hashset_approx_agg(s)
+FROM (SELECT hashset_approx_agg(i) FROM generate_series(1,10) s(i)
+      UNION ALL
+      SELECT hashset_approx_agg(i::text) FROM generate_series(1,10) s(i)) x(s);
+
+/*
+ * Parallel aggregation
+ */
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+
+CREATE TABLE approxhashset_parallel_test AS
+    SELECT i, (i % 100) AS j FROM generate_series(1,100000) s(i);
+ANALYZE approxhashset_parallel_test;
+
+EXPLAIN (COSTS OFF) SELECT hashset_approx_agg(i) FROM approxhashset_parallel_test;
+
+SELECT abs(hashset_cardinality(hashset_approx_agg(i)) - 100000) < 10000,
+       hashset_cardinality(hashset_approx_agg(j))
+FROM approxhashset_parallel_test;
+
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+
+DROP TABLE approxhashset_parallel_test;
+DROP TABLE approxhashset_test;
@@ -0,0 +1,28 @@
+/*
+ * Building hashsets from int4[] arrays
+ */
+SELECT hashset_from_array('{3,1,2,3}'::int4[]);
+SELECT hashset_from_array('{1,NULL,2,NULL}'::int4[]);
+SELECT hashset_from_array('{}'::int4[]);
+SELECT '{{1,2},{3,4}}'::int4[]::int4hashset;
+SELECT ARRAY[1,2]::int4hashset = '{1,2}'::int4hashset;
+
+SELECT hashset_cardinality(hashset_from_array(array_agg(i))),
+       hashset_capacity(hashset_from_array(array_agg(i)))
+FROM generate_series(1,1000) AS i;
+
+SELECT hashset_from_array(array_agg(i % 100)) = hashset_agg(i % 100)
+FROM generate_series(1,10000) AS i;
+
+/*
+ * Aggregating arrays, NULL arrays and NULL elements are skipped
+ */
+SELECT hashset_agg(a)
+FROM (VALUES ('{1,2}'::int4[]), ('{2,3}'), (NULL), ('{NULL,4}'), ('{}')) AS v(a);
+
+SELECT hashset_agg(a) FROM (VALUES (NULL::int4[])) AS v(a);
+
+SELECT hashset_cardinality(hashset_agg(a))
+FROM (
+    SELECT array_agg(i) AS a FROM generate_series(1,10000) AS i GROUP BY i % 7
+) q;
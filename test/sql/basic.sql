@@ -26,7 +26,8 @@ SELECT hashset_contains('{123,456}'::int4hashset, 789); -- false
 SELECT hashset_union('{1,2}'::int4hashset, '{2,3}'::int4hashset);
 SELECT hashset_to_array('{1,2,3}'::int4hashset);
 SELECT hashset_cardinality('{1,2,3}'::int4hashset); -- 3
-SELECT hashset_capacity(int4hashset(capacity := 10)); -- 10
+SELECT hashset_capacity(int4hashset(capacity := 10)); -- 16
+SELECT int4hashset(capacity := 200000000); -- rounded up to 2^28 slots
 SELECT hashset_intersection('{1,2}'::int4hashset,'{2,3}'::int4hashset);
 SELECT hashset_difference('{1,2}'::int4hashset,'{2,3}'::int4hashset);
 SELECT hashset_symmetric_difference('{1,2}'::int4hashset,'{2,3}'::int4hashset);
@@ -86,6 +87,16 @@ FROM
     SELECT '{3,2,1}'::int4hashset AS h
 ) q;
 
+SELECT hashset_hash(int4hashset(hashfn_id := 2) || 1 || 2 || 3) = hashset_hash('{1,2,3}'::int4hashset),
+       hashset_hash(int4hashset(hashfn_id := 3) || 3 || 2 || 1) = hashset_hash('{1,2,3}'::int4hashset),
+       hashset_hash('{1,NULL}'::int4hashset) <> hashset_hash('{1}'::int4hashset);
+
+SELECT hashset_hash_extended('{1,2,3}'::int4hashset, 0),
+       hashset_hash_extended('{1,2,3}'::int4hashset, 1);
+
+SELECT hashset_hash_extended(h, 0) & 4294967295 = hashset_hash(h)::bigint & 4294967295
+FROM (VALUES ('{}'::int4hashset), ('{NULL}'), ('{1,2,3}'), ('{-1,0,1,NULL}')) AS v(h);
+
 /*
  * Hashset Btree Operators
  *
@@ -0,0 +1,46 @@
+/*
+ * Batched membership checks, with the same NULL semantics as
+ * hashset_contains() combined over the array elements
+ */
+SELECT hashset_contains_any('{1,2}'::int4hashset, '{2,3}');
+SELECT hashset_contains_any('{1,2}'::int4hashset, '{3,4}');
+SELECT hashset_contains_any('{1,2}'::int4hashset, '{3,NULL}');
+SELECT hashset_contains_any('{1,2,NULL}'::int4hashset, '{3}');
+SELECT hashset_contains_any('{}'::int4hashset, '{NULL}');
+SELECT hashset_contains_any('{1}'::int4hashset, '{}');
+
+SELECT hashset_contains_all('{1,2}'::int4hashset, '{2,1,2}');
+SELECT hashset_contains_all('{1,2}'::int4hashset, '{2,3}');
+SELECT hashset_contains_all('{1,2}'::int4hashset, '{2,NULL}');
+SELECT hashset_contains_all('{1,NULL}'::int4hashset, '{1,3}');
+SELECT hashset_contains_all('{}'::int4hashset, '{}');
+SELECT hashset_contains_all('{}'::int4hashset, '{NULL}');
+
+SELECT hashset_contains_each('{1,2}'::int4hashset, '{2,3,NULL}');
+SELECT hashset_contains_each('{1,NULL}'::int4hashset, '{1,2}');
+SELECT hashset_contains_each('{}'::int4hashset, '{1,NULL}');
+SELECT hashset_contains_each('{1}'::int4hashset, '{{1,2},{3,1}}');
+SELECT hashset_contains_each('{1}'::int4hashset, '{}');
+
+SELECT hashset_filter('{5,1,3,1,NULL}', '{1,3}'::int4hashset);
+SELECT hashset_filter('{5}', '{1}'::int4hashset);
+
+/*
+ * Arrays spanning multiple batches
+ */
+SELECT cardinality(hashset_filter(a, s)),
+       hashset_contains_all(s, hashset_filter(a, s)),
+       hashset_contains_any(s, a)
+FROM (SELECT array_agg(i) AS a FROM generate_series(1,1000) AS i) q,
+     (SELECT hashset_agg(i) AS s FROM generate_series(1,1000,3) AS i) r;
+
+SELECT count(*) FILTER (WHERE f), count(*) FILTER (WHERE NOT f)
+FROM unnest(hashset_contains_each(
+       (SELECT hashset_agg(i) FROM generate_series(1,1000,3) AS i),
+       (SELECT array_agg(i) FROM generate_series(1,1000) AS i))) AS f;
+
+/*
+ * Constant hashset, with the hash table cached across calls
+ */
+SELECT count(*) FROM generate_series(1,1000) AS i
+WHERE hashset_contains_any('{1,2,3,500,2000}'::int4hashset, ARRAY[i, -i]);
@@ -0,0 +1,65 @@
+/*
+ * Bloom filters built from hashsets
+ */
+SELECT hashset_to_bloom('{1,2,3}', 0.1);
+SELECT hashset_to_bloom('{1,2,3}', 0.1)::text::int4bloom::text = hashset_to_bloom('{1,2,3}', 0.1)::text;
+
+SELECT bloom_contains(hashset_to_bloom('{1,2,3}'), 1),
+       bloom_contains(hashset_to_bloom('{1,2,3}'), 3),
+       bloom_contains(hashset_to_bloom('{1,2,3}'), 4),
+       hashset_to_bloom('{1,2,3}') @> 2,
+       bloom_contains(hashset_to_bloom('{}'), 1);
+
+CREATE TABLE int4bloom_test (id int, s int4hashset, b int4bloom);
+INSERT INTO int4bloom_test
+SELECT 1, s, hashset_to_bloom(s) FROM (SELECT hashset_agg(i * 7) FROM generate_series(1,10000) i) x(s);
+INSERT INTO int4bloom_test
+SELECT 2, s, hashset_to_bloom(s, 0.001) FROM (SELECT hashset_agg(i) FROM generate_series(1,100000) i) x(s);
+
+-- no false negatives
+SELECT id, count(*) FILTER (WHERE NOT bloom_contains(b, e))
+FROM int4bloom_test, hashset_elements(s) e GROUP BY id ORDER BY id;
+
+-- false positives, close to the requested rate
+SELECT count(*) FILTER (WHERE bloom_contains(b, i) AND NOT hashset_contains(s, i))
+FROM int4bloom_test, generate_series(1,100000) i WHERE id = 1;
+
+SELECT count(*) FILTER (WHERE bloom_contains(b, i))
+FROM int4bloom_test, generate_series(100001,200000) i WHERE id = 2;
+
+SELECT id, (length(b::text) - 2) / 2 AS bytes FROM int4bloom_test ORDER BY id;
+
+/*
+ * bloom_contains_any
+ */
+SELECT bloom_contains_any(hashset_to_bloom('{1,2,3}'), '{4,5,3}'),
+       bloom_contains_any(hashset_to_bloom('{1,2,3}'), '{4,5,6}'),
+       bloom_contains_any(hashset_to_bloom('{1,2,3}'), '{4,NULL}'),
+       bloom_contains_any(hashset_to_bloom('{1,2,3}'), '{1,NULL}'),
+       bloom_contains_any(hashset_to_bloom('{1,2,3}'), '{}');
+
+SELECT bloom_contains_any(b, (SELECT array_agg(i) FROM generate_series(70001,70100) i)),
+       bloom_contains_any(b, (SELECT array_agg(i) FROM generate_series(-100,-1) i))
+FROM int4bloom_test WHERE id = 1;
+
+/*
+ * Union of filters with the same parameters
+ */
+SELECT bloom_union(hashset_to_bloom('{1,2}', 0.01, 1000),
+                   hashset_to_bloom('{3,4}', 0.01, 1000))::text
+     = hashset_to_bloom('{1,2,3,4}', 0.01, 1000)::text;
+
+SELECT bloom_contains(bloom_union(hashset_to_bloom('{1,2}', 0.01, 1000),
+                                  hashset_to_bloom('{3,4}', 0.01, 1000)), 3);
+
+SELECT bloom_union(hashset_to_bloom('{1,2}'), hashset_to_bloom('{1,2,3,4,5,6,7,8,9,10}'));
+
+/*
+ * Invalid parameters
+ */
+SELECT hashset_to_bloom('{1,2,3}', 0);
+SELECT hashset_to_bloom('{1,2,3}', 1.5);
+SELECT hashset_to_bloom('{1,2,3}', 0.01, -1);
+SELECT '\x01000000400000001000000000'::int4bloom;
+
+DROP TABLE int4bloom_test;
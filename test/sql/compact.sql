@@ -0,0 +1,25 @@
+/*
+ * Compact on-disk format
+ *
+ * Stored hashsets contain only the sorted (delta-encoded) elements, the hash
+ * table gets rebuilt when needed. The header (capacity etc.) is preserved.
+ */
+CREATE TABLE hashset_compact_test AS
+SELECT hashset_agg(i) AS s FROM generate_series(1,1000) AS i;
+
+SELECT pg_column_size(s) FROM hashset_compact_test;
+SELECT hashset_cardinality(s) FROM hashset_compact_test;
+SELECT hashset_contains(s, 500), hashset_contains(s, 1001) FROM hashset_compact_test;
+SELECT hashset_to_array(s) = hashset_to_sorted_array(s) FROM hashset_compact_test;
+SELECT hashset_cardinality(hashset_add(s, 1001)) FROM hashset_compact_test;
+SELECT s = (SELECT hashset_agg(i) FROM generate_series(1,1000) AS i) FROM hashset_compact_test;
+
+CREATE TABLE hashset_compact_values (s int4hashset);
+INSERT INTO hashset_compact_values VALUES
+    ('{}'),
+    ('{NULL}'),
+    ('{2147483647,-2147483648,0,-1,1}'),
+    (hashset_add(int4hashset(capacity := 100), 42));
+
+SELECT s, hashset_cardinality(s), hashset_capacity(s) FROM hashset_compact_values;
+SELECT hashset_contains(s, -2147483648) FROM hashset_compact_values;
@@ -0,0 +1,48 @@
+/*
+ * Container encoding of compact hashsets
+ *
+ * Sets of clustered elements are stored as chunks of runs, bitmaps or sorted
+ * arrays, whenever that's smaller than the varints.
+ */
+SELECT pg_column_size(hashset_agg(i)) FROM generate_series(1,100000) AS i;
+SELECT pg_column_size(hashset_agg(i * 2)) FROM generate_series(0,99999) AS i;
+SELECT pg_column_size(hashset_agg(i)) FROM generate_series(-100000,100000) AS i;
+SELECT pg_column_size(hashset_agg(i)) FROM (SELECT generate_series(1,1000) UNION ALL VALUES (70000), (70010)) AS t(i);
+
+CREATE TABLE hashset_containers_test (name text, s int4hashset);
+INSERT INTO hashset_containers_test
+SELECT 'runs', hashset_agg(i) FROM generate_series(1,100000) AS i;
+INSERT INTO hashset_containers_test
+SELECT 'bitmap', hashset_agg(i * 2) FROM generate_series(0,99999) AS i;
+INSERT INTO hashset_containers_test
+SELECT 'negative', hashset_agg(i) FROM generate_series(-100000,100000) AS i;
+INSERT INTO hashset_containers_test
+SELECT 'array', hashset_agg(i) FROM (SELECT generate_series(1,1000) UNION ALL VALUES (70000), (70010)) AS t(i);
+
+SELECT name, hashset_cardinality(s), (SELECT sum(x) FROM hashset_elements(s) AS x)
+FROM hashset_containers_test ORDER BY name;
+
+SELECT name, hashset_contains(s, 1000), hashset_contains(s, 1001),
+       hashset_contains(s, 70010), hashset_contains(s, -50000)
+FROM hashset_containers_test ORDER BY name;
+
+SELECT name, hashset_to_array(s) = hashset_to_sorted_array(s), s::text::int4hashset = s
+FROM hashset_containers_test ORDER BY name;
+
+-- equality with a hash table
+SELECT name, hashset_add(s, 0) = s, hashset_add(s, 1000) = s
+FROM hashset_containers_test ORDER BY name;
+
+-- lookups of elements of a hash table in the containers
+SELECT name, hashset_to_sorted_array(hashset_intersection(s, '{5,6,70000,-3}')),
+       hashset_to_sorted_array(hashset_difference('{5,6,70000,-3}', s))
+FROM hashset_containers_test ORDER BY name;
+
+-- chunk by chunk intersections
+SELECT a.name, b.name, hashset_cardinality(hashset_intersection(a.s, b.s)),
+       hashset_cardinality(hashset_difference(a.s, b.s)),
+       hashset_cardinality(hashset_symmetric_difference(a.s, b.s))
+FROM hashset_containers_test a, hashset_containers_test b
+WHERE a.name < b.name ORDER BY a.name, b.name;
+
+DROP TABLE hashset_containers_test;
@@ -0,0 +1,91 @@
+CREATE OR REPLACE FUNCTION explain_rows(query text)
+RETURNS float8
+AS $$
+DECLARE
+    plan json;
+BEGIN
+    EXECUTE 'EXPLAIN (FORMAT JSON) ' || query INTO plan;
+    RETURN plan->0->'Plan'->>'Plan Rows';
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TABLE hashset_contains_test (id int PRIMARY KEY, val int);
+
+INSERT INTO hashset_contains_test
+SELECT i, i % 100 FROM generate_series(1,10000) AS i;
+
+ANALYZE hashset_contains_test;
+
+SET enable_bitmapscan = off;
+
+/*
+ * hashset_contains(set, column) uses a btree index on the column
+ */
+EXPLAIN (COSTS OFF)
+SELECT * FROM hashset_contains_test WHERE hashset_contains('{3,1,2,NULL}', id);
+
+SELECT id FROM hashset_contains_test WHERE hashset_contains('{3,1,2,NULL}', id);
+
+SET plan_cache_mode = force_generic_plan;
+
+PREPARE hashset_contains_q(int4hashset) AS
+SELECT id FROM hashset_contains_test WHERE hashset_contains($1, id);
+
+EXPLAIN (COSTS OFF) EXECUTE hashset_contains_q('{5,7}');
+
+EXECUTE hashset_contains_q('{5,7}');
+
+DEALLOCATE hashset_contains_q;
+
+RESET plan_cache_mode;
+
+CREATE TABLE hashset_contains_frontier AS
+SELECT '{10,20,30}'::int4hashset AS nodes;
+
+ANALYZE hashset_contains_frontier;
+
+EXPLAIN (COSTS OFF)
+SELECT t.id FROM hashset_contains_frontier f
+  JOIN hashset_contains_test t ON hashset_contains(f.nodes, t.id);
+
+SELECT t.id FROM hashset_contains_frontier f
+  JOIN hashset_contains_test t ON hashset_contains(f.nodes, t.id);
+
+/*
+ * Trivial sets are simplified
+ */
+EXPLAIN (COSTS OFF)
+SELECT * FROM hashset_contains_test WHERE hashset_contains('{42}', id);
+
+SELECT hashset_contains('{1}', v), hashset_contains('{}', v)
+FROM (VALUES (1), (2), (NULL)) AS t(v);
+
+SELECT count(*) FROM hashset_contains_test WHERE hashset_contains('{}', id);
+
+/*
+ * Estimates
+ */
+SELECT explain_rows($$SELECT * FROM hashset_contains_test WHERE hashset_contains('{1,2,3}', id)$$),
+       explain_rows($$SELECT * FROM hashset_contains_test WHERE hashset_contains('{1,2,3}', val)$$);
+
+RESET enable_bitmapscan;
+
+/*
+ * hashset_contains(column, value) uses a GIN index on the column
+ */
+CREATE TABLE hashset_contains_gin AS
+SELECT i, hashset_from_array(ARRAY[i % 100, i % 101]) AS s
+FROM generate_series(1,10000) AS i;
+
+CREATE INDEX ON hashset_contains_gin USING gin (s);
+
+ANALYZE hashset_contains_gin;
+
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM hashset_contains_gin WHERE hashset_contains(s, 7);
+
+SELECT count(*) FROM hashset_contains_gin WHERE hashset_contains(s, 7);
+
+DROP TABLE hashset_contains_gin;
+DROP TABLE hashset_contains_frontier;
+DROP TABLE hashset_contains_test;
@@ -0,0 +1,32 @@
+/*
+ * Returning the elements as rows
+ */
+SELECT hashset_elements('{3,1,2}'::int4hashset) AS x ORDER BY x;
+SELECT x FROM hashset_elements('{1,NULL,2}'::int4hashset) AS x ORDER BY x;
+SELECT hashset_elements('{}'::int4hashset);
+SELECT hashset_elements(NULL::int4hashset);
+
+SELECT count(*), count(x), sum(x)
+FROM hashset_elements((SELECT hashset_agg(i) FROM generate_series(1,1000) AS i)) AS x;
+
+SELECT count(*), sum(x)
+FROM (VALUES ('{1,2}'::int4hashset), ('{}'), ('{3,NULL}')) AS v(s),
+     LATERAL hashset_elements(s) AS x;
+
+/*
+ * Row estimates, from the cardinality of constant sets
+ */
+CREATE OR REPLACE FUNCTION explain_rows(query text)
+RETURNS float8
+AS $$
+DECLARE
+    plan json;
+BEGIN
+    EXECUTE 'EXPLAIN (FORMAT JSON) ' || query INTO plan;
+    RETURN plan->0->'Plan'->>'Plan Rows';
+END;
+$$ LANGUAGE plpgsql;
+
+SELECT explain_rows($$SELECT * FROM hashset_elements('{1,2,3,4,5}'::int4hashset)$$);
+SELECT explain_rows($$SELECT * FROM hashset_elements('{1,NULL}'::int4hashset)$$);
+SELECT explain_rows($$SELECT hashset_elements(s) FROM (VALUES ('{1,2}'::int4hashset)) AS v(s)$$);
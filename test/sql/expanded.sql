@@ -0,0 +1,48 @@
+/*
+ * Expanded (read/write) hashsets
+ *
+ * hashset_add() and hashset_union() modify the set in place when they get
+ * a read/write expanded datum, e.g. when the calls are nested or when the
+ * set is a PL/pgSQL variable. The inputs must never be modified otherwise.
+ *
+ * PL/pgSQL passes the variable as a read/write datum only since PostgreSQL
+ * 18 (SupportRequestModifyInPlace), older versions copy the set for each
+ * assignment. The results below must be the same either way.
+ */
+SELECT hashset_sorted(hashset_add(hashset_add(hashset_add(int4hashset(), 1), 2), 3));
+SELECT hashset_sorted(hashset_union(hashset_add('{1,2}'::int4hashset, 3), '{3,4}'::int4hashset));
+SELECT hashset_to_sorted_array(hashset_add(hashset_add(NULL, 1), NULL));
+
+CREATE OR REPLACE FUNCTION hashset_build(n int)
+RETURNS int4hashset AS
+$$
+DECLARE
+    s int4hashset := int4hashset();
+BEGIN
+    FOR i IN 1..n LOOP
+        s := hashset_add(s, i);
+        s := s || (i + n);
+    END LOOP;
+    RETURN s;
+END;
+$$ LANGUAGE plpgsql;
+
+SELECT hashset_cardinality(hashset_build(1000));
+SELECT hashset_contains(hashset_build(1000), 2000);
+SELECT hashset_contains(hashset_build(1000), 2001);
+
+DO $$
+DECLARE
+    a int4hashset := '{1,2}';
+    b int4hashset;
+BEGIN
+    b := hashset_add(a, 3);
+    a := hashset_union(a, a);
+    RAISE NOTICE '% %', hashset_to_sorted_array(a), hashset_to_sorted_array(b);
+END;
+$$;
+
+CREATE TABLE hashset_expanded_test AS SELECT hashset_build(100) AS s;
+SELECT hashset_cardinality(s) FROM hashset_expanded_test;
+SELECT hashset_sorted(hashset_add(s, 1)) = hashset_sorted(s) FROM hashset_expanded_test;
+DROP TABLE hashset_expanded_test;
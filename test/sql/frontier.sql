@@ -0,0 +1,49 @@
+/*
+ * Aggregates skipping the elements of a visited set
+ */
+CREATE TABLE hashset_frontier_edges (from_node int, to_node int);
+INSERT INTO hashset_frontier_edges VALUES
+    (1, 2), (1, 3), (2, 3), (2, 4), (3, 1), (3, 5), (4, 6), (5, 6), (6, 1), (6, NULL);
+
+SELECT hashset_agg_excluding(to_node, '{1,2}') FROM hashset_frontier_edges;
+SELECT hashset_agg_excluding(to_node, NULL) FROM hashset_frontier_edges;
+SELECT hashset_agg_excluding(to_node, '{1,2,3,4,5,6}') FROM hashset_frontier_edges;
+SELECT hashset_agg_excluding(to_node, '{1}') FROM hashset_frontier_edges WHERE false;
+
+SELECT from_node, hashset_agg_excluding(to_node, '{3}')
+FROM hashset_frontier_edges GROUP BY from_node ORDER BY from_node;
+
+-- a different visited set for each row
+SELECT hashset_agg_excluding(to_node, CASE WHEN from_node < 3 THEN '{3}'::int4hashset ELSE '{6}' END)
+FROM hashset_frontier_edges;
+
+-- the visited set from a table, the same for consecutive rows
+CREATE TABLE hashset_frontier_visited (from_node int, visited int4hashset);
+INSERT INTO hashset_frontier_visited VALUES
+    (1, '{3}'), (2, '{3}'), (3, '{6}'), (4, '{6}'), (5, '{6}'), (6, '{6}');
+
+SELECT hashset_agg_excluding(e.to_node, v.visited)
+FROM hashset_frontier_edges e JOIN hashset_frontier_visited v USING (from_node);
+
+SELECT (hashset_agg_frontier(to_node, '{1,NULL}')).* FROM hashset_frontier_edges;
+SELECT (hashset_agg_frontier(to_node, NULL)).* FROM hashset_frontier_edges;
+
+-- breadth-first search, one pass over the edges for each level
+WITH RECURSIVE bfs AS (
+    SELECT 0 AS depth, '{1}'::int4hashset AS frontier, '{1}'::int4hashset AS visited
+    UNION ALL
+    SELECT bfs.depth + 1, (q.f).frontier, (q.f).visited
+    FROM bfs CROSS JOIN LATERAL (
+        SELECT hashset_agg_frontier(e.to_node, bfs.visited) AS f
+        FROM hashset_elements(bfs.frontier) AS n(node)
+        JOIN hashset_frontier_edges e ON e.from_node = n.node
+    ) q
+    WHERE hashset_cardinality(bfs.frontier) > 0
+)
+SELECT depth, frontier, visited FROM bfs ORDER BY depth;
+
+-- the visited set has to be the same for all rows
+SELECT hashset_agg_frontier(to_node, hashset_add(int4hashset(), from_node)) FROM hashset_frontier_edges;
+
+DROP TABLE hashset_frontier_edges;
+DROP TABLE hashset_frontier_visited;
@@ -0,0 +1,70 @@
+/*
+ * Containment and overlap operators
+ */
+SELECT '{1,2,3}'::int4hashset @> '{1,2}',
+       '{1,2}'::int4hashset @> '{1,2,3}',
+       '{1,2}'::int4hashset <@ '{1,2,3}',
+       '{1,2}'::int4hashset && '{2,3}',
+       '{1,2}'::int4hashset && '{3,4}',
+       '{}'::int4hashset <@ '{}',
+       '{}'::int4hashset && '{}';
+
+SELECT '{1,NULL}'::int4hashset @> '{NULL}',
+       '{1}'::int4hashset @> '{1,NULL}',
+       '{1,NULL}'::int4hashset && '{2,NULL}',
+       '{1,2}'::int4hashset @> 2,
+       '{1,2}'::int4hashset @> 3,
+       '{1,NULL}'::int4hashset @> 3;
+
+/*
+ * Operators on hash tables and compact sets
+ */
+SELECT hashset_agg(i) @> '{10,20,30}',
+       hashset_agg(i) FILTER (WHERE i % 2 = 0) <@ hashset_agg(i),
+       hashset_agg(i) FILTER (WHERE i % 2 = 0) && hashset_agg(i) FILTER (WHERE i % 2 = 1),
+       hashset_agg(i) FILTER (WHERE i % 2 = 0) && hashset_agg(i) FILTER (WHERE i % 3 = 0)
+FROM generate_series(1,1000) AS i;
+
+/*
+ * GIN index
+ */
+CREATE TABLE hashset_gin_test AS
+SELECT i, CASE WHEN i % 100 = 0 THEN hashset_add(s, NULL) ELSE s END AS s
+FROM (SELECT i, hashset_agg(j) AS s
+      FROM generate_series(1,1000) AS i, generate_series(1,20) AS j
+      WHERE i % j = 0
+      GROUP BY i) AS x;
+
+INSERT INTO hashset_gin_test VALUES (0, '{}'), (-1, NULL);
+
+CREATE INDEX ON hashset_gin_test USING gin (s);
+
+SET enable_seqscan = off;
+
+EXPLAIN (COSTS OFF) SELECT count(*) FROM hashset_gin_test WHERE s @> 7;
+
+SELECT count(*) FROM hashset_gin_test WHERE s @> 7;
+
+SELECT count(*) FROM hashset_gin_test WHERE s @> '{2,3}';
+
+SELECT count(*) FROM hashset_gin_test WHERE s @> '{}';
+
+SELECT count(*) FROM hashset_gin_test WHERE s @> '{NULL}';
+
+SELECT count(*) FROM hashset_gin_test WHERE s <@ '{1,2,3,4,5,6}';
+
+SELECT count(*) FROM hashset_gin_test WHERE s <@ '{1,2,4,5,10,20,25,50,NULL}';
+
+SELECT count(*) FROM hashset_gin_test WHERE s && '{11,13}';
+
+SELECT count(*) FROM hashset_gin_test WHERE s && '{19,NULL}';
+
+SELECT count(*) FROM hashset_gin_test WHERE s && '{}';
+
+SELECT count(*) FROM hashset_gin_test WHERE s = '{1,2,4}';
+
+SELECT array_agg(i ORDER BY i) FROM hashset_gin_test WHERE s = '{}';
+
+RESET enable_seqscan;
+
+DROP TABLE hashset_gin_test;
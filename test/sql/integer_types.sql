@@ -0,0 +1,194 @@
+/*
+ * int8hashset and int2hashset (generated from the same template)
+ */
+SELECT '{3,1,2,NULL}'::int8hashset, '{3,1,2,NULL}'::int2hashset;
+SELECT '{9223372036854775807,-9223372036854775808,0,4294967296}'::int8hashset;
+SELECT '{32767,-32768}'::int2hashset;
+SELECT '{32768}'::int2hashset;
+SELECT '{9223372036854775808}'::int8hashset;
+SELECT '{1,a}'::int8hashset;
+
+/*
+ * Elements that differ only in the high bits are distinct
+ */
+SELECT hashset_cardinality('{1,4294967297,-4294967295}'::int8hashset),
+       hashset_contains('{1,4294967297}'::int8hashset, 4294967297),
+       hashset_contains('{1,4294967297}'::int8hashset, 8589934593);
+
+SELECT hashset_add('{1}'::int8hashset, 5000000000),
+       '{1}'::int8hashset || 2::bigint,
+       3::bigint || '{1}'::int8hashset,
+       hashset_add(NULL::int2hashset, NULL),
+       hashset_add('{1}'::int2hashset, 2::smallint);
+
+-- element || set is strict for all the types
+SELECT NULL::bigint || '{1}'::int8hashset,
+       2::smallint || NULL::int2hashset,
+       NULL::int || '{1}'::int4hashset;
+
+-- untyped literals resolve by the element argument, or need a cast
+SELECT hashset_add('{1}', 2), hashset_contains('{1}', 1);
+SELECT hashset_cardinality('{1,2}');
+SELECT hashset_cardinality('{1,2}'::int4hashset);
+
+/*
+ * Contains (same NULL semantics as int4hashset)
+ */
+SELECT hashset_contains('{1,2}'::int8hashset, 2),
+       hashset_contains('{1,2}'::int8hashset, 3),
+       hashset_contains('{1,NULL}'::int8hashset, 3),
+       hashset_contains('{}'::int8hashset, NULL),
+       hashset_contains('{1}'::int2hashset, 1::smallint),
+       '{1,2}'::int2hashset @> 2::smallint;
+
+SELECT hashset_contains_any('{1,2}'::int8hashset, '{2,3}'),
+       hashset_contains_any('{1,2}'::int8hashset, '{3,NULL}'),
+       hashset_contains_all('{1,2}'::int8hashset, '{2,1}'),
+       hashset_contains_all('{1,2}'::int8hashset, '{2,3}'),
+       hashset_contains_all('{1,NULL}'::int2hashset, '{1,3}');
+
+SELECT hashset_contains_each('{1,2,NULL}'::int8hashset, '{2,5000000000,NULL}'),
+       hashset_contains_each('{1,2}'::int2hashset, '{{1,3},{2,NULL}}'),
+       hashset_contains_each('{}'::int8hashset, '{1,NULL}'),
+       hashset_filter('{5,1,3,1,NULL}'::bigint[], '{1,3}'::int8hashset),
+       hashset_filter('{5,1}'::smallint[], '{3}'::int2hashset);
+
+/*
+ * Set operations and comparisons
+ */
+SELECT hashset_union('{1,2}'::int8hashset, '{2,3,NULL}'),
+       hashset_intersection('{1,2,NULL}'::int8hashset, '{2,3,NULL}'),
+       hashset_difference('{1,2,NULL}'::int8hashset, '{2,3}'),
+       hashset_symmetric_difference('{1,2}'::int8hashset, '{2,3}');
+
+SELECT hashset_union('{1,2}'::int2hashset, '{2,3}'),
+       hashset_intersection('{1,2}'::int2hashset, '{2,3}'),
+       hashset_difference('{1,2}'::int2hashset, '{2,3}'),
+       hashset_symmetric_difference('{1,2}'::int2hashset, '{2,3}');
+
+SELECT '{1,2}'::int8hashset = '{2,1}', '{1,2}'::int8hashset <> '{1}',
+       '{1,2,3}'::int8hashset @> '{3,1}', '{1}'::int8hashset <@ '{1,2}',
+       '{1,2}'::int8hashset && '{2,3}', '{1,2}'::int8hashset && '{3}',
+       '{1,2}'::int2hashset = '{2,1}', '{1,2}'::int2hashset && '{3}';
+
+SELECT hashset_hash('{1,2,3}'::int2hashset) = hashset_hash('{1,2,3}'::int4hashset),
+       hashset_hash('{1,2,3}'::int8hashset) = hashset_hash('{3,2,1}'::int8hashset),
+       hashset_cmp('{1,2}'::int8hashset, '{2,1}');
+
+SELECT hashset_cardinality(hashset_intersection(a, b)),
+       hashset_cardinality(hashset_difference(a, b)),
+       hashset_cardinality(hashset_symmetric_difference(a, b)),
+       a @> hashset_intersection(a, b), a && b, a <@ b
+FROM (SELECT hashset_agg(i::bigint) FILTER (WHERE i <= 700) AS a,
+             hashset_agg(i::bigint) FILTER (WHERE i > 300) AS b
+      FROM generate_series(1,1000) AS i) s;
+
+/*
+ * Arrays, elements and aggregates
+ */
+SELECT hashset_to_sorted_array('{5000000000,1,NULL}'::int8hashset),
+       hashset_to_sorted_array('{3,-1}'::int2hashset),
+       '{3,1,3,NULL}'::bigint[]::int8hashset,
+       int2hashset_from_array('{3,1,3}');
+
+SELECT x FROM hashset_elements('{3,1,2}'::int8hashset) AS x ORDER BY x;
+
+SELECT hashset_cardinality(hashset_agg(i::bigint * 4294967296)),
+       hashset_cardinality(hashset_agg((i % 1000)::smallint))
+FROM generate_series(1,10000) AS i;
+
+SELECT hashset_agg(s), hashset_agg(a)
+FROM (VALUES ('{1,2}'::int8hashset, '{1,NULL}'::bigint[]),
+             ('{2,3}', '{4}'),
+             (NULL, NULL)) AS v(s, a);
+
+SELECT hashset_agg(i::bigint) = hashset_union(hashset_agg(i::bigint) FILTER (WHERE i <= 5000),
+                                               hashset_agg(i::bigint) FILTER (WHERE i > 5000))
+FROM generate_series(1,10000) AS i;
+
+/*
+ * Expanded sets - hashset_add() and || modify a PL/pgSQL variable in place,
+ * but never their other inputs
+ */
+DO $$
+DECLARE
+    a int8hashset := '{1,2}';
+    b int8hashset;
+    s int2hashset := int2hashset();
+BEGIN
+    b := hashset_add(a, 5000000000);
+    FOR i IN 1..1000 LOOP
+        s := hashset_add(s, i::smallint);
+        s := (-i)::smallint || s;
+    END LOOP;
+    RAISE NOTICE '% % %', hashset_to_sorted_array(a), hashset_to_sorted_array(b),
+        hashset_cardinality(s);
+END;
+$$;
+
+/*
+ * Parameters
+ */
+SELECT hashset_capacity(int8hashset(capacity := 100)),
+       hashset_capacity(int2hashset(capacity := 10)),
+       hashset_capacity(hashset_add(int8hashset(), 1));
+SELECT int8hashset(load_factor := 1.5);
+SELECT int2hashset(hashfn_id := 4);
+SELECT hashset_to_sorted_array(hashset_union(int8hashset(hashfn_id := 2), '{5000000000,-1}')),
+       hashset_to_sorted_array(hashset_union(int8hashset(hashfn_id := 3), '{5000000000,-1}'));
+
+/*
+ * Removing elements and compact storage
+ */
+SELECT hashset_remove('{1,5000000000,NULL}'::int8hashset, 5000000000::bigint),
+       '{1,2,3}'::int2hashset - 2::smallint,
+       '{1,2,3,NULL}'::int8hashset - ARRAY[1,3,NULL]::bigint[],
+       hashset_compact(hashset_remove('{1,2}'::int2hashset, 1::smallint));
+
+CREATE TABLE integer_types_test AS
+SELECT i, ARRAY[0, i % 10, i]::bigint[]::int8hashset AS s8,
+       ARRAY[0, i % 10]::smallint[]::int2hashset AS s2
+FROM generate_series(1,10000) AS i;
+
+INSERT INTO integer_types_test
+SELECT 0, hashset_agg(i::bigint * 4294967296, 1000), hashset_agg(i::smallint, 1000, 0.5, 2)
+FROM generate_series(1,1000) AS i;
+
+SELECT hashset_cardinality(s8), hashset_contains(s8, 4294967296000),
+       hashset_cardinality(s2), s2 @> 1000::smallint,
+       pg_column_size(s8) < 8 * 1000, pg_column_size(s2) < 2 * 1000
+FROM integer_types_test WHERE i = 0;
+
+SELECT count(*)
+FROM (SELECT s8, lag(s8) OVER (ORDER BY s8) AS prev FROM integer_types_test) AS x
+WHERE prev > s8;
+
+/*
+ * Statistics and the planner support functions
+ */
+CREATE OR REPLACE FUNCTION explain_rows(query text)
+RETURNS float8
+AS $$
+DECLARE
+    plan json;
+BEGIN
+    EXECUTE 'EXPLAIN (FORMAT JSON) ' || query INTO plan;
+    RETURN plan->0->'Plan'->>'Plan Rows';
+END;
+$$ LANGUAGE plpgsql;
+
+ANALYZE integer_types_test;
+
+SELECT attname, most_common_elems IS NOT NULL FROM pg_stats
+WHERE tablename = 'integer_types_test' AND attname IN ('s8', 's2')
+ORDER BY attname;
+
+SELECT explain_rows($$SELECT * FROM integer_types_test WHERE s8 @> 0::bigint$$)
+         > explain_rows($$SELECT * FROM integer_types_test WHERE s8 @> '{5000000000}'$$),
+       explain_rows($$SELECT * FROM integer_types_test WHERE s2 && '{0}'$$)
+         > explain_rows($$SELECT * FROM integer_types_test WHERE s2 && '{100}'$$);
+
+SELECT count(*) FROM integer_types_test
+WHERE hashset_contains('{1,2,3,NULL}'::int8hashset, i::bigint);
+
+DROP TABLE integer_types_test;
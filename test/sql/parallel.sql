@@ -0,0 +1,42 @@
+/*
+ * Parallel aggregation
+ *
+ * hashset_agg() has serialize/deserialize functions, so the planner can use
+ * partial aggregation in parallel workers.
+ */
+CREATE TABLE hashset_parallel_test AS
+    SELECT i, (i % 1000) AS j, int4hashset() || i || (i + 1) AS h
+    FROM generate_series(1,100000) s(i);
+ANALYZE hashset_parallel_test;
+
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+
+EXPLAIN (COSTS OFF) SELECT hashset_agg(i) FROM hashset_parallel_test;
+EXPLAIN (COSTS OFF) SELECT hashset_agg(h) FROM hashset_parallel_test;
+
+SELECT
+    hashset_cardinality(hashset_agg(i)),
+    hashset_cardinality(hashset_agg(j)),
+    hashset_cardinality(hashset_agg(h))
+FROM hashset_parallel_test;
+
+SELECT hashset_agg(j) = (SELECT hashset_agg(g) FROM generate_series(0,999) g)
+FROM hashset_parallel_test;
+
+SELECT
+    j % 3 AS g,
+    hashset_cardinality(hashset_agg(i)) AS i,
+    hashset_cardinality(hashset_agg(j)) AS j
+FROM hashset_parallel_test
+GROUP BY 1
+ORDER BY 1;
+
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+
+DROP TABLE hashset_parallel_test;
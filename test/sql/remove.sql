@@ -0,0 +1,59 @@
+/*
+ * Removing elements
+ *
+ * Removed elements leave tombstones in full groups of the hash table, and
+ * the table shrinks once it's mostly empty.
+ */
+SELECT hashset_remove('{1,2,3}', 2);
+SELECT hashset_remove('{1,2,3}', 4);
+SELECT hashset_remove('{1,NULL}', NULL::int);
+SELECT hashset_remove(NULL, 1);
+SELECT '{1,2,3}'::int4hashset - 1;
+SELECT '{1,2,3,NULL}'::int4hashset - ARRAY[1,3,NULL,5];
+SELECT hashset_remove('{1,2,3}', '{}'::int[]);
+SELECT hashset_remove(hashset_remove('{1,2}', 1), 2) = '{}';
+
+WITH t AS (
+    SELECT hashset_remove(hashset_from_array(array(SELECT generate_series(1,10000))),
+                          array(SELECT generate_series(1,10000,2))) AS s
+)
+SELECT hashset_cardinality(s), hashset_capacity(s),
+       (SELECT count(*) FROM generate_series(1,10000) AS i WHERE hashset_contains(s, i))
+FROM t;
+
+-- shrinks once the elements take less than a quarter of the space
+WITH t AS (
+    SELECT hashset_remove(hashset_from_array(array(SELECT generate_series(1,1000))),
+                          array(SELECT generate_series(11,1000))) AS s
+)
+SELECT hashset_cardinality(s), hashset_capacity(s), hashset_capacity(hashset_compact(s)),
+       hashset_to_sorted_array(hashset_compact(s))
+FROM t;
+
+-- a sliding window, the tombstones must not make the table grow forever
+CREATE OR REPLACE FUNCTION hashset_window(n int, w int)
+RETURNS int4hashset AS
+$$
+DECLARE
+    s int4hashset := int4hashset();
+BEGIN
+    FOR i IN 1..n LOOP
+        s := hashset_add(s, i);
+        s := s - (i - w);
+    END LOOP;
+    RETURN s;
+END;
+$$ LANGUAGE plpgsql;
+
+SELECT hashset_cardinality(s), hashset_capacity(s) <= 512,
+       hashset_to_sorted_array(s) = array(SELECT generate_series(19901,20000))
+FROM hashset_window(20000, 100) AS s;
+
+-- the element hash stored in the header is kept up to date by removals
+SELECT hashset_hash(hashset_remove('{1,2,3}'::int4hashset, 2)) = hashset_hash('{1,3}'::int4hashset),
+       hashset_hash_extended(hashset_remove('{1,2,3}'::int4hashset, ARRAY[2,4]), 7) =
+       hashset_hash_extended('{1,3}'::int4hashset, 7),
+       hashset_hash(s) = hashset_hash(hashset_from_array(array(SELECT generate_series(19901,20000))))
+FROM hashset_window(20000, 100) AS s;
+
+DROP FUNCTION hashset_window(int, int);
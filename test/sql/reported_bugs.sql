@@ -43,11 +43,11 @@ FROM
 SELECT hashset_hash('{1,2}'::int4hashset);
 SELECT hashset_hash('{2,1}'::int4hashset);
 
-SELECT hashset_cmp('{1,2}','{2,1}')
+SELECT hashset_cmp('{1,2}'::int4hashset,'{2,1}')
 UNION
-SELECT hashset_cmp('{1,2}','{1,2,1}')
+SELECT hashset_cmp('{1,2}'::int4hashset,'{1,2,1}')
 UNION
-SELECT hashset_cmp('{1,2}','{1,2}');
+SELECT hashset_cmp('{1,2}'::int4hashset,'{1,2}');
 
 /*
  * Bug in int4hashset_resize() not utilizing growth_factor.
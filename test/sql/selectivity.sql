@@ -0,0 +1,66 @@
+CREATE OR REPLACE FUNCTION explain_rows(query text)
+RETURNS float8
+AS $$
+DECLARE
+    plan json;
+BEGIN
+    EXECUTE 'EXPLAIN (FORMAT JSON) ' || query INTO plan;
+    RETURN plan->0->'Plan'->>'Plan Rows';
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TABLE hashset_sel_test AS
+SELECT i, hashset_from_array(ARRAY[i % 1000, i % 997, i % 991]) AS s
+FROM generate_series(1,10000) AS i;
+
+ANALYZE hashset_sel_test;
+
+/*
+ * Containing more elements is less likely, overlapping with (or being
+ * contained in) more elements is more likely
+ */
+SELECT explain_rows($$SELECT * FROM hashset_sel_test WHERE s @> '{1}'$$)
+         > explain_rows($$SELECT * FROM hashset_sel_test WHERE s @> '{1,2}'$$),
+       explain_rows($$SELECT * FROM hashset_sel_test WHERE s && '{1}'$$)
+         < explain_rows($$SELECT * FROM hashset_sel_test WHERE s && '{1,2,3,4,5}'$$),
+       explain_rows($$SELECT * FROM hashset_sel_test WHERE s <@ '{1,2,3}'$$)
+         < explain_rows(format($$SELECT * FROM hashset_sel_test WHERE s <@ %L$$,
+                               hashset_from_array(ARRAY(SELECT generate_series(1,1000))))),
+       explain_rows($$SELECT * FROM hashset_sel_test WHERE '{1}' <@ s$$)
+         = explain_rows($$SELECT * FROM hashset_sel_test WHERE s @> '{1}'$$);
+
+/*
+ * Nothing overlaps an empty set, an integer column matches as many rows as
+ * there are elements (for a unique column)
+ */
+SELECT explain_rows($$SELECT * FROM hashset_sel_test WHERE s && '{}'$$),
+       explain_rows($$SELECT * FROM hashset_sel_test WHERE '{1,2,3}' @> i$$);
+
+/*
+ * Joins on element containment are estimated using the number of distinct
+ * values of the integer column, not as a cross join
+ */
+SELECT explain_rows($$SELECT * FROM hashset_sel_test a JOIN hashset_sel_test b ON a.s @> b.i$$)
+         < 10000 * 10000 * 0.01;
+
+DROP TABLE hashset_sel_test;
+
+/*
+ * Element statistics (skewed elements)
+ */
+CREATE TABLE hashset_sel_skew AS
+SELECT i, hashset_from_array(ARRAY[0, i % 10, i]) AS s
+FROM generate_series(1,10000) AS i;
+
+ANALYZE hashset_sel_skew;
+
+SELECT most_common_elems FROM pg_stats
+WHERE tablename = 'hashset_sel_skew' AND attname = 's';
+
+SELECT explain_rows($$SELECT * FROM hashset_sel_skew WHERE s @> '{0}'$$),
+       explain_rows($$SELECT * FROM hashset_sel_skew WHERE s @> 0$$),
+       explain_rows($$SELECT * FROM hashset_sel_skew WHERE s @> '{5}'$$) BETWEEN 900 AND 1100,
+       explain_rows($$SELECT * FROM hashset_sel_skew WHERE s @> '{5000}'$$) < 100,
+       explain_rows($$SELECT * FROM hashset_sel_skew WHERE s && '{5000,0}'$$);
+
+DROP TABLE hashset_sel_skew;
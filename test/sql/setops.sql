@@ -0,0 +1,78 @@
+/*
+ * Set operations on hash tables (results of aggregates), skewed sizes
+ */
+SELECT hashset_intersection(hashset_agg(i), hashset_agg(i) FILTER (WHERE i % 7 = 1))
+         = hashset_agg(i) FILTER (WHERE i % 7 = 1),
+       hashset_intersection(hashset_agg(i) FILTER (WHERE i < 4), hashset_agg(i))
+         = hashset_agg(i) FILTER (WHERE i < 4),
+       hashset_difference(hashset_agg(i), hashset_agg(i) FILTER (WHERE i % 7 = 1))
+         = hashset_agg(i) FILTER (WHERE i % 7 <> 1),
+       hashset_difference(hashset_agg(i) FILTER (WHERE i < 4), hashset_agg(i) FILTER (WHERE i > 2))
+         = hashset_agg(i) FILTER (WHERE i < 3),
+       hashset_symmetric_difference(hashset_agg(i) FILTER (WHERE i % 3 = 0), hashset_agg(i) FILTER (WHERE i % 2 = 0))
+         = hashset_agg(i) FILTER (WHERE (i % 3 = 0) <> (i % 2 = 0))
+FROM generate_series(1,10000) AS i;
+
+/*
+ * Hash tables with different hash functions
+ */
+SELECT hashset_intersection(hashset_union(int4hashset(hashfn_id := 2), hashset_agg(i)),
+                            hashset_union(int4hashset(hashfn_id := 2), hashset_agg(i) FILTER (WHERE i % 5 = 0)))
+         = hashset_agg(i) FILTER (WHERE i % 5 = 0),
+       hashset_intersection(hashset_union(int4hashset(hashfn_id := 3), hashset_agg(i)),
+                            hashset_agg(i) FILTER (WHERE i % 5 = 0))
+         = hashset_agg(i) FILTER (WHERE i % 5 = 0),
+       hashset_symmetric_difference(hashset_union(int4hashset(hashfn_id := 3), hashset_agg(i) FILTER (WHERE i < 600)),
+                                    hashset_union(int4hashset(hashfn_id := 3), hashset_agg(i) FILTER (WHERE i > 400)))
+         = hashset_agg(i) FILTER (WHERE i <= 400 OR i >= 600)
+FROM generate_series(1,1000) AS i;
+
+/*
+ * Compact sets, and compact sets combined with hash tables
+ */
+SELECT hashset_intersection('{1,2,3,5}'::int4hashset, '{2,3,4}'),
+       hashset_difference('{1,2,3,5}'::int4hashset, '{2,3,4}'),
+       hashset_symmetric_difference('{1,2,3,5}'::int4hashset, '{2,3,4}');
+
+WITH c AS MATERIALIZED (SELECT hashset_agg(i) AS s FROM generate_series(1,1000) AS i)
+SELECT hashset_intersection(s, hashset_add('{0,2000}', 500)),
+       hashset_intersection(hashset_add('{0,2000}', 500), s),
+       hashset_difference(hashset_add('{0,2000}', 500), s),
+       hashset_cardinality(hashset_difference(s, hashset_add('{0,2000}', 500))),
+       hashset_cardinality(hashset_symmetric_difference(s, hashset_add('{0,2000}', 500)))
+FROM c;
+
+/*
+ * Union and aggregation of sets of different sizes, merging the smaller
+ * set into the larger one
+ */
+SELECT hashset_union(hashset_agg(i) FILTER (WHERE i < 3), hashset_agg(i)) = hashset_agg(i),
+       hashset_union(hashset_agg(i), hashset_agg(i) FILTER (WHERE i < 3)) = hashset_agg(i),
+       hashset_cardinality(hashset_union('{1,NULL}', hashset_agg(i)))
+FROM generate_series(1,1000) AS i;
+
+SELECT hashset_agg(s) = (SELECT hashset_agg(i) FROM generate_series(1,1000) AS i),
+       hashset_cardinality(hashset_agg(s))
+FROM (VALUES ('{1,2}'::int4hashset),
+             ((SELECT hashset_agg(i) FROM generate_series(1,1000) AS i)),
+             ('{999,1000,NULL}')) AS v(s);
+
+/*
+ * Containment and overlap, on all combinations of hash tables and compact
+ * sets (including the cardinality shortcuts)
+ */
+WITH sets AS (
+    SELECT hashset_agg(i) AS t,
+           hashset_agg(i)::text::int4hashset AS c,
+           hashset_agg(i) FILTER (WHERE i % 2 = 0) AS t2,
+           (hashset_agg(i) FILTER (WHERE i % 2 = 0))::text::int4hashset AS c2,
+           hashset_agg(i) FILTER (WHERE i % 2 = 1) AS t3,
+           (hashset_agg(i) FILTER (WHERE i % 2 = 1))::text::int4hashset AS c3
+    FROM generate_series(1,1000) AS i
+)
+SELECT t @> t2, t @> c2, c @> t2, c @> c2,
+       t2 @> t, c2 @> c,
+       hashset_add(t2, 1001) <@ c, hashset_add(t2, 1001)::text::int4hashset <@ c,
+       t2 && t3, c2 && c3, t2 && c3, c2 && t3,
+       t && c2, c && t2, c2 && c, c && c
+FROM sets;
@@ -0,0 +1,65 @@
+CREATE TABLE hashset_sort_test AS
+SELECT i, hashset_agg(j) AS s
+FROM generate_series(1,1000) AS i, generate_series(0, i % 7) AS j
+GROUP BY i;
+
+/*
+ * Sorting (with abbreviated keys) agrees with the comparison operators
+ */
+SELECT count(*)
+FROM (SELECT s, lag(s) OVER (ORDER BY s) AS prev FROM hashset_sort_test) AS x
+WHERE prev > s;
+
+SET enable_hashagg = off;
+
+SELECT count(*), count(DISTINCT s) FROM hashset_sort_test;
+
+SELECT hashset_cardinality(s), count(*) FROM hashset_sort_test GROUP BY s ORDER BY 1;
+
+RESET enable_hashagg;
+
+/*
+ * Compact sets compare equal to the same hash tables
+ */
+SELECT count(*)
+FROM hashset_sort_test AS t
+WHERE hashset_cmp(t.s, (SELECT hashset_agg(j) FROM generate_series(0, t.i % 7) AS j)) <> 0;
+
+/*
+ * The NULL element is part of the order
+ */
+SELECT hashset_cmp('{1,2}'::int4hashset, '{1,2}'),
+       hashset_cmp('{1,2}'::int4hashset, '{1,2,NULL}') <> 0,
+       hashset_cmp('{1,2,NULL}'::int4hashset, '{1,2}') = -hashset_cmp('{1,2}'::int4hashset, '{1,2,NULL}'),
+       hashset_cmp(hashset_add(hashset_add(int4hashset(), 2), 1), '{1,2}');
+
+/*
+ * Btree index build and lookups
+ */
+CREATE INDEX ON hashset_sort_test (s);
+
+SET enable_seqscan = off;
+
+SELECT count(*) FROM hashset_sort_test WHERE s = '{2,1,0}';
+
+SELECT count(*) FROM hashset_sort_test WHERE s <= '{0}' AND s >= '{0}';
+
+RESET enable_seqscan;
+
+DROP TABLE hashset_sort_test;
+
+/*
+ * Mostly equal sets abort the abbreviation, which must not break the sort
+ */
+CREATE TABLE hashset_sort_dups AS
+SELECT i, hashset_agg(j) AS s
+FROM generate_series(1,20000) AS i, generate_series(0, i % 3) AS j
+GROUP BY i;
+
+SELECT count(*), count(DISTINCT s) FROM hashset_sort_dups;
+
+SELECT count(*)
+FROM (SELECT s, lag(s) OVER (ORDER BY s) AS prev FROM hashset_sort_dups) AS x
+WHERE prev > s;
+
+DROP TABLE hashset_sort_dups;
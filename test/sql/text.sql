@@ -0,0 +1,62 @@
+/*
+ * texthashset (same text format as text[] arrays)
+ */
+SELECT '{b,a,"with space",NULL,a}'::texthashset;
+SELECT '{"a,b","q\"uote","","NULL"}'::texthashset,
+       hashset_cardinality('{"a,b","q\"uote","","NULL"}'::texthashset);
+SELECT '{}'::texthashset, hashset_cardinality('{}'::texthashset);
+SELECT 'x'::texthashset;
+
+/*
+ * Adding elements and containment
+ */
+SELECT hashset_add('{a}'::texthashset, 'b'),
+       hashset_add('{a}'::texthashset, 'a'),
+       hashset_add('{a}'::texthashset, NULL),
+       hashset_add(NULL::texthashset, 'c'),
+       '{a}'::texthashset || 'b';
+
+SELECT hashset_contains('{a,b}'::texthashset, 'b'),
+       hashset_contains('{a,b}'::texthashset, 'c'),
+       hashset_contains('{a,NULL}'::texthashset, 'c'),
+       hashset_contains('{}'::texthashset, NULL),
+       '{a,b}'::texthashset @> 'a',
+       hashset_contains('{a}'::texthashset, 'a' COLLATE "C");
+
+CREATE TABLE texthashset_test (id int, s texthashset);
+INSERT INTO texthashset_test
+SELECT i, hashset_agg('k' || j) FROM generate_series(1,10) AS i, generate_series(1,i) AS j GROUP BY i;
+
+SELECT id, hashset_cardinality(s), hashset_contains(s, 'k5') FROM texthashset_test ORDER BY id;
+
+/*
+ * Union, comparisons and arrays
+ */
+SELECT hashset_union('{a,b}'::texthashset, '{b,c,NULL}');
+
+SELECT '{a,b}'::texthashset = '{b,a}', '{a,b}'::texthashset = '{a}',
+       '{a,b}'::texthashset <> '{a,c}',
+       hashset_hash('{a,b}'::texthashset) = hashset_hash('{b,a}'::texthashset);
+
+SELECT hashset_to_sorted_array('{b,a,NULL}'::texthashset),
+       '{x,y,x}'::text[]::texthashset,
+       texthashset_from_array('{}');
+
+SELECT x FROM hashset_elements('{b,a,c}'::texthashset) AS x ORDER BY x;
+
+SELECT hashset_capacity(texthashset(100)),
+       hashset_capacity(hashset_add(texthashset(), 'a'));
+
+/*
+ * Aggregates
+ */
+SELECT hashset_cardinality(hashset_agg('user-' || (i % 1000))),
+       hashset_cardinality(hashset_agg(md5(i::text)))
+FROM generate_series(1,10000) AS i;
+
+SELECT hashset_agg('k' || (i % 100)) = texthashset_from_array(array_agg(DISTINCT 'k' || (i % 100)))
+FROM generate_series(1,1000) AS i;
+
+SELECT hashset_agg(s) FROM texthashset_test;
+
+DROP TABLE texthashset_test;
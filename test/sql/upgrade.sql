@@ -0,0 +1,27 @@
+/*
+ * Upgrade from the 0.0.1 release (drops everything created by the other
+ * tests, so this has to be the last one)
+ */
+SET client_min_messages = warning;
+DROP EXTENSION hashset CASCADE;
+RESET client_min_messages;
+
+CREATE EXTENSION hashset VERSION '0.0.1';
+
+CREATE TABLE hashset_upgrade_test (id int, s int4hashset);
+INSERT INTO hashset_upgrade_test VALUES (1, '{1,2,3}'), (2, '{3,4,5}');
+
+ALTER EXTENSION hashset UPDATE TO '0.0.2';
+
+SELECT extversion FROM pg_extension WHERE extname = 'hashset';
+
+SELECT typstorage, typanalyze FROM pg_type WHERE typname = 'int4hashset';
+
+SELECT id, hashset_to_sorted_array(hashset_add(s, 6)), hashset_contains(s, 3)
+FROM hashset_upgrade_test ORDER BY id;
+
+SELECT hashset_to_sorted_array(hashset_agg(s)) FROM hashset_upgrade_test;
+
+SELECT hashset_to_sorted_array(hashset_agg(i::bigint)) FROM generate_series(1,3) s(i);
+
+DROP TABLE hashset_upgrade_test;